@@ -0,0 +1,71 @@
+#include "benchmark_support.hpp"
+#include "organizer.hpp"
+
+#include <cstdio>
+
+/*
+    =========================================================
+        determinism: cost of deterministic numbering
+    =========================================================
+
+    Parallel destination-ordered runs with deterministic numbering
+    (one worker per destination folder) against the shared collision
+    registry (numbering in thread-timing order), on two trees:
+
+    - spread: files go to 8 category folders
+    - skewed: every file goes to the same folder
+
+    Every file name exists in every source folder, so most moves
+    collide and get numbered. A fresh tree per run; median of --runs.
+*/
+static double timed_run(const benchmark_args& args, std::size_t categories, unsigned threads, bool deterministic)
+{
+    std::size_t files = args.number("files", 50000);
+    std::size_t folders = args.number("folders", 50);
+
+    scratch_tree tree(args);
+    make_flat_tree(tree.path(), folders, files / folders, categories);
+
+    organize_options options;
+    options.order = execution_order::destination_order;
+    options.execution_threads = threads;
+    options.deterministic_collisions = deterministic;
+
+    std::uint64_t start = now_ns();
+    organize_status status = organize_directory(tree.path().string(), transfer_mode::atomic_transfer_mode, options);
+    double seconds = seconds_since(start);
+
+    return status == organize_status::success ? seconds : -1.0;
+}
+
+BENCHMARK(determinism, "--files 50000 --folders 50 --threads 4 --runs 3")
+{
+    unsigned threads = static_cast<unsigned>(args.number("threads", 4));
+    std::size_t runs = args.number("runs", 3);
+
+    const std::size_t CATEGORY_COUNTS[] = {8, 1};
+    for (std::size_t categories : CATEGORY_COUNTS)
+    {
+        for (bool deterministic : {true, false})
+        {
+            std::vector<double> samples;
+            for (std::size_t run = 0; run < runs; run++)
+            {
+                double seconds = timed_run(args, categories, threads, deterministic);
+                if (seconds < 0)
+                {
+                    std::printf("run failed\n");
+                    return 1;
+                }
+                samples.push_back(seconds);
+            }
+
+            double middle = median(samples);    // Sorts samples
+            std::printf("%s, %u thread(s), %s: median %.2f s (%.2f-%.2f s over %zu runs)\n",
+                        categories == 1 ? "skewed" : "spread", threads,
+                        deterministic ? "deterministic" : "shared registry",
+                        middle, samples.front(), samples.back(), runs);
+        }
+    }
+    return 0;
+}
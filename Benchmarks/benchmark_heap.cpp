@@ -0,0 +1,44 @@
+#include "benchmark_support.hpp"
+#include "organizer.hpp"
+
+#include <cstdio>
+
+/*
+    =========================================================
+        heap: destination-ordered run under a heap target
+    =========================================================
+
+    One configuration per invocation (peak RSS is per process):
+
+        for target in 0 64 32 16; do
+            ./organizer_benchmarks heap --dir /dev/shm --target-mib $target
+        done
+*/
+BENCHMARK(heap, "--files 200000 --folders 200 --target-mib 0 --threads 1 --deterministic 0")
+{
+    std::size_t files = args.number("files", 200000);
+    std::size_t folders = args.number("folders", 200);
+    std::size_t target_mib = args.number("target-mib", 0);
+
+    scratch_tree tree(args);
+    make_flat_tree(tree.path(), folders, files / folders);
+    double rss_before = peak_rss_mib();
+
+    organize_options options;
+    options.order = execution_order::destination_order;
+    options.heap_target = target_mib * 1024 * 1024;
+    options.execution_threads = static_cast<unsigned>(args.number("threads", 1));
+    options.deterministic_collisions = args.number("deterministic", 0) != 0;
+
+    std::uint64_t start = now_ns();
+    organize_status status = organize_directory(tree.path().string(), transfer_mode::atomic_transfer_mode, options);
+    double seconds = seconds_since(start);
+
+    std::printf("heap target %s, %u thread(s)%s: %.2f s, peak RSS %.0f MiB (%.0f MiB before the run)\n",
+                target_mib == 0 ? "unlimited" : (std::to_string(target_mib) + " MiB").c_str(),
+                options.execution_threads,
+                options.execution_threads > 1 ? (options.deterministic_collisions ? " deterministic" : " shared registry") : "",
+                seconds, peak_rss_mib(), rss_before);
+
+    return status == organize_status::success ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#include "benchmark_support.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+/*
+    =========================================================
+        Registration and arguments
+    =========================================================
+*/
+std::vector<benchmark>& registered_benchmarks()
+{
+    static std::vector<benchmark> benchmarks;
+    return benchmarks;
+}
+
+benchmark_registration::benchmark_registration(const char* name, const char* usage, int (*run)(const benchmark_args& args))
+{
+    registered_benchmarks().push_back(benchmark{name, usage, run});
+}
+
+benchmark_args::benchmark_args(int argc, char* argv[])
+{
+    for (int i = 0; i + 1 < argc; i += 2)
+    {
+        if (std::strncmp(argv[i], "--", 2) == 0)
+        {
+            values[argv[i] + 2] = argv[i + 1];
+        }
+    }
+}
+
+std::uint64_t benchmark_args::number(const std::string& name, std::uint64_t fallback) const
+{
+    std::map<std::string, std::string>::const_iterator it = values.find(name);
+    if (it == values.end())
+    {
+        return fallback;
+    }
+
+    char* end = nullptr;
+    unsigned long long value = std::strtoull(it->second.c_str(), &end, 10);
+    return (end == it->second.c_str()) ? fallback : value;
+}
+
+std::string benchmark_args::text(const std::string& name, const std::string& fallback) const
+{
+    std::map<std::string, std::string>::const_iterator it = values.find(name);
+    return it == values.end() ? fallback : it->second;
+}
+
+/*
+    =========================================================
+        scratch_tree
+    =========================================================
+*/
+scratch_tree::scratch_tree(const benchmark_args& args)
+{
+    static std::atomic<unsigned> counter{0};
+
+    std::filesystem::path parent = args.text("dir", std::filesystem::temp_directory_path().string());
+    directory = parent / ("file_organizer_benchmark-" + std::to_string(now_ns()) + "-" + std::to_string(counter++));
+    std::filesystem::create_directories(directory);
+}
+
+scratch_tree::~scratch_tree()
+{
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+}
+
+const std::filesystem::path& scratch_tree::path() const
+{
+    return directory;
+}
+
+/*
+    =========================================================
+        Helpers
+    =========================================================
+*/
+void make_flat_tree(
+    const std::filesystem::path& root,
+    std::size_t folders,
+    std::size_t files_per_folder,
+    std::size_t categories
+    )
+{
+    static const char* EXTENSIONS[] = {"txt", "jpg", "mp3", "pdf", "cpp", "zip", "mp4", "json"};
+    categories = std::clamp<std::size_t>(categories, 1, 8);
+
+    for (std::size_t folder = 0; folder < folders; folder++)
+    {
+        std::filesystem::path folder_path = root / ("d" + std::to_string(folder));
+        std::filesystem::create_directories(folder_path);
+
+        for (std::size_t file = 0; file < files_per_folder; file++)
+        {
+            std::string name = "f" + std::to_string(file) + "." + EXTENSIONS[file % categories];
+            std::ofstream(folder_path / name, std::ios::binary) << folder << '/' << name;
+        }
+    }
+}
+
+std::uint64_t now_ns()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+double seconds_since(std::uint64_t start_ns)
+{
+    return static_cast<double>(now_ns() - start_ns) / 1e9;
+}
+
+double peak_rss_mib()
+{
+#if defined(__APPLE__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);     // Bytes
+#elif defined(__unix__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;                // KiB
+#else
+    return 0.0;
+#endif
+}
+
+double median(std::vector<double>& samples)
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+/*
+    =========================================================
+        main
+    =========================================================
+*/
+int main(int argc, char* argv[])
+{
+    if (argc >= 2)
+    {
+        for (const benchmark& entry : registered_benchmarks())
+        {
+            if (std::strcmp(argv[1], entry.name) == 0)
+            {
+                return entry.run(benchmark_args(argc - 2, argv + 2));
+            }
+        }
+    }
+
+    std::printf("usage: %s <benchmark> [--option value ...] [--dir scratch-parent]\n\n", argv[0]);
+    for (const benchmark& entry : registered_benchmarks())
+    {
+        std::printf("  %-14s %s\n", entry.name, entry.usage);
+    }
+    return 2;
+}
@@ -0,0 +1,123 @@
+#include "benchmark_support.hpp"
+#include "job_priority.hpp"
+#include "organizer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+/*
+    =========================================================
+        priority: interactive runs during a bulk run
+    =========================================================
+
+    Times organize runs of --interactive-files files:
+
+    - alone
+    - while a bulk-class run moves --bulk-files files,
+      as interactive runs (the priority classes at work)
+    - the same, but as bulk runs themselves (no priority: both
+      compete on equal terms)
+
+    Every run gets a fresh tree, built before the timing starts. Only
+    runs that finished while the bulk run was still going are counted.
+*/
+typedef std::vector<std::unique_ptr<scratch_tree>> tree_list;
+
+static tree_list make_trees(const benchmark_args& args, std::size_t count, std::size_t files)
+{
+    tree_list trees;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        trees.push_back(std::make_unique<scratch_tree>(args));
+        make_flat_tree(trees.back()->path(), 10, files / 10);
+    }
+    return trees;
+}
+
+static double timed_run(const scratch_tree& tree, job_priority priority)
+{
+    organize_options options;
+    options.priority = priority;
+
+    std::uint64_t start = now_ns();
+    organize_directory(tree.path().string(), transfer_mode::atomic_transfer_mode, options);
+    return seconds_since(start);
+}
+
+static void print_row(const char* label, std::vector<double>& samples)
+{
+    if (samples.empty())
+    {
+        std::printf("  %-32s no run finished in time (use more --bulk-files)\n", label);
+        return;
+    }
+    double middle = median(samples);    // Sorts samples
+    std::printf("  %-32s median %6.1f ms, worst %6.1f ms (%zu runs)\n",
+                label, middle * 1e3, samples.back() * 1e3, samples.size());
+}
+
+/*
+    Times interactive-sized runs with the given class
+    while a bulk run is in progress.
+*/
+static std::vector<double> during_bulk(const benchmark_args& args, job_priority priority)
+{
+    std::size_t runs = args.number("runs", 15);
+    std::size_t interactive_files = args.number("interactive-files", 1000);
+
+    scratch_tree bulk_tree(args);
+    make_flat_tree(bulk_tree.path(), 300, args.number("bulk-files", 300000) / 300);
+    tree_list trees = make_trees(args, runs, interactive_files);
+
+    std::atomic<bool> bulk_running{true};
+    std::thread bulk([&] {
+        organize_options options;
+        options.priority = job_priority::bulk;
+        options.execution_threads = static_cast<unsigned>(args.number("bulk-threads", 1));
+        organize_directory(bulk_tree.path().string(), transfer_mode::atomic_transfer_mode, options);
+        bulk_running = false;
+    });
+
+    // Let the bulk run get going first
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::vector<double> samples;
+    for (const std::unique_ptr<scratch_tree>& tree : trees)
+    {
+        double seconds = timed_run(*tree, priority);
+        if (!bulk_running)
+        {
+            break;
+        }
+        samples.push_back(seconds);
+    }
+
+    bulk.join();
+    return samples;
+}
+
+BENCHMARK(priority, "--interactive-files 1000 --bulk-files 300000 --bulk-threads 1 --runs 15")
+{
+    std::size_t runs = args.number("runs", 15);
+
+    std::vector<double> alone;
+    for (const std::unique_ptr<scratch_tree>& tree : make_trees(args, runs, args.number("interactive-files", 1000)))
+    {
+        alone.push_back(timed_run(*tree, job_priority::interactive));
+    }
+
+    std::vector<double> as_interactive = during_bulk(args, job_priority::interactive);
+    std::vector<double> as_bulk = during_bulk(args, job_priority::bulk);
+
+    std::printf("%zu-file runs, bulk run of %zu files on %zu thread(s):\n",
+                static_cast<std::size_t>(args.number("interactive-files", 1000)),
+                static_cast<std::size_t>(args.number("bulk-files", 300000)),
+                static_cast<std::size_t>(args.number("bulk-threads", 1)));
+    print_row("alone", alone);
+    print_row("during bulk, interactive class", as_interactive);
+    print_row("during bulk, bulk class", as_bulk);
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "benchmark_support.hpp"
+#include "extensions.hpp"
+#include "run_metrics.hpp"
+#include "scan_batch.hpp"
+
+#include <cstdio>
+#include <string>
+
+/*
+    =========================================================
+        scan: batched scanning against per-entry iteration
+    =========================================================
+
+    Both walks visit the same tree and do what organize_directory
+    does with every entry before deciding anything: tell files from
+    folders, and take each file's name and extension.
+
+    - per-entry:  std::filesystem::directory_iterator, one path string
+                  per entry and is_regular_file / is_directory on the
+                  full path (the organizer before batched scanning)
+    - batched:    directory_scanner filling a reused scan_batch
+
+    The walks alternate, the first (cold) round is dropped, and
+    the median of --runs rounds is reported. Where the kernel exposes
+    hardware counters, each walk's counters are printed as well.
+*/
+
+// Returns the number of files seen
+static std::size_t per_entry_walk(const std::filesystem::path& root, std::size_t& extension_bytes)
+{
+    std::size_t files = 0;
+    std::vector<std::string> directories{root.string()};
+
+    while (!directories.empty())
+    {
+        std::string directory = directories.back();
+        directories.pop_back();
+
+        for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory))
+        {
+            std::string entry_path = entry.path().string();
+            if (std::filesystem::is_regular_file(entry_path))
+            {
+                std::string filename = entry.path().filename().string();
+                extension_bytes += normalize_extension(filename).size();
+                files++;
+            }
+            else if (std::filesystem::is_directory(entry_path))
+            {
+                std::string name = entry.path().filename().string();
+                if (!name.empty() && name[0] != '.')
+                {
+                    directories.push_back(entry_path);
+                }
+            }
+        }
+    }
+    return files;
+}
+
+static std::size_t batched_walk(const std::filesystem::path& root, std::size_t& extension_bytes)
+{
+    std::size_t files = 0;
+    std::vector<std::string> directories{root.string()};
+    scan_batch batch;
+
+    while (!directories.empty())
+    {
+        std::string directory = directories.back();
+        directories.pop_back();
+
+        directory_scanner scanner;
+        if (scanner.open(directory) != scan_status::ok)
+        {
+            continue;
+        }
+
+        while (scanner.next_batch(batch) == scan_status::ok)
+        {
+            for (std::size_t i = 0; i < batch.size(); i++)
+            {
+                if (batch.types[i] == scan_entry_type::regular_file)
+                {
+                    std::string filename(batch.name(i));
+                    extension_bytes += normalize_extension(filename).size();
+                    files++;
+                }
+                else if (batch.types[i] == scan_entry_type::directory)
+                {
+                    std::string_view name = batch.name(i);
+                    if (!name.empty() && name[0] != '.')
+                    {
+                        directories.push_back((std::filesystem::path(directory) / name).string());
+                    }
+                }
+            }
+        }
+    }
+    return files;
+}
+
+/*
+    One timed walk. With counters, they are printed as the
+    metrics JSON of a run consisting of that walk only.
+*/
+static double timed_walk(
+    std::size_t (*walk)(const std::filesystem::path&, std::size_t&),
+    const std::filesystem::path& root,
+    bool print_counters,
+    const char* label
+    )
+{
+    run_metrics metrics(true);
+    metrics.enter_phase(run_phase::scan);
+
+    std::size_t extension_bytes = 0;
+    std::uint64_t start = now_ns();
+    std::size_t files = walk(root, extension_bytes);
+    double seconds = seconds_since(start);
+
+    metrics.sample_counters();
+    metrics.add_scanned_entries(files);
+    metrics.enter_phase(run_phase::none);
+
+    if (print_counters && metrics.hardware_counters_available())
+    {
+        std::printf("%s counters: %s\n", label, metrics.to_json().c_str());
+    }
+    return seconds;
+}
+
+BENCHMARK(scan, "--files 100000 --folders 100 --runs 7")
+{
+    std::size_t files = args.number("files", 100000);
+    std::size_t folders = args.number("folders", 100);
+    std::size_t runs = args.number("runs", 7);
+
+    scratch_tree tree(args);
+    make_flat_tree(tree.path(), folders, files / folders);
+
+    // Cold round: fills the dentry and inode caches for both
+    timed_walk(per_entry_walk, tree.path(), false, "per-entry");
+    timed_walk(batched_walk, tree.path(), false, "batched");
+
+    std::vector<double> per_entry;
+    std::vector<double> batched;
+    for (std::size_t run = 0; run < runs; run++)
+    {
+        bool last = (run + 1 == runs);
+        per_entry.push_back(timed_walk(per_entry_walk, tree.path(), last, "per-entry"));
+        batched.push_back(timed_walk(batched_walk, tree.path(), last, "batched"));
+    }
+
+    double per_entry_median = median(per_entry);
+    double batched_median = median(batched);
+
+    std::printf("%zu files in %zu folders, median of %zu runs:\n", files, folders, runs);
+    std::printf("  per-entry: %.1f ms (%.1f-%.1f)\n", per_entry_median * 1e3, per_entry.front() * 1e3, per_entry.back() * 1e3);
+    std::printf("  batched:   %.1f ms (%.1f-%.1f)\n", batched_median * 1e3, batched.front() * 1e3, batched.back() * 1e3);
+
+    // The reason is only part of the metrics JSON
+    run_metrics probe(true);
+    if (!probe.hardware_counters_available())
+    {
+        std::string json = probe.to_json();
+        std::string::size_type reason = json.find("\"reason\": \"");
+        std::string text = (reason == std::string::npos)
+            ? std::string("unknown reason")
+            : json.substr(reason + 11, json.find('"', reason + 11) - (reason + 11));
+        std::printf("  hardware counters unavailable: %s\n", text.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+    ===============================
+        benchmark_support.hpp
+    ===============================
+
+    Driver for the measurements in README.md ("Measurements").
+
+    Like the tests, the benchmarks use the organizer core only, with
+    nothing but the C++ standard library. One binary, one subcommand
+    per measurement:
+
+        ./organizer_benchmarks <benchmark> [--option value ...]
+
+    Every benchmark builds its own scratch tree (under --dir, default
+    the system temp directory; tmpfs keeps the disk out of the
+    numbers), prints one line per configuration, and removes the tree.
+
+    Peak RSS is per process, so benchmarks that report it measure one
+    configuration per invocation; the README lists the loops used.
+
+    Writing a benchmark:
+
+        BENCHMARK(heap, "--files N --target-mib M ...")
+        {
+            scratch_tree tree(args);
+            ...
+            return 0;
+        }
+*/
+
+
+/*
+    benchmark_args
+    --------------
+    "--name value" pairs of the command line.
+*/
+class benchmark_args
+{
+public:
+    benchmark_args(int argc, char* argv[]);
+
+    // Value of --name, or fallback when absent or not a number
+    std::uint64_t number(const std::string& name, std::uint64_t fallback) const;
+    std::string text(const std::string& name, const std::string& fallback) const;
+
+private:
+    std::map<std::string, std::string> values;
+};
+
+
+struct benchmark
+{
+    const char* name;
+    const char* usage;
+    int (*run)(const benchmark_args& args);
+};
+
+// Every BENCHMARK of the binary, in registration order
+std::vector<benchmark>& registered_benchmarks();
+
+struct benchmark_registration
+{
+    benchmark_registration(const char* name, const char* usage, int (*run)(const benchmark_args& args));
+};
+
+#define BENCHMARK(name, usage)                                                  \
+    static int name(const benchmark_args& args);                                \
+    static benchmark_registration name##_registration(#name, usage, name);      \
+    static int name(const benchmark_args& args)
+
+
+/*
+    scratch_tree
+    ------------
+    Fresh directory under --dir, removed with everything
+    in it when the object goes away.
+*/
+class scratch_tree
+{
+public:
+    explicit scratch_tree(const benchmark_args& args);
+    ~scratch_tree();
+
+    scratch_tree(const scratch_tree&) = delete;
+    scratch_tree& operator=(const scratch_tree&) = delete;
+
+    const std::filesystem::path& path() const;
+
+private:
+    std::filesystem::path directory;
+};
+
+
+/*
+    Writes folders × files_per_folder small files with unique contents
+    into root/d<n>/, cycling through the extensions of `categories`
+    categories (1 to 8): with 1, every file goes to the same folder.
+*/
+void make_flat_tree(
+    const std::filesystem::path& root,
+    std::size_t folders,
+    std::size_t files_per_folder,
+    std::size_t categories = 8
+);
+
+// Seconds since start (steady clock)
+double seconds_since(std::uint64_t start_ns);
+std::uint64_t now_ns();
+
+// Peak resident set size of this process in MiB (0 if unknown)
+double peak_rss_mib();
+
+// Median of the samples (sorted in place)
+double median(std::vector<double>& samples);
@@ -0,0 +1,47 @@
+# Measurement driver for the README's "Measurements" section
+#
+#   cd Benchmarks && qmake && make && ./organizer_benchmarks
+
+TEMPLATE = app
+TARGET = organizer_benchmarks
+
+CONFIG += console c++23 release
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += ../Headers
+
+SOURCES += \
+    ../Sources/archive_explode.cpp \
+    ../Sources/category_shards.cpp \
+    ../Sources/cold_tier.cpp \
+    ../Sources/content_hash_cache.cpp \
+    ../Sources/decision_queue.cpp \
+    ../Sources/directory_index.cpp \
+    ../Sources/extensions.cpp \
+    ../Sources/fanotify_watcher.cpp \
+    ../Sources/filename_sanitizer.cpp \
+    ../Sources/filesystem_utils.cpp \
+    ../Sources/job_priority.cpp \
+    ../Sources/layout_learner.cpp \
+    ../Sources/memory_governor.cpp \
+    ../Sources/move_hook.cpp \
+    ../Sources/move_plan.cpp \
+    ../Sources/organizer.cpp \
+    ../Sources/partitioned_scan.cpp \
+    ../Sources/resumable_copy.cpp \
+    ../Sources/rule_simulator.cpp \
+    ../Sources/run_estimator.cpp \
+    ../Sources/run_metrics.cpp \
+    ../Sources/scan_batch.cpp \
+    ../Sources/tree_snapshot.cpp \
+    benchmark_determinism.cpp \
+    benchmark_heap.cpp \
+    benchmark_main.cpp \
+    benchmark_priority.cpp \
+    benchmark_scan.cpp
+
+HEADERS += \
+    benchmark_support.hpp
+
+# zlib: gzip and zip inflation (archive_explode.cpp)
+unix: LIBS += -lz -lpthread
@@ -11,19 +11,65 @@ CONFIG += c++23
 RC_FILE = appicon.rc
 
 SOURCES += \
+    Sources/archive_explode.cpp \
+    Sources/category_shards.cpp \
+    Sources/cold_tier.cpp \
+    Sources/content_hash_cache.cpp \
+    Sources/decision_queue.cpp \
+    Sources/directory_index.cpp \
     Sources/extensions.cpp \
+    Sources/fanotify_watcher.cpp \
+    Sources/filename_sanitizer.cpp \
     Sources/filesystem_utils.cpp \
+    Sources/job_priority.cpp \
+    Sources/layout_learner.cpp \
     Sources/main.cpp \
     Sources/mainwindow.cpp \
-    Sources/organizer.cpp
+    Sources/memory_governor.cpp \
+    Sources/move_hook.cpp \
+    Sources/move_plan.cpp \
+    Sources/organizer.cpp \
+    Sources/partitioned_scan.cpp \
+    Sources/resumable_copy.cpp \
+    Sources/rule_simulator.cpp \
+    Sources/run_estimator.cpp \
+    Sources/run_metrics.cpp \
+    Sources/scan_batch.cpp \
+    Sources/thumbnail_cache.cpp \
+    Sources/tree_snapshot.cpp
 
 INCLUDEPATH += headers
 
+# zlib: gzip and zip inflation (archive_explode.cpp)
+unix: LIBS += -lz
+
 HEADERS += \
+    Headers/archive_explode.hpp \
+    Headers/category_shards.hpp \
+    Headers/cold_tier.hpp \
+    Headers/content_hash_cache.hpp \
+    Headers/decision_queue.hpp \
+    Headers/directory_index.hpp \
     Headers/extensions.hpp \
+    Headers/fanotify_watcher.hpp \
+    Headers/filename_sanitizer.hpp \
     Headers/filesystem_utils.hpp \
+    Headers/job_priority.hpp \
+    Headers/layout_learner.hpp \
     Headers/mainwindow.h \
-    Headers/organizer.hpp
+    Headers/memory_governor.hpp \
+    Headers/move_hook.hpp \
+    Headers/move_plan.hpp \
+    Headers/organizer.hpp \
+    Headers/partitioned_scan.hpp \
+    Headers/resumable_copy.hpp \
+    Headers/rule_simulator.hpp \
+    Headers/run_estimator.hpp \
+    Headers/run_metrics.hpp \
+    Headers/scan_batch.hpp \
+    Headers/thumbnail_cache.hpp \
+    Headers/tree_snapshot.hpp \
+    Headers/work_queue.hpp
 
 FORMS += \
     Forms/mainwindow.ui
@@ -0,0 +1,119 @@
+#pragma once
+#include "organizer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+/*
+    ===============================
+        archive_explode.hpp
+    ===============================
+
+    Unpacks an archive straight into the category folders its members
+    belong in.
+
+    WHY THIS EXISTS:
+    ----------------
+    Ingest folders receive large .zip / .tar.gz drops. Organizing them
+    as-is only files the drop under "Archive Files". Extracting first
+    and organizing afterwards writes every byte twice (once into the
+    extraction folder, once more if the move crosses a device) and
+    needs room for a second copy of the whole archive.
+
+    HOW IT WORKS:
+    -------------
+    - The format is recognized by its first bytes, not its name
+    - Members are decompressed as a stream and written directly to a
+      temporary name inside the destination category folder, then
+      renamed to their final (collision-free) name. There is no
+      extraction folder: every byte is written once
+    - The destination is chosen by the same placement decision as a
+      normal run (plan_placement): sanitized name, extension category,
+      learned routes. Folders inside the archive are not recreated;
+      a member goes where a loose file of that name would go
+    - zip: the central directory is read first, then each member is
+      read (stored, or inflated with zlib) and checked against its CRC
+    - tar: read front to back; plain, or decompressed on the fly.
+      gzip is inflated in-process on a thread of its own, bzip2 / xz /
+      zstd by their command line tools in a child process (xz and
+      zstd with one thread per core, where the tool supports it). In
+      both cases decompression overlaps with writing
+    - Symlinks, devices and encrypted or unsupported zip members are
+      skipped and counted. The archive is only removed when asked to
+      and when every member was written
+
+    Not available without POSIX (the archive stays untouched).
+*/
+
+
+enum class archive_format
+{
+    none,
+    zip,
+    tar,
+    tar_gzip,
+    tar_bzip2,
+    tar_xz,
+    tar_zstd
+};
+
+// From the first bytes of the file (a compressed stream is assumed to hold a tar)
+archive_format detect_archive_format(const std::filesystem::path& archive_path);
+
+
+enum class explode_status
+{
+    ok,
+    not_an_archive,
+    open_failed,
+    corrupt,                // Damaged archive (or CRC mismatch); members written so far stay
+    write_failed,
+    decompressor_failed,    // Tool missing or exited with an error
+    unsupported             // No POSIX on this platform
+};
+
+
+/*
+    explode_policy
+    --------------
+    decompressor_threads: passed to xz / zstd (0 = one per core).
+*/
+struct explode_policy
+{
+    bool remove_archive = false;
+    unsigned decompressor_threads = 0;
+};
+
+
+struct explode_summary
+{
+    explode_status status = explode_status::ok;
+    std::size_t members = 0;        // Files written
+    std::size_t skipped = 0;        // Members that could not be represented
+    std::uint64_t bytes = 0;        // Uncompressed bytes written
+};
+
+
+/*
+    Called for every member written: its path inside the archive and
+    where it ended up.
+*/
+using exploded_member_callback =
+    std::function<void(const std::string& member_path, const std::filesystem::path& final_path)>;
+
+
+/*
+    Explodes archive_path into the category folders of
+    destination_root (placement as if each member were a loose file
+    in destination_root).
+*/
+explode_summary explode_archive(
+    const std::filesystem::path& archive_path,
+    const std::string& destination_root,
+    const organize_options& options,
+    const explode_policy& policy = explode_policy(),
+    const exploded_member_callback& on_member = nullptr
+);
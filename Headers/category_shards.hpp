@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+    ===============================
+        category_shards.hpp
+    ===============================
+
+    Keeps category folders small by splitting them into shard subfolders.
+
+    WHY THIS EXISTS:
+    ----------------
+    After organizing a big dump, "Image Files" can hold hundreds of
+    thousands of entries. Every later readdir, collision check and
+    file dialog on it becomes slow.
+
+    With sharding enabled, a category folder that would grow beyond
+    max_entries is split once into subfolders:
+
+        Image Files/
+            shard-00/
+            shard-01/
+            ...
+
+    ROUTING IS DETERMINISTIC:
+    -------------------------
+    The shard of a file depends ONLY on its name (hash bucket or
+    name prefix), so the same file always lands in the same shard,
+    run after run, machine after machine.
+
+    Shard folders are recognized by their "shard-" prefix directly
+    inside a category folder; the organizer treats files inside them
+    as living in the category folder itself.
+*/
+
+
+/*
+    shard_scheme
+    ------------
+    How a file name is mapped to a shard.
+*/
+enum class shard_scheme
+{
+    hash_bucket,    // FNV-1a hash of the name, evenly spread: "shard-3f"
+    name_prefix     // First character, browsable by humans: "shard-a"
+};
+
+
+/*
+    shard_policy
+    ------------
+    Default-constructed policy is DISABLED.
+*/
+struct shard_policy
+{
+    bool enabled = false;
+
+    std::size_t max_entries = 10000;    // Loose entries allowed before splitting
+    shard_scheme scheme = shard_scheme::hash_bucket;
+    unsigned hash_buckets = 256;        // Only used by hash_bucket
+};
+
+
+/*
+    is_shard_folder_name
+    --------------------
+    True for names produced by shard_folder_name ("shard-...").
+*/
+bool is_shard_folder_name(const std::string& folder_name);
+
+
+/*
+    shard_folder_name
+    -----------------
+    Pure function: file name → shard folder name.
+
+    Example:
+        hash_bucket, 256 buckets: "IMG_0042.jpg" → "shard-9c"
+        name_prefix:              "IMG_0042.jpg" → "shard-i"
+*/
+std::string shard_folder_name(const std::string& filename, const shard_policy& policy);
+
+
+/*
+    shard_registry
+    --------------
+    Per-run bookkeeping of category folders.
+
+    For every category folder touched during a run it remembers:
+    - whether the folder is already split into shards
+    - how many loose entries it holds
+
+    Each folder is scanned at most once per run; afterwards the
+    registry is updated in memory as files are routed.
+*/
+class shard_registry
+{
+public:
+    explicit shard_registry(const shard_policy& policy);
+
+    /*
+        Decides the directory a file should be placed in.
+
+        category_directory:
+            The category folder the organizer chose ("…/Image Files")
+        filename:
+            The (final) name of the file
+        already_inside:
+            true if the file already lives in category_directory or
+            one of its shards (it is then not counted a second time)
+
+        If accepting one more loose entry would exceed max_entries,
+        the folder is split first: its loose files are moved into
+        their shards and reported through take_relocations().
+    */
+    std::filesystem::path route(
+        const std::filesystem::path& category_directory,
+        const std::string& filename,
+        bool already_inside
+    );
+
+    /*
+        Where a move planned into directory must finally go.
+
+        Destination-ordered runs plan every move before executing any:
+        files routed loose into a category folder that a LATER file
+        caused to be split are still on their way, so the split could
+        not move them. Such moves belong in their shard; for every
+        other directory, directory itself is returned.
+
+        Read-only: safe from several threads once routing is over.
+    */
+    std::filesystem::path settled_directory(
+        const std::filesystem::path& directory,
+        const std::string& filename
+    ) const;
+
+    /*
+        Files moved by a split since the last call: (old path, new path).
+
+        Callers that keep indexes of file locations use this
+        to stay in sync.
+    */
+    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> take_relocations();
+
+private:
+    struct folder_state
+    {
+        bool sharded = false;
+        std::size_t loose_entries = 0;
+    };
+
+    folder_state& state_of(const std::filesystem::path& category_directory);
+    void split_folder(const std::filesystem::path& category_directory, folder_state& state);
+
+    shard_policy policy;
+    std::map<std::filesystem::path, folder_state> folders;
+    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> relocations;
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+/*
+    ===============================
+        cold_tier.hpp
+    ===============================
+
+    Moves files nobody has touched in a long time to a cold-tier root
+    (a cheaper disk or a network share), and brings them back.
+
+    WHY THIS EXISTS:
+    ----------------
+    On shared folders most bytes have not been read in a year. They
+    are organized already, so the category layout is worth keeping;
+    they just do not need to sit on the fast disk.
+
+    HOW IT WORKS:
+    -------------
+    - A file is cold when its access time (or birth time, see
+      tier_clock) is older than the threshold of its category
+    - It moves to "<cold_root>/<same relative path>", so the cold
+      tier mirrors the category layout of the tree
+    - Optionally a symlink is left at the old path, so the file stays
+      reachable where users expect it
+    - Same filesystem: one rename(). Across devices: resumable_copy
+      to a temporary name, read back against the source, published
+      without replacing anything, and only then the source is deleted
+    - An existing file at the destination is never replaced; the
+      moved file gets a numbered name instead
+
+    Recall walks the cold tier (or one folder/file of it) and moves
+    everything back, replacing the symlinks.
+
+    NOTE:
+    -----
+    With "noatime" mounts access times never change, and with
+    "relatime" (the Linux default) they are updated at most once a
+    day. Both are fine for thresholds counted in days, but on noatime
+    mounts tier_clock::birth_time is the more honest choice.
+*/
+
+
+/*
+    tier_clock
+    ----------
+    Which timestamp decides that a file is cold.
+
+    access_time: last read (atime)
+    birth_time:  creation (btime); files whose filesystem does not
+                 record it are never tiered
+*/
+enum class tier_clock
+{
+    access_time,
+    birth_time
+};
+
+
+/*
+    tiering_policy
+    --------------
+    Disabled by default.
+
+    age_days_by_category overrides default_age_days for single
+    categories ("Video Files" → 90); 0 keeps a category hot forever.
+*/
+struct tiering_policy
+{
+    bool enabled = false;
+
+    std::string cold_root;              // Must be outside the organized tree
+    tier_clock clock = tier_clock::access_time;
+
+    unsigned default_age_days = 365;
+    std::map<std::string, unsigned> age_days_by_category;
+
+    bool leave_symlink = false;         // Symlink at the old path → cold copy
+};
+
+
+enum class tiering_status
+{
+    success,
+    path_not_found,             // Root (or recall source) does not exist
+    cold_root_unavailable,      // Cold root missing and cannot be created
+    cold_root_overlaps_tree,    // One of the two lies inside the other
+    partial                     // Some files failed; the rest were moved
+};
+
+
+/*
+    tiering_summary
+    ---------------
+    Result of a tiering or recall pass.
+*/
+struct tiering_summary
+{
+    tiering_status status = tiering_status::success;
+    std::size_t files_moved = 0;
+    std::uint64_t bytes_moved = 0;
+    std::size_t files_failed = 0;
+};
+
+
+/*
+    Moves every cold file below root_path to policy.cold_root.
+    Stops early once *stop_requested becomes true.
+
+    Hidden folders (".file_organizer") and symlinks (including the
+    ones left by earlier passes) are never touched.
+*/
+tiering_summary tier_cold_files(
+    const std::string& root_path,
+    const tiering_policy& policy,
+    const std::atomic<bool>* stop_requested
+);
+
+
+/*
+    Moves files back from the cold tier into root_path.
+
+    relative_path selects what to bring back, relative to both roots
+    ("Video Files/2019" or "Video Files/2019/trip.mp4");
+    empty recalls everything.
+*/
+tiering_summary recall_cold_files(
+    const std::string& root_path,
+    const tiering_policy& policy,
+    const std::string& relative_path
+);
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+    ===============================
+        content_hash_cache.hpp
+    ===============================
+
+    One persistent cache of file content hashes for every feature
+    that hashes files.
+
+    WHY THIS EXISTS:
+    ----------------
+    Copy verification, duplicate detection and manifests all need
+    content hashes. Each of them reading the same terabytes again is
+    the slowest thing the organizer could do; a file whose identity
+    has not changed does not need to be read twice.
+
+    HOW IT WORKS:
+    -------------
+    - A file is identified by (device, inode, size, mtime_ns). Any
+      write changes the modification time, so a changed file simply
+      misses the cache
+    - The cache is an open-addressing hash table in one file, mapped
+      into memory (mmap) and shared by every process of the user:
+        "$XDG_CACHE_HOME/file_organizer/content_hashes.bin"
+      (XDG_CACHE_HOME defaults to ~/.cache)
+    - Two hashes per file (64-bit FNV-1a, the hash copy verification
+      already uses):
+        partial  size + first 64 KiB + last 64 KiB (cheap pre-filter)
+        full     every byte
+    - Readers never lock: a slot is published with a release store of
+      its state once its key is written, and a hash with a release
+      store of its flag, so a reader sees either nothing or a finished
+      value
+    - There is ONE appender: the process holding an exclusive flock()
+      on the file. Other processes use the cache read-only, and
+      within the appending process stores are serialized by a mutex
+    - Entries are never overwritten, so a file that keeps changing
+      leaves stale entries behind. Compaction (also run when the table
+      is three quarters full) keeps only the newest entry of every
+      (device, inode), rebuilds a table of the right size under a
+      temporary name and renames it into place. Mappings that readers
+      may still use are only unmapped when the cache is closed
+
+    FILE FORMAT:
+    ------------
+        header  64 bytes: "FOHASH1\n", slot count (power of two),
+                          used slots
+        slots   64 bytes each (one cache line):
+                state, device, inode, size, mtime_ns,
+                partial hash, full hash, flags
+
+    Without POSIX (mmap, flock) the cache stays closed: every lookup
+    misses and hashes are computed from the data.
+*/
+
+
+/*
+    file_identity
+    -------------
+    What a cached hash is valid for.
+*/
+struct file_identity
+{
+    std::uint64_t device = 0;
+    std::uint64_t inode = 0;
+    std::uint64_t size = 0;
+    std::int64_t mtime_ns = 0;
+};
+
+// stat() of path; false if it cannot be identified
+bool identify_file(const std::filesystem::path& path, file_identity& identity);
+
+
+/*
+    cached_hashes
+    -------------
+    What the cache knows about one file identity.
+*/
+struct cached_hashes
+{
+    bool has_partial = false;
+    bool has_full = false;
+    std::uint64_t partial = 0;
+    std::uint64_t full = 0;
+};
+
+
+enum class hash_cache_status
+{
+    ok,
+    read_only,          // Opened, but another process is the appender
+    unavailable,        // Cache file cannot be created or mapped
+    read_failed         // (hashing) the file cannot be read
+};
+
+
+/*
+    content_hash_cache
+    ------------------
+    Like memory_governor, one instance per process (shared()).
+    Closed until open() is called; a closed cache misses every lookup
+    and drops every store.
+*/
+class content_hash_cache
+{
+public:
+    static content_hash_cache& shared();
+
+    // "$XDG_CACHE_HOME/file_organizer/content_hashes.bin"
+    static std::filesystem::path default_path();
+
+    ~content_hash_cache();
+
+    content_hash_cache(const content_hash_cache&) = delete;
+    content_hash_cache& operator=(const content_hash_cache&) = delete;
+
+    /*
+        Opens (or creates) the cache file. ok = this process is the
+        appender, read_only = lookups only.
+    */
+    hash_cache_status open(const std::filesystem::path& cache_path);
+    void close();
+
+    // Lock-free; false if nothing is cached for identity
+    bool lookup(const file_identity& identity, cached_hashes& hashes) const;
+
+    // Dropped unless this process is the appender
+    void store_partial(const file_identity& identity, std::uint64_t hash);
+    void store_full(const file_identity& identity, std::uint64_t hash);
+
+    /*
+        Keeps the newest entry of every (device, inode) and resizes
+        the table to twice the entries kept. Appender only.
+    */
+    hash_cache_status compact();
+
+    std::size_t entries() const;
+    std::size_t capacity() const;
+
+private:
+    content_hash_cache() = default;
+
+    struct table_mapping
+    {
+        void* base = nullptr;
+        std::size_t length = 0;
+        std::uint64_t slot_count = 0;
+    };
+
+    // One attempt of open(); orphaned = retry, the file was replaced meanwhile
+    hash_cache_status open_table(const std::filesystem::path& cache_path, bool& orphaned);
+
+    void store(const file_identity& identity, std::uint64_t hash, bool full);
+
+    // compact() with append_mutex already held
+    hash_cache_status compact_locked();
+
+    // Creates a table of slot_count slots at path and maps it; caller holds append_mutex
+    table_mapping* create_table(const std::filesystem::path& table_path, std::uint64_t slot_count, int& table_fd);
+
+    std::filesystem::path path;
+    int fd = -1;
+    bool appender = false;
+
+    // Current table; replaced tables stay mapped in retired until close()
+    std::atomic<table_mapping*> current{nullptr};
+    std::vector<table_mapping*> retired;
+
+    std::mutex append_mutex;
+};
+
+
+/*
+    Hashes of a file's content, taken from the shared cache when the
+    file's identity is known there, and recorded there otherwise.
+*/
+hash_cache_status partial_content_hash(const std::filesystem::path& file_path, std::uint64_t& hash);
+hash_cache_status full_content_hash(const std::filesystem::path& file_path, std::uint64_t& hash);
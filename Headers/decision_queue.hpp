@@ -0,0 +1,100 @@
+#pragma once
+#include "move_plan.hpp"
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+    ===============================
+        decision_queue.hpp
+    ===============================
+
+    Deferred decisions for moves that need a human.
+
+    WHY THIS EXISTS:
+    ----------------
+    Stopping the run to ask about every conflict idles the whole
+    engine until the user answers, and repeats the question for every
+    similar file.
+
+    Instead, a move that needs a decision is PARKED here with
+    everything needed to execute it later, and the run carries on with
+    the remaining files. When the run is over the GUI shows one
+    grouped dialog (one answer per kind of conflict, applied to all
+    similar items) and the parked moves are executed as one batch.
+*/
+
+
+/*
+    decision_kind
+    -------------
+    Why a move was parked.
+*/
+enum class decision_kind
+{
+    cross_device_move,  // rename() impossible, copy + delete needed (atomic mode)
+    name_collision      // Target name already taken (collision_policy::ask)
+};
+
+
+/*
+    decision_choice
+    ---------------
+    Answers the user can give.
+
+    copy_and_delete: cross_device_move only
+    keep_both:       name_collision only, numbered like "file(1).txt"
+    skip:            leave the file where it is
+*/
+enum class decision_choice
+{
+    undecided,
+    copy_and_delete,
+    keep_both,
+    skip
+};
+
+
+/*
+    deferred_decision
+    -----------------
+    One parked move and its context.
+*/
+struct deferred_decision
+{
+    decision_kind kind = decision_kind::cross_device_move;
+    planned_move move;
+    std::string conflicting_path;       // Existing file (name_collision only)
+    decision_choice choice = decision_choice::undecided;
+};
+
+
+/*
+    decision_queue
+    --------------
+    Thread-safe parking area, owned by the caller of the run
+    (see organize_options::deferred).
+*/
+class decision_queue
+{
+public:
+    void park(deferred_decision decision);
+
+    std::size_t size() const;
+
+    // Returns all parked items and empties the queue
+    std::vector<deferred_decision> take_all();
+
+private:
+    mutable std::mutex mutex;
+    std::vector<deferred_decision> parked;
+};
+
+
+/*
+    Applies choice to every undecided item of the given kind
+    ("apply to all similar"). Returns how many items changed.
+*/
+std::size_t decide_all(std::vector<deferred_decision>& decisions, decision_kind kind, decision_choice choice);
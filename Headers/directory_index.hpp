@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+/*
+    ===============================
+        directory_index.hpp
+    ===============================
+
+    Persistent per-root index of where organized files live.
+
+    WHY THIS EXISTS:
+    ----------------
+    When CATEGORY_EXTENSION_MAP changes (a new extension is added,
+    or one moves between categories), the only way to apply the new
+    rules used to be a full walk of the whole tree.
+
+    The index remembers:
+    - the rule table (extension → category) the tree was organized with
+    - every file location, grouped by extension
+
+    so a rule change only touches files whose category actually changed.
+
+    STORAGE:
+    --------
+    The index lives in "<root>/.file_organizer/directory_index".
+    Hidden directories are never walked by the organizer, so the index
+    never gets classified or moved itself.
+
+    MEMORY:
+    -------
+    A location costs about 150 bytes of heap, so the index of a large
+    tree does not have to fit in memory:
+
+    - Loading can be paged: only the groups a run works on are read,
+      the others stay in the index file
+    - While recording, locations past a budget (or any amount once the
+      heap target is reached) are spilled to sorted run files, like
+      the destination-ordered plan does
+
+    Saving merges the index file, the runs and the in-memory part
+    into a new index file, streaming.
+*/
+
+
+/*
+    index_status
+    ------------
+    Represents the result of loading or saving the index.
+*/
+enum class index_status
+{
+    ok,                     // Index read / written successfully
+    not_found,              // No index exists for this root yet
+    corrupt,                // Index exists but could not be parsed
+    write_failed            // Index could not be persisted
+};
+
+
+/*
+    index_spill
+    -----------
+    Locations of a directory_index that live on disk, not in memory.
+
+    Moving one takes its run files along; destroying one removes
+    them, so an aborted run leaves nothing behind.
+*/
+class index_spill
+{
+public:
+    index_spill() = default;
+    ~index_spill();
+
+    index_spill(index_spill&& other) noexcept;
+    index_spill& operator=(index_spill&& other) noexcept;
+
+    index_spill(const index_spill&) = delete;
+    index_spill& operator=(const index_spill&) = delete;
+
+    // Index file whose unloaded groups still count (empty = none)
+    std::filesystem::path paged_from;
+
+    // Sorted runs spilled while recording
+    std::vector<std::filesystem::path> run_files;
+
+    // (extension, path) forgotten since: hides copies on disk
+    std::set<std::pair<std::string, std::string>> forgotten;
+
+    // Rough heap footprint of the in-memory locations
+    std::size_t memory_bytes = 0;
+
+    // Set once a run could not be written; locations then stay in memory
+    bool failed = false;
+
+    bool has_disk_part() const;
+    void remove_runs();
+};
+
+
+/*
+    directory_index
+    ---------------
+    In-memory form of the persistent index.
+
+    rules:
+        extension → category, snapshot of EXTENSION_LOOKUP at the time
+        the tree was organized
+
+    locations:
+        extension → set of file paths relative to the root
+        (extension "" holds files without an extension)
+        Only the in-memory part: with a paged load or after spilling,
+        other locations are in spill.
+
+    spill:
+        the part on disk (see "MEMORY" above)
+*/
+struct directory_index
+{
+    std::map<std::string, std::string> rules;
+    std::map<std::string, std::set<std::string>> locations;
+    index_spill spill;
+};
+
+
+/*
+    get_state_directory
+    -------------------
+    Returns "<root>/.file_organizer", the directory used for every piece
+    of persistent organizer state belonging to a root.
+*/
+std::filesystem::path get_state_directory(const std::string& root_path);
+
+
+/*
+    load_directory_index
+    --------------------
+    Reads the index of root_path into index.
+
+    index is left empty unless index_status::ok is returned.
+*/
+index_status load_directory_index(
+    const std::string& root_path,
+    directory_index& index
+);
+
+/*
+    Paged load: the rules, and the locations of the given extensions
+    only. The other locations stay in the index file and are carried
+    over by save_directory_index. With no extensions, only the rules
+    are read.
+*/
+index_status load_directory_index(
+    const std::string& root_path,
+    directory_index& index,
+    const std::set<std::string>& extensions
+);
+
+
+/*
+    save_directory_index
+    --------------------
+    Persists index for root_path.
+
+    Written to a temporary file first and renamed into place,
+    so an interrupted save never leaves a half-written index.
+
+    Merges the in-memory locations with the spilled runs and the
+    pages left in the previous index file. Afterwards the runs are
+    gone and the new index file is the disk part of index.
+*/
+index_status save_directory_index(
+    const std::string& root_path,
+    directory_index& index
+);
+
+
+/*
+    record_file_location / forget_file_location
+    -------------------------------------------
+    Add or remove a single file from the index.
+
+    file_path is absolute (or relative to the working directory);
+    it is stored relative to root_path.
+
+    Recording may spill the in-memory locations to a run file
+    under get_state_directory(root_path).
+*/
+void record_file_location(
+    directory_index& index,
+    const std::string& root_path,
+    const std::filesystem::path& file_path
+);
+
+void forget_file_location(
+    directory_index& index,
+    const std::string& root_path,
+    const std::filesystem::path& file_path
+);
+
+
+/*
+    diff_rule_tables
+    ----------------
+    Compares two extension → category tables.
+
+    Output:
+        Every extension whose category differs between the tables.
+        An extension missing from one side counts as "Others",
+        which is what classify_file_by_extension returns for it.
+*/
+std::set<std::string> diff_rule_tables(
+    const std::map<std::string, std::string>& old_rules,
+    const std::map<std::string, std::string>& new_rules
+);
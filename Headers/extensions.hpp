@@ -71,6 +71,22 @@ extern const std::map<std::string, std::string> EXTENSION_LOOKUP;
 extern const std::set<std::string> CANONICAL_NAMES;
 
 
+/*
+    normalize_extension
+    -------------------
+    Input:
+        Full file path or file name as a string
+
+    Output:
+        Lowercase extension without the leading dot,
+        or an empty string if the file has no extension
+
+    This is the exact key used by EXTENSION_LOOKUP, so anything that
+    indexes files by extension stays consistent with classification.
+*/
+std::string normalize_extension(const std::string& file_path);
+
+
 /*
     classify_file_by_extension
     --------------------------
@@ -87,3 +103,43 @@ extern const std::set<std::string> CANONICAL_NAMES;
     - Returns "Others" if extension is unknown or missing
 */
 std::string classify_file_by_extension(const std::string& file_path);
+
+
+/*
+    rule_table
+    ----------
+    One complete set of classification rules in lookup form.
+
+    extension_lookup: extension → category (like EXTENSION_LOOKUP)
+    category_names:   every category folder name (like CANONICAL_NAMES)
+
+    Organize runs always use builtin_rule_table(). Other tables are
+    only built to evaluate rule changes before rollout
+    (see rule_simulator.hpp).
+*/
+struct rule_table
+{
+    std::map<std::string, std::string> extension_lookup;
+    std::set<std::string> category_names;
+};
+
+
+/*
+    The rules of CATEGORY_EXTENSION_MAP, built once.
+*/
+const rule_table& builtin_rule_table();
+
+
+/*
+    Builds a table from extension → category pairs.
+    Category names are taken from the values.
+*/
+rule_table make_rule_table(const std::map<std::string, std::string>& extension_lookup);
+
+
+/*
+    classify_with_rules
+    -------------------
+    classify_file_by_extension against an explicit rule table.
+*/
+std::string classify_with_rules(const rule_table& rules, const std::string& file_path);
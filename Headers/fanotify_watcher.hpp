@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+    ===============================
+        fanotify_watcher.hpp
+    ===============================
+
+    Watches a directory tree for newly arrived files.
+
+    WHY FANOTIFY:
+    -------------
+    inotify needs one watch per directory. Shares with millions of
+    directories exceed fs.inotify.max_user_watches and pin a lot of
+    kernel memory.
+
+    fanotify with FAN_MARK_FILESYSTEM needs ONE mark for the whole
+    filesystem. Events carry (directory handle, name) instead of a
+    path (FAN_REPORT_DFID_NAME); handles are resolved to paths with
+    open_by_handle_at and cached, so events outside the root are
+    discarded with a single hash lookup.
+
+    PRIVILEGES:
+    -----------
+    Filesystem marks and open_by_handle_at need CAP_SYS_ADMIN /
+    CAP_DAC_READ_SEARCH. Without them the watcher falls back to an
+    inode mark on the root directory itself, which still reports
+    everything dropped directly into the root (the common case),
+    and says so through coverage().
+
+    Linux only; other platforms report watch_status::unsupported.
+*/
+
+
+/*
+    watch_status
+    ------------
+    Outcome of starting the watcher or waiting for events.
+*/
+enum class watch_status
+{
+    ok,                 // Watching / events delivered
+    unsupported,        // Platform or kernel lacks fanotify with DFID_NAME
+    permission_denied,  // Not even the root-only fallback is allowed
+    queue_overflow,     // Kernel dropped events; caller should rescan
+    failed              // Any other error
+};
+
+
+/*
+    watch_coverage
+    --------------
+    What part of the tree events are reported for.
+*/
+enum class watch_coverage
+{
+    none,           // Not started
+    filesystem,     // Every directory below the root
+    root_only       // Only files placed directly in the root
+};
+
+
+class fanotify_watcher
+{
+public:
+    fanotify_watcher() = default;
+
+    // Closes the fanotify group and mount descriptor
+    ~fanotify_watcher();
+
+    fanotify_watcher(const fanotify_watcher&) = delete;
+    fanotify_watcher& operator=(const fanotify_watcher&) = delete;
+
+    /*
+        Creates the fanotify group and places the mark for root_path.
+
+        Tries a filesystem-wide mark first and falls back to a
+        root-only inode mark when privileges do not allow it.
+    */
+    watch_status start(const std::string& root_path);
+
+    watch_coverage coverage() const;
+
+    /*
+        Waits up to timeout_ms for events and appends the paths of
+        files that were written or moved in below the root.
+
+        Returns ok with no paths on timeout.
+        Returns queue_overflow when events were lost.
+    */
+    watch_status wait_for_changes(
+        int timeout_ms,
+        std::vector<std::filesystem::path>& changed_files
+    );
+
+private:
+    /*
+        Resolves a directory handle to its path below the root.
+
+        Returns false for directories outside the root
+        (remembered, so the next event from there costs one lookup)
+        and for handles that cannot be resolved.
+    */
+    bool resolve_directory(const std::string& handle_key, void* handle, std::filesystem::path& directory);
+
+    /*
+        A directory called name was moved out of (moved_in = false)
+        or into (moved_in = true) the directory behind handle.
+
+        Only cache entries that can be stale are dropped: the moved
+        subtree when it left a directory below the root, the "outside
+        the root" entries when something moved in below the root.
+        Moves elsewhere on the filesystem keep the cache.
+    */
+    void forget_moved_directory(const std::string& handle_key, void* handle, const char* name, bool moved_in);
+
+    int fanotify_fd = -1;
+    int mount_fd = -1;
+
+    std::filesystem::path root;
+    watch_coverage current_coverage = watch_coverage::none;
+
+    /*
+        Handle cache: (fsid + handle bytes) → directory path.
+        An empty path marks a directory outside the root.
+
+        Cleared when it grows past HANDLE_CACHE_LIMIT; directory
+        renames drop only the entries they make stale
+        (forget_moved_directory).
+    */
+    static constexpr std::size_t HANDLE_CACHE_LIMIT = 65536;
+    std::unordered_map<std::string, std::filesystem::path> handle_cache;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/*
+    ===============================
+        filename_sanitizer.hpp
+    ===============================
+
+    Optional name normalization applied while files are organized.
+
+    WHY THIS EXISTS:
+    ----------------
+    Downstream tools choke on names with trailing spaces, control
+    characters, reserved characters or overlong names. Fixing them
+    afterwards means yet another full pass over the tree.
+
+    Instead, the sanitized name becomes the TARGET name of the move
+    the organizer performs anyway, so the fix costs no extra syscalls.
+
+    DESIGN RULE:
+    ------------
+    - Pure string functions, no filesystem access here
+    - The extension is preserved whenever possible,
+      so classification is unaffected
+*/
+
+
+/*
+    sanitize_policy
+    ---------------
+    Controls which problems are fixed.
+
+    Default-constructed policy is DISABLED: names are never touched
+    unless the user opts in.
+*/
+struct sanitize_policy
+{
+    bool enabled = false;
+
+    bool replace_control_characters = true;   // 0x00-0x1F and 0x7F
+    bool replace_reserved_characters = true;  // < > : " / \ | ? *
+    bool trim_spaces_and_dots = true;         // leading spaces, trailing spaces and dots
+    bool rename_reserved_device_names = true; // CON, PRN, AUX, NUL, COM1-9, LPT1-9
+
+    std::size_t max_name_bytes = 255;         // common filesystem name limit
+    char replacement = '_';
+};
+
+
+/*
+    needs_sanitizing
+    ----------------
+    Fast check used before doing any work.
+
+    Most names are already clean, so this is a single
+    table-driven pass without allocations.
+*/
+bool needs_sanitizing(const std::string& filename, const sanitize_policy& policy);
+
+
+/*
+    sanitize_filename
+    -----------------
+    Input:
+        A single file name (NOT a path)
+
+    Output:
+        The name normalized according to policy.
+        Returned unchanged if the policy is disabled or nothing is wrong.
+
+    Example (default policy):
+        "report?.pdf  " → "report_.pdf"
+        "CON.txt"       → "CON_.txt"
+*/
+std::string sanitize_filename(const std::string& filename, const sanitize_policy& policy);
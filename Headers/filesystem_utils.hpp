@@ -2,6 +2,8 @@
 
 #include <filesystem>
 #include <cctype>
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <map>
 #include <set>
@@ -74,6 +76,7 @@ enum class file_move_status
     successful_transfer,    // File moved successfully
     permission_denied,      // Access denied at source or destination
     cross_device_error,     // Filesystem does not support atomic move
+    destination_exists,     // Exact destination taken meanwhile; nothing was moved
     unknown_failure
 };
 
@@ -106,6 +109,19 @@ extern const std::map<std::string, std::set<std::string>> CATEGORY_ALIAS_MAP;
 extern const std::map<std::string, std::string> ALIAS_LOOKUP;
 
 
+/*
+    PARTIAL_FOLDER_NAME
+    -------------------
+    Hidden folder inside a destination directory where files are
+    written under a temporary name until they are complete (resumable
+    copies, exploded archive members). Hidden folders are never
+    organized; is_partial_folder_name recognizes it during the walk.
+*/
+extern const std::string PARTIAL_FOLDER_NAME;
+
+bool is_partial_folder_name(const std::string& folder_name);
+
+
 /*
     validate_path
     -------------
@@ -157,7 +173,9 @@ void normalize_category_folder(const std::string& current_directory_level_path);
     Attempts to create a directory safely.
 
     Behavior:
-    - Does nothing if directory already exists
+    - Creates missing parent directories too
+    - Does nothing if directory already exists (also when another
+      thread creates it at the same moment)
     - Returns explicit status instead of throwing
 */
 create_directory_status create_directory(
@@ -191,6 +209,42 @@ std::filesystem::path get_unique_path(
     const std::string& filename
 );
 
+/*
+    write_all_bytes
+    ---------------
+    write() until every byte is out, retrying on EINTR.
+    POSIX only; false on any other error.
+*/
+bool write_all_bytes(int fd, const char* data, std::size_t length);
+
+/*
+    transfer_to_unique_path
+    -----------------------
+    Places source_path in destination_dir under filename, or under the
+    first free numbered variant of it ("file(1).txt", ...).
+
+    transfer is one of the *_to_path functions below (or anything with
+    their contract): it moves the file to an EXACT path and returns
+    destination_exists, having done nothing, when that path is taken.
+    Another writer can take the free name between get_unique_path and
+    the transfer; the next free name is then tried, a bounded number
+    of times.
+
+    If final_destination is given, it receives the path the file was
+    actually placed at.
+*/
+using path_transfer = std::function<file_move_status(
+    const std::filesystem::path& source_path,
+    const std::filesystem::path& destination_path)>;
+
+file_move_status transfer_to_unique_path(
+    const std::filesystem::path& source_path,
+    const std::filesystem::path& destination_dir,
+    const std::string& filename,
+    const path_transfer& transfer,
+    std::filesystem::path* final_destination = nullptr
+);
+
 /*
     atomic_file_transfer
     --------------------
@@ -202,10 +256,19 @@ std::filesystem::path get_unique_path(
 
     Limitations:
     - May fail across different filesystems/devices
+
+    If final_destination is given, it receives the collision-free
+    path the file was actually moved to.
+
+    If target_filename is non-empty, the file is renamed to it as part
+    of the same move (used by the sanitize stage); otherwise it keeps
+    its current name.
 */
 file_move_status atomic_file_transfer(
     const std::string& source_path,
-    const std::string& destination_path
+    const std::string& destination_path,
+    std::filesystem::path* final_destination = nullptr,
+    const std::string& target_filename = std::string()
 );
 
 
@@ -220,8 +283,37 @@ file_move_status atomic_file_transfer(
     - Remove original file
 
     Slower, but more portable.
+
+    final_destination and target_filename behave exactly as in
+    atomic_file_transfer.
 */
 file_move_status fallback_transfer(
     const std::string& source_path,
-    const std::string& destination_path
+    const std::string& destination_path,
+    std::filesystem::path* final_destination = nullptr,
+    const std::string& target_filename = std::string()
+);
+
+
+/*
+    atomic_transfer_to_path / fallback_transfer_to_path
+    ---------------------------------------------------
+    Same strategies as above, but to an EXACT destination path.
+
+    The caller is responsible for picking a collision-free name
+    (e.g. from a name registry that already knows the directory).
+    An existing file is never replaced, even if the caller's view
+    of the directory was stale: the rename is made with
+    RENAME_NOREPLACE (checked rename where the filesystem lacks it)
+    and destination_exists is returned, so the caller can pick the
+    next name.
+*/
+file_move_status atomic_transfer_to_path(
+    const std::filesystem::path& source_path,
+    const std::filesystem::path& destination_path
+);
+
+file_move_status fallback_transfer_to_path(
+    const std::filesystem::path& source_path,
+    const std::filesystem::path& destination_path
 );
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+/*
+    ===============================
+        job_priority.hpp
+    ===============================
+
+    Priority classes for runs that share the machine.
+
+    WHY THIS EXISTS:
+    ----------------
+    A long background run (watch mode catching up after lost events,
+    a bulk reorganization) and a small run started from the GUI used
+    to compete for the disk and the CPUs on equal terms, so the small
+    run waited behind the big one.
+
+    HOW IT WORKS:
+    -------------
+    Every organizer thread executes its work in batches and holds one
+    slot of the process-wide priority_gate per batch:
+
+    - interactive batches may use every slot
+    - bulk batches may not use the reserved_interactive slots
+    - while an interactive batch is waiting, no bulk batch starts
+
+    A running bulk batch is never interrupted; bulk work yields at its
+    next batch boundary, which bounds the delay an interactive run sees
+    to one batch per bulk thread.
+*/
+
+
+enum class job_priority
+{
+    interactive,    // Started by the user, who is waiting for it
+    bulk            // Background work, only uses spare capacity
+};
+
+
+/*
+    priority_gate
+    -------------
+    Counting gate with a reserve for interactive work.
+*/
+class priority_gate
+{
+public:
+    priority_gate(unsigned slots, unsigned reserved_interactive);
+
+    /*
+        Gate shared by every run of this process:
+        one slot per hardware thread (at least 2), a quarter of them
+        (at least 1) reserved for interactive work.
+    */
+    static priority_gate& shared();
+
+    void acquire(job_priority priority);
+    void release(job_priority priority);
+
+private:
+    bool can_start(job_priority priority) const;
+
+    std::mutex mutex;
+    std::condition_variable slot_freed;
+
+    unsigned slots;
+    unsigned reserved_interactive;
+
+    unsigned running_interactive = 0;
+    unsigned running_bulk = 0;
+    unsigned waiting_interactive = 0;
+};
+
+
+/*
+    batch_slot
+    ----------
+    Holds one slot of priority_gate::shared() for its lifetime.
+
+    yield() marks a batch boundary: the slot is given back and taken
+    again, which lets waiting interactive work go first.
+*/
+class batch_slot
+{
+public:
+    explicit batch_slot(job_priority priority);
+    ~batch_slot();
+
+    batch_slot(const batch_slot&) = delete;
+    batch_slot& operator=(const batch_slot&) = delete;
+
+    void yield();
+
+private:
+    job_priority priority;
+};
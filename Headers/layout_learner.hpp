@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+    ===============================
+        layout_learner.hpp
+    ===============================
+
+    Learns extension → folder routing from the user's own layout.
+
+    WHY THIS EXISTS:
+    ----------------
+    Many trees already have a structure ("Invoices", "Designs",
+    "Contracts") that CATEGORY_ALIAS_MAP knows nothing about. The built-in
+    rules would pull a stray invoice into "PDF Files" even though
+    every other PDF of the tree lives in "Work/Invoices".
+
+    HOW IT WORKS:
+    -------------
+    1. One parallel scan of the tree counts files per
+       (folder, extension), hidden folders excluded
+    2. Counts are rolled up, so every folder knows how many files of
+       each extension live anywhere inside it
+    3. For every extension the DEEPEST user folder holding at least
+       min_files and min_share of the extension's placed files
+       (files not loose in the root) becomes its learned home
+
+    Category folders, alias folders and shard folders are never
+    proposed: the built-in rules already handle those.
+
+    The rules are proposed to the caller (learned_rule) and, once
+    accepted, compiled into a learned_routing lookup table that the
+    organizer consults before EXTENSION_LOOKUP.
+*/
+
+
+/*
+    learning_policy
+    ---------------
+    Thresholds of the learning pass.
+*/
+struct learning_policy
+{
+    std::size_t min_files = 5;      // Folder must hold at least this many files of the extension
+    double min_share = 0.6;         // ...and this share of all placed files of the extension
+    unsigned scan_threads = 4;      // Directories read at once
+};
+
+
+enum class learning_status
+{
+    ok,
+    path_not_found,     // Root does not exist or is not a directory
+    incomplete          // Some folders could not be read, rules use the rest
+};
+
+
+/*
+    learned_rule
+    ------------
+    One proposed route, with the evidence behind it.
+*/
+struct learned_rule
+{
+    std::string extension;          // Normalized like EXTENSION_LOOKUP keys
+    std::string folder;             // Relative to the root, '/'-separated ("Work/Invoices")
+    std::size_t files_in_folder = 0;
+    std::size_t files_placed = 0;   // All files of the extension outside the root level
+};
+
+
+/*
+    learning_result
+    ---------------
+    Outcome of learn_routing_rules(). Rules are sorted by extension.
+*/
+struct learning_result
+{
+    learning_status status = learning_status::ok;
+    std::vector<learned_rule> rules;
+    std::size_t files_scanned = 0;
+    std::size_t folders_scanned = 0;
+};
+
+
+/*
+    Scans root_path on up to policy.scan_threads threads and derives
+    one rule per extension that has a clear home folder.
+*/
+learning_result learn_routing_rules(const std::string& root_path, const learning_policy& policy);
+
+
+/*
+    learned_routing
+    ---------------
+    Accepted rules compiled into an O(1) lookup table:
+
+        extension → absolute destination folder
+
+    Immutable once built, so any number of worker threads may read it.
+*/
+class learned_routing
+{
+public:
+    learned_routing(const std::string& root_path, const std::vector<learned_rule>& rules);
+
+    // Root the rules were learned from
+    const std::string& root() const;
+
+    std::size_t size() const;
+
+    // Destination folder for the extension, or nullptr (use the built-in rules)
+    const std::string* destination_for(const std::string& extension) const;
+
+private:
+    std::string root_path;
+    std::unordered_map<std::string, std::string> destinations;
+};
+
+
+/*
+    True if directory_path is folder_path or lies anywhere below it.
+*/
+bool is_within_folder(const std::string& directory_path, const std::string& folder_path);
@@ -11,12 +11,22 @@
 */
 
 // Organizer logic (core backend)
+#include "cold_tier.hpp"
+#include "content_hash_cache.hpp"
+#include "directory_index.hpp"
 #include "organizer.hpp"
+#include "rule_simulator.hpp"
+#include "run_estimator.hpp"
+#include "thumbnail_cache.hpp"
+#include "tree_snapshot.hpp"
+
+#include <memory>
 
 // Qt core GUI components
 #include <QMainWindow>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QInputDialog>
 
 // Qt concurrency utilities (for background threading)
 #include <QtConcurrent>
@@ -91,6 +101,208 @@ private slots:
     */
     void on_action_about_triggered();
 
+    /*
+        Slot triggered when user selects "Apply Rule Changes"
+        from the Tools menu.
+
+        Re-organizes only the files whose category changed since
+        the last run (see reclassify_directory).
+    */
+    void on_action_apply_rule_changes_triggered();
+
+    /*
+        Slot triggered when user toggles "Sanitize File Names"
+        in the Tools menu.
+
+        Enables / disables the sanitize stage for the next runs.
+    */
+    void on_action_sanitize_names_toggled(bool checked);
+
+    /*
+        Slot triggered when user toggles "Watch Folder"
+        in the Tools menu.
+
+        Starts / stops organizing new files as they arrive
+        in the selected folder (see watch_directory).
+    */
+    void on_action_watch_folder_toggled(bool checked);
+
+    /*
+        Slot triggered when user toggles "Record Performance Metrics"
+        in the Tools menu.
+
+        When enabled, each run writes .file_organizer/metrics.json
+        into the organized folder.
+    */
+    void on_action_record_metrics_toggled(bool checked);
+
+    /*
+        Slot triggered when user toggles "Record Tree Snapshots"
+        in the Tools menu.
+
+        When enabled, each run ends with a snapshot of the folder in
+        .file_organizer/snapshot.bin, the baseline for
+        "Show Changes Since Last Run...".
+    */
+    void on_action_record_snapshots_toggled(bool checked);
+
+    /*
+        Slot triggered when user toggles "Explode Archives While Organizing"
+        in the Tools menu.
+
+        zip / tar archives are unpacked straight into the category
+        folders of their members instead of being filed as archives.
+    */
+    void on_action_explode_archives_toggled(bool checked);
+
+    /*
+        Slot triggered when user toggles "Shard Large Category Folders"
+        in the Tools menu.
+
+        Uses the default shard_policy (hash buckets, 10000 entries).
+    */
+    void on_action_shard_folders_toggled(bool checked);
+
+    /*
+        Slot triggered when user toggles "Group Moves by Destination"
+        in the Tools menu.
+
+        Switches between scan order and destination order execution.
+    */
+    void on_action_group_by_destination_toggled(bool checked);
+
+    /*
+        Slot triggered when user toggles "Parallel Moves"
+        in the Tools menu.
+
+        Executes moves on one worker per CPU core. Collision numbering
+        stays deterministic (ordered by source path).
+    */
+    void on_action_parallel_moves_toggled(bool checked);
+
+    /*
+        Slot triggered when user toggles "Parallel Directory Reads"
+        in the Tools menu.
+
+        Reads huge folders on ext4 with one thread per CPU core.
+    */
+    void on_action_parallel_directory_reads_toggled(bool checked);
+
+    /*
+        Slot triggered when user toggles "Run as Background Job"
+        in the Tools menu.
+
+        Runs with bulk priority: they only use spare CPU slots and
+        give way to interactive runs at every batch boundary.
+    */
+    void on_action_background_priority_toggled(bool checked);
+
+    /*
+        Slot triggered when user selects "Post-Move Hook..."
+        in the Tools menu.
+
+        Asks for a shell command that receives batches of completed
+        moves as NDJSON on stdin. An empty command disables the hook.
+    */
+    void on_action_move_hook_triggered();
+
+    /*
+        Slot triggered when user selects "Heap Target..."
+        in the Tools menu.
+
+        Asks for the heap growth target of the next runs in MiB
+        (0 = none).
+    */
+    void on_action_heap_target_triggered();
+
+    /*
+        Slot triggered when user toggles "Pre-generate Thumbnails"
+        in the Tools menu.
+
+        After a successful run, thumbnails of the moved images are
+        generated in the background for file managers to pick up.
+    */
+    void on_action_generate_thumbnails_toggled(bool checked);
+
+    /*
+        Slot triggered when user selects "Learn Routing From Layout..."
+        in the Tools menu.
+
+        Scans the folder in the background for folders that already
+        collect one kind of file and proposes them as routing rules.
+    */
+    void on_action_learn_layout_triggered();
+
+    /*
+        Slot triggered when user selects "Estimate Run..."
+        in the Tools menu.
+
+        Samples the folder in the background and predicts how many
+        files a run would move and how long it would take.
+    */
+    void on_action_estimate_run_triggered();
+
+    /*
+        Slot triggered when user selects "Show Changes Since Last Run..."
+        in the Tools menu.
+
+        Diffs the folder against the snapshot of the last run in the
+        background and lists added, removed, moved and modified files
+        in .file_organizer/changes.ndjson.
+    */
+    void on_action_show_changes_triggered();
+
+    /*
+        Slot triggered when user selects "Move Cold Files to Archive..."
+        in the Tools menu.
+
+        Asks for the archive folder and the age threshold, then moves
+        files not read for that long into the archive in the background.
+    */
+    void on_action_tier_cold_files_triggered();
+
+    /*
+        Slot triggered when user selects "Recall Files from Archive..."
+        in the Tools menu.
+
+        Moves a chosen archive folder back into the organized folder.
+    */
+    void on_action_recall_cold_files_triggered();
+
+    /*
+        Slot triggered when user toggles "Ask on Name Collisions"
+        in the Tools menu.
+
+        Colliding files are parked instead of numbered and decided
+        in one dialog after the run.
+    */
+    void on_action_ask_on_collision_toggled(bool checked);
+
+    /*
+        Slot triggered when user selects "Capture Tree Manifest..."
+        in the Tools menu.
+
+        Records the folder's files and sizes for later rule simulations.
+    */
+    void on_action_capture_manifest_triggered();
+
+    /*
+        Slot triggered when user selects "Export Current Rules..."
+        in the Tools menu.
+
+        Writes the built-in rules as an editable rules file.
+    */
+    void on_action_export_rules_triggered();
+
+    /*
+        Slot triggered when user selects "Simulate Rule Changes..."
+        in the Tools menu.
+
+        Replays a manifest with an edited rules file, without touching
+        any file, and writes every difference next to the rules file.
+    */
+    void on_action_simulate_rules_triggered();
+
     /*
         Slot triggered when the "Browse" button is clicked.
 
@@ -127,6 +339,126 @@ private:
     */
     transfer_mode current_mode = transfer_mode::atomic_transfer_mode;
 
+    /*
+        Organizer entry point used by the running job.
+
+        Remembered so a cross-device retry in fallback mode
+        repeats the same kind of run (full or incremental).
+    */
+    organize_status (*current_job)(const std::string&, transfer_mode, const organize_options&) = organize_directory;
+
+    /*
+        Optional organizer stages selected in the Tools menu.
+
+        Passed by value to the worker thread, so toggling a menu
+        entry never affects a job that is already running.
+    */
+    organize_options current_options;
+
+    /*
+        Thumbnail stage, run after a job has finished.
+
+        placed_images is shared with the job's on_file_moved callback,
+        which fills it from the organizer's worker threads.
+    */
+    thumbnail_policy current_thumbnails;
+    std::shared_ptr<placed_image_collector> placed_images;
+    std::atomic<bool> thumbnail_stop_requested{false};
+    QFutureWatcher<thumbnail_summary> thumbnail_watcher;
+
+    /*
+        Starts thumbnail generation for everything placed_images
+        collected, unless a previous pass is still running.
+    */
+    void start_thumbnails();
+
+    // Reports the result of a thumbnail pass in the status field
+    void on_thumbnails_finished();
+
+    /*
+        Routing learned from the folder layout and accepted by the
+        user. Only used for runs on the root it was learned from.
+    */
+    std::shared_ptr<const learned_routing> learned_routes;
+    QFutureWatcher<learning_result> learning_watcher;
+
+    // Shows the proposed rules and compiles the accepted ones
+    void on_learning_finished();
+
+    /*
+        Lets the user untick proposed rules;
+        returns false if the dialog was cancelled.
+    */
+    bool choose_learned_rules(std::vector<learned_rule>& rules);
+
+    // learned_routes if they belong to root_path, nullptr otherwise
+    std::shared_ptr<const learned_routing> routes_for(const std::string& root_path) const;
+
+    /*
+        Run estimate, computed in its own background task.
+    */
+    QFutureWatcher<run_estimate> estimate_watcher;
+
+    // Shows the predicted outcome with its confidence intervals
+    void on_estimate_finished();
+
+    /*
+        Diff against the last snapshot, run in its own background
+        task. last_changes is filled by the task.
+    */
+    std::shared_ptr<snapshot_diff_summary> last_changes;
+    QFutureWatcher<snapshot_status> changes_watcher;
+
+    // Reports the counts of a diff
+    void on_changes_finished();
+
+    /*
+        Cold-file tiering and recall, run in their own background task.
+    */
+    tiering_policy current_tiering;
+    std::atomic<bool> tiering_stop_requested{false};
+    QFutureWatcher<tiering_summary> tiering_watcher;
+
+    // Reports the result of a tiering or recall pass
+    void on_tiering_finished();
+
+    /*
+        Manifest capture and rule simulation, run in their own
+        background task. last_simulation is filled by the task
+        (nullptr for a capture).
+    */
+    std::shared_ptr<simulation_report> last_simulation;
+    QFutureWatcher<simulation_status> simulation_watcher;
+
+    // Reports the result of a capture or simulation
+    void on_simulation_finished();
+
+    /*
+        Starts current_job on the path in the path field
+        in a background thread.
+    */
+    void start_job();
+
+    /*
+        Moves parked during the running job (cross-device moves,
+        name collisions). Shared with the job through
+        current_options.deferred.
+    */
+    std::shared_ptr<decision_queue> pending_decisions;
+
+    /*
+        Shows one dialog for all parked moves, grouped by kind, with
+        one answer per group ("apply to all similar"), then executes
+        the decided moves as one batch in the background.
+    */
+    void resolve_pending_decisions();
+
+    /*
+        The grouped dialog itself. Fills in each item's choice;
+        returns false if the user cancelled (everything is skipped).
+    */
+    bool ask_for_decisions(std::vector<deferred_decision>& decisions);
+
     /*
         Applies a Qt stylesheet (.qss file) to the entire application.
 
@@ -154,6 +486,19 @@ private:
         - Notify GUI thread when work is complete
     */
     QFutureWatcher<organize_status> result_watcher;
+
+    /*
+        Watch mode runs in its own background task, independent of
+        the Organize button, until watch_stop_requested is set.
+    */
+    std::atomic<bool> watch_stop_requested{false};
+    QFutureWatcher<organize_status> watch_watcher;
+
+    /*
+        Called when the watch task ends, either because the user
+        stopped it or because watching failed.
+    */
+    void on_watch_finished();
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+/*
+    ===============================
+        memory_governor.hpp
+    ===============================
+
+    Steers the organizer's heap growth toward a target.
+
+    This is NOT a bound on the process's memory: only allocator
+    statistics are watched, and only the engine's adjustable buffers
+    react. Code, thread stacks and mapped files (content hash cache)
+    come on top, so resident memory can exceed the target.
+
+    WHY THIS EXISTS:
+    ----------------
+    On a small NAS the organizer shares 1-2 GB of RAM with other
+    services. Its buffers are sized for speed (64 MiB plan budget,
+    1 MiB copy buffers, deep queues), which is fine on a desktop and
+    too much there.
+
+    HOW IT WORKS:
+    -------------
+    The governor reads the ALLOCATOR's own statistics (mallinfo2 on
+    glibc, malloc zone statistics on macOS): bytes currently handed
+    out, from every arena, including memory-mapped blocks. Nothing is
+    polled on a timer; the engine asks at its natural boundaries (a
+    scan batch, a move batch, a plan entry, a copy), and a reading is
+    reused for up to 20 ms of questions, because reading walks the
+    allocator's free lists.
+
+    The engine then adapts:
+
+    - scan batches and move batches get smaller
+    - execution queues get shallower
+    - the destination-ordered plan spills to disk early
+    - the directory index spills recorded locations to disk
+    - collision registries drop folders they no longer need
+    - copy buffers shrink
+
+    Everything is at full size below half the target and shrinks
+    linearly to its minimum at the target.
+
+    Like priority_gate, there is one governor per process, because the
+    allocator statistics are per process. Runs that set a target hold
+    it for their duration (heap_target_hold); concurrent runs (a watch
+    and a GUI run, say) steer toward the LARGEST target held, so no run
+    is squeezed below what it asked for, and the target returns to the
+    remaining runs' (or none) when a run ends. Without allocator
+    statistics (other platforms) sizes never shrink; only the plan
+    budget is capped by the run's own target.
+*/
+
+
+class memory_governor
+{
+public:
+    // Governor of this process
+    static memory_governor& shared();
+
+    /*
+        Registers / releases one run's target (bytes, 0 = none: not
+        registered). Prefer heap_target_hold, which pairs the calls.
+    */
+    void hold_target(std::size_t bytes);
+    void release_target(std::size_t bytes);
+
+    // Largest target currently held; 0 = none
+    std::size_t target() const;
+
+    // Bytes currently allocated, from the allocator statistics (0 if unknown)
+    std::size_t allocated_bytes();
+
+    // True if a target is set and allocated_bytes() has reached it
+    bool over_target();
+
+    /*
+        full_size while less than half of the target is allocated,
+        shrinking linearly to minimum as the target is reached.
+    */
+    std::size_t scaled(std::size_t full_size, std::size_t minimum);
+
+private:
+    memory_governor() = default;
+
+    // Held targets → number of runs holding them; target_bytes is the largest
+    std::mutex holds_mutex;
+    std::map<std::size_t, unsigned> held_targets;
+    std::atomic<std::size_t> target_bytes{0};
+
+    // Last allocator reading and when it was taken (steady clock)
+    std::atomic<std::int64_t> last_refresh_ns{0};
+    std::atomic<std::size_t> last_allocated{0};
+};
+
+
+/*
+    heap_target_hold
+    ----------------
+    Holds a run's heap target on the process governor
+    for as long as the object lives.
+*/
+class heap_target_hold
+{
+public:
+    explicit heap_target_hold(std::size_t bytes);
+    ~heap_target_hold();
+
+    heap_target_hold(const heap_target_hold&) = delete;
+    heap_target_hold& operator=(const heap_target_hold&) = delete;
+
+private:
+    std::size_t bytes;
+};
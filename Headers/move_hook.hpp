@@ -0,0 +1,189 @@
+#pragma once
+#include "run_metrics.hpp"
+#include "work_queue.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+    ===============================
+        move_hook.hpp
+    ===============================
+
+    Batched post-move notifications for downstream tools
+    (search indexers, thumbnailers, ...).
+
+    WHY THIS EXISTS:
+    ----------------
+    Those tools need to learn the new path of every moved file, but
+    starting one process per file would cost far more than the move.
+
+    HOW IT WORKS:
+    -------------
+    - Completed moves are collected in memory
+    - A batch is sent once it holds batch_files moves, or once its
+      oldest move is batch_interval_ms old, whichever comes first
+    - Every batch is sent as NDJSON, one move per line:
+
+        {"source":"/a/photo.jpg","destination":"/a/Image Files/photo.jpg"}
+
+    - At most max_concurrent batches are in flight; when the hook
+      falls behind, moves wait (backpressure) instead of piling up
+    - A hook that takes longer than timeout_ms is given up on: its
+      command (and everything it started) is killed, its socket
+      closed, and the batch counted as failed
+
+    TARGETS:
+    --------
+    command:     run with /bin/sh -c, NDJSON on stdin,
+                 exit status 0 = success
+    unix_socket: connect to a SOCK_STREAM endpoint, write the NDJSON,
+                 shut down the write side, and wait for the endpoint to
+                 close the connection (= batch processed)
+
+    A failing hook never fails the organize run; failures and latency
+    are reported in metrics.json ("hooks").
+*/
+
+
+enum class hook_target
+{
+    command,
+    unix_socket
+};
+
+
+/*
+    hook_policy
+    -----------
+    Configuration of the hook stage. Disabled by default.
+*/
+struct hook_policy
+{
+    bool enabled = false;
+
+    hook_target target = hook_target::command;
+    std::string command;                // For hook_target::command
+    std::string socket_path;            // For hook_target::unix_socket
+
+    std::size_t batch_files = 256;      // Send after this many moves ...
+    unsigned batch_interval_ms = 1000;  // ... or after this long
+    unsigned max_concurrent = 2;        // Batches in flight at once
+    unsigned timeout_ms = 60000;        // Per invocation; 0 = wait forever
+};
+
+
+/*
+    hook_status
+    -----------
+    Outcome of a single hook invocation.
+*/
+enum class hook_status
+{
+    ok,
+    spawn_failed,       // Command could not be started
+    connect_failed,     // Socket endpoint not reachable
+    write_failed,       // Payload could not be delivered completely
+    command_failed,     // Command exited with a non-zero status
+    timed_out,          // Hook still busy after timeout_ms
+    unsupported         // Hooks are not available on this platform
+};
+
+
+/*
+    completed_move
+    --------------
+    One entry of a hook batch.
+*/
+struct completed_move
+{
+    std::string source;
+    std::string destination;
+};
+
+
+/*
+    Serializes a batch as NDJSON (one JSON object per line).
+*/
+std::string moves_to_ndjson(const std::vector<completed_move>& moves);
+
+
+/*
+    Appends text as a quoted JSON string (paths are kept byte for byte).
+*/
+void append_json_string(std::string& out, const std::string& text);
+
+
+/*
+    Delivers one payload to the configured target and waits
+    until the target is done with it.
+*/
+hook_status invoke_hook(const hook_policy& policy, const std::string& payload);
+
+
+/*
+    move_hook
+    ---------
+    Collects moves from any thread and dispatches batches.
+
+    Owns one timer thread (time-based flushes) and max_concurrent
+    sender threads.
+*/
+class move_hook
+{
+public:
+    /*
+        metrics may be null; otherwise every invocation is
+        recorded with run_metrics::record_hook_call.
+    */
+    move_hook(const hook_policy& policy, run_metrics* metrics);
+
+    // Same as finish()
+    ~move_hook();
+
+    move_hook(const move_hook&) = delete;
+    move_hook& operator=(const move_hook&) = delete;
+
+    /*
+        Thread-safe; may block while all senders are busy, but never
+        while holding the lock other callers and the timer need.
+    */
+    void record(const std::filesystem::path& source, const std::filesystem::path& destination);
+
+    /*
+        Sends what is still pending and waits for every
+        batch in flight. Safe to call more than once.
+    */
+    void finish();
+
+private:
+    void timer_loop();
+    void sender_loop();
+
+    /*
+        Takes the pending batch out; mutex must be held. The caller
+        hands it to the senders with send() after releasing it.
+    */
+    std::vector<completed_move> take_pending();
+    void send(std::vector<completed_move>& batch);
+
+    hook_policy policy;
+    run_metrics* metrics;
+
+    std::mutex mutex;
+    std::condition_variable wake_timer;
+    std::vector<completed_move> pending;
+    std::chrono::steady_clock::time_point batch_started;
+    bool stopping = false;
+    bool finished = false;
+
+    work_queue<std::vector<completed_move>> batches;
+    std::thread timer;
+    std::vector<std::thread> senders;
+};
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*
+    ===============================
+        move_plan.hpp
+    ===============================
+
+    Destination-ordered execution of moves.
+
+    WHY THIS EXISTS:
+    ----------------
+    Moving files in scan order scatters renames across many destination
+    folders, which keeps evicting directory entries and inodes from the
+    kernel caches.
+
+    In destination order the organizer first PLANS every move, sorts the
+    plan by (destination folder, name), and then executes it folder by
+    folder, so each destination is hot while all of its files arrive.
+
+    EXTERNAL MEMORY:
+    ----------------
+    A plan for millions of files may not fit the memory budget. When it
+    grows past the budget, the in-memory part is sorted and spilled to a
+    "run" file; at the end all runs are merged (k-way) while executing.
+*/
+
+
+/*
+    planned_move
+    ------------
+    One move decided by the planner but not executed yet.
+*/
+struct planned_move
+{
+    std::string destination_directory;
+    std::string target_filename;    // Desired name, collisions resolved at execution
+    std::string source_path;
+};
+
+
+/*
+    plan_status
+    -----------
+    Outcome of adding to / draining a plan.
+*/
+enum class plan_status
+{
+    ok,
+    spill_failed,       // A sorted run could not be written or read back
+    stopped             // The consumer asked to stop (e.g. a move failed)
+};
+
+
+/*
+    move_plan
+    ---------
+    Collects planned moves and hands them back sorted by
+    (destination_directory, target_filename, source_path).
+
+    The source path is the final tie-breaker, so the order is fully
+    deterministic for a given set of moves.
+*/
+class move_plan
+{
+public:
+    /*
+        spill_directory:
+            Where sorted runs are written if needed (created on demand,
+            removed again when the plan is destroyed)
+        memory_budget_bytes:
+            Approximate memory the in-memory part may use; the part is
+            also spilled early once the process's heap reaches
+            its target (see memory_governor.hpp)
+    */
+    move_plan(const std::filesystem::path& spill_directory, std::size_t memory_budget_bytes);
+
+    // Removes any run files left behind
+    ~move_plan();
+
+    move_plan(const move_plan&) = delete;
+    move_plan& operator=(const move_plan&) = delete;
+
+    plan_status add(planned_move move);
+
+    /*
+        Calls consumer for every planned move in sorted order.
+
+        The consumer returns false to stop early (drain then returns
+        plan_status::stopped). The plan is empty afterwards.
+    */
+    plan_status drain(const std::function<bool(const planned_move&)>& consumer);
+
+    // Number of sorted runs written to disk so far
+    std::size_t spilled_runs() const;
+
+private:
+    plan_status spill();
+    void remove_runs();
+
+    std::filesystem::path spill_directory;
+    std::size_t memory_budget_bytes;
+
+    std::vector<planned_move> pending;
+    std::size_t pending_bytes = 0;
+
+    std::vector<std::filesystem::path> run_files;
+};
+
+
+/*
+    name_registry
+    -------------
+    Interface used by the executor to turn a desired name into a free
+    one inside a destination folder.
+
+    Naming strategy matches get_unique_path:
+        "file.txt" → "file(1).txt" → "file(2).txt" ...
+*/
+class name_registry
+{
+public:
+    virtual ~name_registry() = default;
+
+    // Reserves and returns a free name based on filename inside directory
+    virtual std::string claim(const std::filesystem::path& directory, const std::string& filename) = 0;
+
+    /*
+        The move that claimed a name in directory is over (moved or
+        failed): the name is now either on disk or free again.
+    */
+    virtual void release(const std::filesystem::path& directory)
+    {
+        (void)directory;
+    }
+};
+
+
+/*
+    destination_name_registry
+    -------------------------
+    Collision registry for ONE destination folder at a time.
+
+    The folder is listed once when it is opened; afterwards every
+    collision check is a hash lookup instead of a stat() call.
+    Names handed out are remembered, so files of the same plan never
+    collide with each other either.
+
+    Not thread-safe: each worker owns its own instance.
+
+    Over the heap target, the name table of the previous folder is
+    freed instead of being kept for reuse.
+*/
+class destination_name_registry : public name_registry
+{
+public:
+    /*
+        Switches to directory (no-op if it is already open).
+        A directory that does not exist yet simply starts empty.
+    */
+    void open(const std::filesystem::path& directory);
+
+    const std::filesystem::path& directory() const;
+
+    // Reserves and returns a free name based on filename
+    std::string claim(const std::string& filename);
+
+    // open(directory) + claim(filename)
+    std::string claim(const std::filesystem::path& directory, const std::string& filename) override;
+
+private:
+    std::filesystem::path current_directory;
+    bool is_open = false;
+    std::unordered_set<std::string> taken_names;
+};
+
+
+/*
+    shared_name_registry
+    --------------------
+    Collision registry shared by all workers (thread-safe).
+
+    Every destination folder is listed the first time any worker
+    claims a name in it. Which of two colliding files gets "file(1)"
+    depends on which worker gets there first, so numbering is NOT
+    reproducible between runs.
+
+    Over the heap target, folders without a move in flight are
+    forgotten: everything claimed there is on disk by then, so listing
+    the folder again gives the same answer.
+*/
+class shared_name_registry : public name_registry
+{
+public:
+    std::string claim(const std::filesystem::path& directory, const std::string& filename) override;
+    void release(const std::filesystem::path& directory) override;
+
+private:
+    struct folder_names
+    {
+        std::unordered_set<std::string> names;
+        std::size_t in_flight = 0;      // Claims whose move is not over yet
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, folder_names> taken_names;
+};
@@ -1,4 +1,19 @@
 #pragma once
+#include "category_shards.hpp"
+#include "decision_queue.hpp"
+#include "extensions.hpp"
+#include "fanotify_watcher.hpp"
+#include "filename_sanitizer.hpp"
+#include "job_priority.hpp"
+#include "layout_learner.hpp"
+#include "move_hook.hpp"
+#include "run_metrics.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <memory>
 #include <string>
 
 /*
@@ -24,6 +39,8 @@ enum class organize_status
     already_in_correct_location,    // File was already where it belongs
     atomic_transfer_failed,         // rename() failed due to cross-device issue
     fallback_transfer_failed,       // copy + delete failed
+    watch_unavailable,              // Folder watching not possible here
+    decisions_pending,              // Run finished, some moves wait for the user
     unknown_error                   // Catch-all for unexpected failures
 };
 
@@ -50,6 +67,226 @@ enum class transfer_mode
     fallback_transfer_mode
 };
 
+/*
+    =========================================================
+        execution_order
+    =========================================================
+
+    scan_order:
+        - Each file is moved as soon as it is found
+        - Simple, no extra memory
+
+    destination_order:
+        - The whole walk is planned first
+        - Moves are sorted by (destination folder, name) and executed
+          one destination folder at a time, with that folder's
+          collision registry kept in memory
+        - Plans larger than the memory budget spill to disk
+        - Required for parallel execution (execution_threads > 1)
+*/
+enum class execution_order
+{
+    scan_order,
+    destination_order
+};
+
+/*
+    =========================================================
+        collision_policy
+    =========================================================
+
+    What happens when the target name is already taken.
+
+    keep_both:
+        - The new file gets a numbered name ("file(1).txt")
+    ask:
+        - The move is parked in organize_options::deferred
+          and decided by the user after the run
+        - Behaves like keep_both when no queue is given
+*/
+enum class collision_policy
+{
+    keep_both,
+    ask
+};
+
+/*
+    =========================================================
+        organize_options
+    =========================================================
+
+    Optional stages of an organize run.
+
+    A default-constructed organize_options reproduces the
+    classic behavior: classify and move, nothing else.
+*/
+struct organize_options
+{
+    /*
+        Sanitize stage (between classify and move).
+
+        The sanitized name is used as the target name of the move,
+        so fixing a name costs no extra syscall for misplaced files.
+        Files already in the right folder get a single in-place rename.
+    */
+    sanitize_policy sanitize;
+
+    /*
+        Category folder sharding.
+
+        Keeps category folders under shard.max_entries loose entries by
+        routing files into "shard-…" subfolders chosen from their name.
+    */
+    shard_policy shard;
+
+    /*
+        Order in which moves are executed (organize_directory only).
+
+        plan_memory_budget bounds the in-memory part of a
+        destination-ordered plan before it is spilled as sorted runs
+        into "<root>/.file_organizer".
+    */
+    execution_order order = execution_order::scan_order;
+    std::size_t plan_memory_budget = 64 * 1024 * 1024;
+
+    /*
+        Parallel execution of the plan.
+
+        execution_threads > 1 runs the moves on that many worker
+        threads (and implies destination_order: workers need a plan).
+
+        deterministic_collisions:
+            true  → every destination folder is owned by ONE worker,
+                    which claims names in plan order. Colliding files
+                    are numbered by source path ("a/photo.jpg" gets
+                    "photo.jpg", "b/photo.jpg" gets "photo(1).jpg"),
+                    identical on every run and every thread count.
+            false → moves are spread evenly over the workers and share
+                    one locked registry; numbering follows thread timing.
+
+        In deterministic mode, at most one worker per destination folder
+        is busy: a tree with ~10 category folders keeps ~10 workers busy
+        at most (not measured; see README "Parallel Moves").
+    */
+    unsigned execution_threads = 1;
+    bool deterministic_collisions = true;
+
+    /*
+        EXPERIMENTAL: threads reading one large folder (organize_directory).
+
+        directory_read_threads > 1 splits a huge folder on ext4 into
+        hash ranges read side by side (see partitioned_scan.hpp). Other
+        filesystems and small folders are read serially. Entries then
+        arrive in no particular order.
+    */
+    unsigned directory_read_threads = 1;
+
+    /*
+        Priority class of the run (see job_priority.hpp).
+
+        Runs of the same process share the CPUs through one gate;
+        bulk runs yield to interactive ones at batch boundaries.
+    */
+    job_priority priority = job_priority::interactive;
+
+    /*
+        Heap growth target in bytes (0 = none), held for the run.
+        The heap is shared: with several runs in the process, the
+        largest target of the running ones applies.
+
+        Steered by memory_governor (see memory_governor.hpp): scan and
+        move batches, queues, copy buffers and collision registries
+        shrink as the heap nears the target, and a destination-ordered
+        plan keeps at most a quarter of it in memory before spilling,
+        the directory index spills too. Not a bound on resident
+        memory: code, stacks and mapped files come on top.
+    */
+    std::size_t heap_target = 0;
+
+    /*
+        Per-phase metrics.
+
+        When enabled, the run writes wall time and (where the kernel
+        allows it) hardware counters per phase to
+        "<root>/.file_organizer/metrics.json".
+    */
+    bool collect_metrics = false;
+
+    /*
+        Tree snapshot.
+
+        When enabled, a successful run ends by writing a sorted
+        snapshot of the tree to "<root>/.file_organizer/snapshot.bin"
+        (the one before is kept as snapshot.previous.bin), so the next
+        changes can be diffed quickly (see tree_snapshot.hpp).
+    */
+    bool record_snapshot = false;
+
+    /*
+        Archive explosion (organize_directory).
+
+        When enabled, a zip / tar archive found outside "Archive Files"
+        is unpacked straight into the category folders of its members
+        and then removed (see archive_explode.hpp). An archive that
+        cannot be fully unpacked is organized as a normal file.
+    */
+    bool explode_archives = false;
+
+    /*
+        Post-move hook.
+
+        Every completed move (including shard splits) is reported to
+        the configured command or Unix socket, in NDJSON batches.
+        Hook failures never fail the run.
+    */
+    hook_policy hook;
+
+    /*
+        In-process counterpart of the hook: called with (source,
+        destination) after every completed move.
+
+        May be called from several worker threads at once
+        (execution_threads > 1), so it must be thread-safe.
+    */
+    std::function<void(const std::filesystem::path&, const std::filesystem::path&)> on_file_moved;
+
+    /*
+        Deferred decisions.
+
+        When deferred is set (caller-owned, must outlive the run),
+        moves that need the user are parked there instead of stopping
+        the run:
+        - cross-device moves in atomic_transfer_mode
+        - name collisions with on_collision == collision_policy::ask
+
+        The run then returns decisions_pending; the parked moves are
+        executed later with apply_decisions().
+    */
+    collision_policy on_collision = collision_policy::keep_both;
+    decision_queue* deferred = nullptr;
+
+    /*
+        Learned routing (see layout_learner.hpp).
+
+        Extensions with a learned home folder are sent there instead
+        of their category folder; anywhere inside that folder counts
+        as the right place. Learned homes are never sharded.
+
+        Only full runs consult it: reclassify_directory applies
+        changes of EXTENSION_LOOKUP, not of learned rules.
+    */
+    std::shared_ptr<const learned_routing> learned;
+
+    /*
+        Per-run state, set internally by organize_directory /
+        reclassify_directory while the matching option is on.
+        Callers leave these null.
+    */
+    run_metrics* metrics = nullptr;
+    shard_registry* shards = nullptr;
+    move_hook* hooks = nullptr;
+};
+
 /*
     =========================================================
         Public API
@@ -71,13 +308,37 @@ organize_status check_directory(const std::string& root_path);
     - Decide correct destination
     - Prevent invalid nesting inside category folders
     - Move file safely
+
+    If final_path is given and the file was moved,
+    it receives the file's new location.
 */
 organize_status handle_file(
     const std::string& root_path,
     const std::string& entry_path,
-    transfer_mode t_mode
+    transfer_mode t_mode,
+    const organize_options& options = organize_options(),
+    std::filesystem::path* final_path = nullptr
 );
 
+/*
+    The placement decision of handle_file, without touching the disk.
+
+    Decides where current_filename (inside current_directory_level_path)
+    belongs under the given rules and fills move if it has to go
+    somewhere else. Returns already_in_correct_location or success.
+
+    Real runs use builtin_rule_table(); the rule simulator replays
+    candidate tables through the same logic.
+*/
+organize_status plan_placement(
+    const std::string& current_directory_level_path,
+    const std::string& current_filename,
+    const organize_options& options,
+    const rule_table& rules,
+    planned_move& move
+);
+
+
 /*
     Iteratively walks the directory tree and organizes files.
 
@@ -87,5 +348,60 @@ organize_status handle_file(
 */
 organize_status organize_directory(
     const std::string& root_path,
-    transfer_mode t_mode
+    transfer_mode t_mode,
+    const organize_options& options
+);
+
+
+/*
+    Applies category rule changes without a full walk.
+
+    - Uses the directory index written by organize_directory
+    - Only files whose extension changed category are moved
+    - Falls back to a full organize_directory when no index exists
+*/
+organize_status reclassify_directory(
+    const std::string& root_path,
+    transfer_mode t_mode,
+    const organize_options& options
+);
+
+
+/*
+    Executes moves parked in a decision_queue, according to
+    each item's choice (undecided items are skipped).
+
+    - Records the new locations in the directory index
+    - Reports the moves to the hook stage like a normal run
+    - Files that changed or vanished since parking are skipped
+*/
+organize_status apply_decisions(
+    const std::string& root_path,
+    const std::vector<deferred_decision>& decisions,
+    const organize_options& options
+);
+
+
+/*
+    Watches the directory and organizes files as they arrive.
+
+    - Uses fanotify (one mark for the whole filesystem where
+      privileges allow, the root directory only otherwise)
+    - Files are handled as soon as they are closed after writing
+      or moved in, exactly like a normal run would handle them
+    - Runs until *stop_requested becomes true
+    - Lost events (queue overflow) trigger one full organize pass
+    - on_started (optional) is called once watching has begun, with
+      the coverage obtained. root_only means files dropped into
+      subfolders are NOT seen; the caller should tell the user.
+      Called on the watching thread
+
+    Returns watch_unavailable if fanotify cannot be used at all.
+*/
+organize_status watch_directory(
+    const std::string& root_path,
+    transfer_mode t_mode,
+    const organize_options& options,
+    const std::atomic<bool>* stop_requested,
+    const std::function<void(watch_coverage)>& on_started = nullptr
 );
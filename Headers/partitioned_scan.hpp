@@ -0,0 +1,101 @@
+#pragma once
+#include "scan_batch.hpp"
+#include "work_queue.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+    ===============================
+        partitioned_scan.hpp
+    ===============================
+
+    EXPERIMENTAL: several threads reading ONE huge directory.
+
+    WHY THIS EXISTS:
+    ----------------
+    Parallel execution does not help with a single folder of millions
+    of entries: reading it is one getdents() stream plus one fstatat()
+    per entry, strictly one after the other, and takes minutes.
+
+    HOW IT WORKS:
+    -------------
+    On ext4 with hashed (htree) directories, a directory position as
+    returned by telldir() is the hash of the entry's name, and
+    seekdir() to ANY value continues at the first entry whose hash is
+    not smaller. The 63-bit hash space can therefore be cut into equal
+    ranges, and each thread reads (and stats) its own range:
+
+        thread 0: seekdir(0)          … stops at 1 · 2^63 / n
+        thread 1: seekdir(2^63 / n)   … stops at 2 · 2^63 / n
+        ...
+
+    Names hash uniformly, so the ranges hold about the same number of
+    entries.
+
+    The first entry a thread reads may lie past its range when the
+    range is empty; it is then also the first entry of the next range.
+    First entries are therefore held back until every thread is done,
+    and only reported by the last range that read them.
+
+    FALLBACK:
+    ---------
+    The plain serial scan is used unless all of these hold:
+    - more than one thread was requested
+    - the filesystem is ext2/3/4 (other filesystems, XFS included, do
+      not hand out hash-ordered positions)
+    - the directory is large (1 MiB of directory blocks, roughly 30k
+      entries), so threads pay off
+    - its first positions are strictly increasing and use the upper
+      32 bits, i.e. the directory really is hash-indexed
+*/
+
+
+/*
+    partitioned_directory_scanner
+    -----------------------------
+    Drop-in for directory_scanner.
+
+    In partitioned mode batches come from the reader threads in no
+    particular order, and hold at most 256 entries each, whatever
+    max_entries asks for.
+*/
+class partitioned_directory_scanner
+{
+public:
+    explicit partitioned_directory_scanner(unsigned threads);
+
+    // Stops and joins the readers (also when not read to the end)
+    ~partitioned_directory_scanner();
+
+    partitioned_directory_scanner(const partitioned_directory_scanner&) = delete;
+    partitioned_directory_scanner& operator=(const partitioned_directory_scanner&) = delete;
+
+    scan_status open(const std::string& directory_path);
+
+    scan_status next_batch(scan_batch& batch, std::size_t max_entries = 1024);
+
+    // True if open() chose the partitioned mode
+    bool is_partitioned() const;
+
+private:
+    void stop_readers();
+    void read_range(std::size_t range, std::uint64_t start, std::uint64_t end);
+    void finish_range();
+
+    unsigned threads;
+    std::string directory_path;
+
+    directory_scanner serial;
+    bool partitioned = false;
+
+    std::unique_ptr<work_queue<scan_batch>> ready;
+    std::vector<std::thread> readers;
+    std::vector<scan_batch> first_entries;      // One held-back entry per range (or none)
+    std::atomic<std::size_t> running_readers{0};
+    std::atomic<bool> failed{false};
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include "filesystem_utils.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+/*
+    ===============================
+        resumable_copy.hpp
+    ===============================
+
+    Copies that survive an interruption, used by the fallback
+    (copy + delete) transfers.
+
+    WHY THIS EXISTS:
+    ----------------
+    A cross-device copy of a 200 GB disk image that is interrupted at
+    95 % used to start again from zero on the next run, and copy_file
+    with overwrite_existing wrote straight over the partial file at
+    the final name, so a half-copied file could look like a real one.
+
+    HOW IT WORKS:
+    -------------
+    - The copy is written to a temporary name inside a hidden folder
+      of the destination directory (hidden folders are never
+      organized), on the same filesystem as the destination
+    - The temporary name is derived from the source path, so the next
+      run finds it again even if the destination name changed
+    - Large files are copied in chunks. After each chunk the data is
+      flushed and a journal record "chunk i done, hash h" is appended
+      and flushed; the journal is the persisted chunk bitmap
+    - On resume, the journal is only trusted if the source still has
+      the same size and modification time. A record is only written
+      once its chunk and the record itself were fsync'd, so recorded
+      chunks are trusted as they are; only the LAST recorded chunk is
+      hashed again (the one a crash could have caught mid-record).
+      Resuming a 95 % done copy reads nothing but that chunk before
+      copying the rest
+    - Only a complete copy is renamed to the final name, and never
+      over an existing file
+    - Temporary copies never outlive their use: they are removed when
+      the source changed or vanished, and when publishing fails
+      (except destination_exists: the caller retries under the next
+      free name and the finished copy is reused). Leftovers of
+      crashed runs are swept by sweep_partial_folder()
+
+    Partial folder layout:
+        <destination dir>/.file_organizer-partial/<source id>
+        <destination dir>/.file_organizer-partial/<source id>.journal
+*/
+
+
+/*
+    resumable_copy_policy
+    ---------------------
+    Files smaller than chunked_threshold are copied in one go
+    (still through the temporary name).
+
+    verify: before publishing, the finished copy is read back and
+    compared byte for byte with the source (one more read of each).
+    A mismatch discards the copy. Used by moves that delete a source
+    nobody will look at again (cold tier).
+*/
+struct resumable_copy_policy
+{
+    std::uint64_t chunked_threshold = 64ULL * 1024 * 1024;
+    std::uint64_t chunk_size = 16ULL * 1024 * 1024;
+    bool verify = false;
+};
+
+
+/*
+    Copies source_path to destination_path, resuming an earlier
+    interrupted copy of the same source if one is found.
+
+    The source is left untouched. Fails with destination_exists if
+    destination_path already exists (or appears before the copy is
+    published).
+
+    With policy.verify, content_hash (if given) receives the FNV-1a
+    hash of the verified content, the full hash of content_hash_cache.
+*/
+file_move_status resumable_copy(
+    const std::filesystem::path& source_path,
+    const std::filesystem::path& destination_path,
+    const resumable_copy_policy& policy = resumable_copy_policy(),
+    std::uint64_t* content_hash = nullptr
+);
+
+
+/*
+    Removes stale entries of "<directory>/.file_organizer-partial":
+
+    - chunked copies whose source vanished or changed
+      (size / modification time differ from the journal)
+    - any other temporary file untouched for a day (single-shot
+      copies and archive members of a crashed run)
+
+    The folder itself is removed once empty. The organizer calls this
+    for every partial folder its walk comes across.
+*/
+void sweep_partial_folder(const std::filesystem::path& directory);
@@ -0,0 +1,139 @@
+#pragma once
+#include "extensions.hpp"
+#include "organizer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+    ===============================
+        rule_simulator.hpp
+    ===============================
+
+    Offline "what would change" for a new rule set.
+
+    WHY THIS EXISTS:
+    ----------------
+    The only way to see what a changed CATEGORY_EXTENSION_MAP does
+    used to be running it on a real share. Instead:
+
+    1. capture_tree_manifest() records a tree once (paths and sizes)
+    2. simulate_rules() replays a whole organize run over the manifest
+       entirely in memory, twice: with the current rules and with the
+       candidate rules
+    3. The outcomes are diffed: files whose destination changes,
+       collisions that only the candidate rules cause, and folders
+       that only the candidate rules create
+
+    The replay uses the same placement decision as a real run
+    (plan_placement), the same alias-folder normalization, the same
+    walk order and the same "name(1).ext" collision numbering.
+    Sharding is not replayed (it depends on live folder sizes).
+
+    FILE FORMATS (plain text, TAB separated):
+    -----------------------------------------
+    Manifest:
+        file_organizer_manifest 1
+        root    <absolute root path>
+        D       <relative folder path>
+        F       <size>  <relative file path>
+
+    Rules file (edit a copy written by save_rule_file):
+        # comment
+        <extension>     <category>
+*/
+
+
+enum class simulation_status
+{
+    ok,
+    manifest_not_found,
+    manifest_corrupt,
+    rules_not_found,
+    rules_corrupt,
+    capture_failed,         // Root unreadable, or manifest not writable
+    write_failed
+};
+
+
+/*
+    Records every folder and file below root_path (hidden folders
+    excluded, like a real run) into manifest_path.
+*/
+simulation_status capture_tree_manifest(const std::string& root_path, const std::string& manifest_path);
+
+/*
+    Reads / writes "extension<TAB>category" rule files.
+*/
+simulation_status load_rule_file(const std::string& rules_path, std::map<std::string, std::string>& extension_lookup);
+simulation_status save_rule_file(const std::string& rules_path, const std::map<std::string, std::string>& extension_lookup);
+
+
+/*
+    outcome_change
+    --------------
+    One difference between the two replays.
+    Paths are relative to the manifest root.
+*/
+enum class change_kind
+{
+    destination_changed,    // File ends up somewhere else
+    new_collision,          // File only gets a numbered name with the candidate rules
+    new_folder              // Folder only created by the candidate rules (file = folder path)
+};
+
+struct outcome_change
+{
+    change_kind kind = change_kind::destination_changed;
+    std::string file;
+    std::string current_destination;
+    std::string candidate_destination;
+};
+
+
+/*
+    simulation_report
+    -----------------
+    Summary numbers plus every single change.
+*/
+struct simulation_report
+{
+    std::size_t files = 0;
+    std::size_t folders = 0;
+
+    std::size_t moves_current = 0;          // Files moved with the current rules
+    std::size_t moves_candidate = 0;        // ... with the candidate rules
+
+    std::size_t destination_changes = 0;
+    std::size_t new_collisions = 0;
+    std::size_t new_folders = 0;
+    std::uint64_t bytes_changing_place = 0;
+
+    double entries_per_second = 0;          // Replay speed (both replays together)
+
+    std::vector<outcome_change> changes;
+};
+
+
+/*
+    Replays the manifest with the built-in rules and with
+    candidate_rules, and diffs the outcomes.
+
+    options selects the optional stages to replay (sanitize,
+    learned routing); shards and all I/O stages are ignored.
+*/
+simulation_status simulate_rules(
+    const std::string& manifest_path,
+    const rule_table& candidate_rules,
+    const organize_options& options,
+    simulation_report& report
+);
+
+/*
+    Writes report.changes as NDJSON, one change per line:
+        {"change":"destination_changed","file":...,"current":...,"candidate":...}
+*/
+simulation_status write_simulation_report(const simulation_report& report, const std::string& report_path);
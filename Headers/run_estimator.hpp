@@ -0,0 +1,125 @@
+#pragma once
+#include "organizer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+    ===============================
+        run_estimator.hpp
+    ===============================
+
+    "How long, and how much will move?" before a run is started.
+
+    WHY THIS EXISTS:
+    ----------------
+    On a large share a full run can take hours, and the only way to
+    know how many files it would move was to start it. The estimator
+    answers in seconds by reading only a small part of the tree.
+
+    HOW IT WORKS:
+    -------------
+    Random descent (Knuth's tree-size estimator):
+
+    1. A probe starts at the root with weight 1
+    2. At every folder it reads, the folder's counts (files, files
+       to move, bytes to move, ...) are added multiplied by the weight
+    3. It descends into ONE subfolder picked at random; the weight is
+       multiplied by the number of subfolders it could have picked
+    4. It stops at a folder without subfolders
+
+    Every probe is an unbiased estimate of the tree totals. Many
+    probes are averaged, and their spread gives a confidence interval.
+
+    Folder reads are cached, so the upper levels are read once no
+    matter how many probes pass through them. Files are classified
+    with the same placement decision as a real run (plan_placement);
+    in very large folders only a random subset is classified and the
+    result is scaled up.
+
+    When the probes happen to read the whole tree, the totals are
+    exact and the intervals collapse to a single value.
+*/
+
+
+/*
+    estimate_policy
+    ---------------
+    Sampling budget and the cost model behind the duration estimate.
+
+    The duration is:
+        entries × cost per entry measured while sampling
+      + moves within a device × seconds_per_rename
+      + cross-device bytes ÷ copy_bytes_per_second
+*/
+struct estimate_policy
+{
+    unsigned probes = 400;                          // Random descents
+    std::size_t max_directories = 2000;             // Stop early once this many folders were read
+    std::size_t max_files_classified = 512;         // Per folder; larger folders are subsampled
+    double confidence_z = 1.96;                     // 95 % intervals
+
+    double seconds_per_rename = 0.0002;
+    double copy_bytes_per_second = 100.0 * 1024 * 1024;
+
+    std::uint64_t seed = 0;                         // 0 = different sample every time
+};
+
+
+enum class estimate_status
+{
+    ok,
+    path_not_found,     // Root does not exist or is not a directory
+    permission_denied   // Root cannot be read
+};
+
+
+/*
+    estimate_interval
+    -----------------
+    Point estimate with its confidence interval.
+    low never goes below what the sample actually saw.
+*/
+struct estimate_interval
+{
+    double value = 0;
+    double low = 0;
+    double high = 0;
+};
+
+
+/*
+    run_estimate
+    ------------
+    Outcome of estimate_run().
+*/
+struct run_estimate
+{
+    estimate_status status = estimate_status::ok;
+    bool exact = false;                     // The whole tree was read
+
+    unsigned probes = 0;
+    std::size_t directories_read = 0;
+    std::size_t entries_read = 0;
+    double sampling_seconds = 0;
+
+    estimate_interval entries;              // Files and folders
+    estimate_interval files;
+    estimate_interval files_to_move;
+    estimate_interval bytes_to_move;
+    estimate_interval cross_device_bytes;   // Moves that have to copy
+    estimate_interval seconds;              // Expected run duration
+};
+
+
+/*
+    Samples root_path and extrapolates what organize_directory would
+    do with options (sanitize and learned routing are honoured,
+    sharding is not). Nothing is moved or created.
+*/
+run_estimate estimate_run(
+    const std::string& root_path,
+    const organize_options& options,
+    const estimate_policy& policy
+);
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/*
+    ===============================
+        run_metrics.hpp
+    ===============================
+
+    Per-phase measurements of an organize run.
+
+    WHY THIS EXISTS:
+    ----------------
+    Wall time alone does not tell WHY a phase is slow. To tune the hot
+    paths we also want cycles, instructions, cache misses and branch
+    mispredicts, attributed to the phase that caused them.
+
+    HOW IT WORKS:
+    -------------
+    - The run is split into phases (scan, normalize, classify, ...)
+    - The organizer calls enter_phase() at every phase boundary.
+      A boundary only reads the clock and charges the wall time since
+      the previous one to the phase that just ended
+    - The counter group is read once per scan batch (sample_counters()),
+      not per phase switch: reading it is a syscall, and a file switches
+      phase several times. The counts since the previous sample are
+      spread over the phases in proportion to their wall time in that
+      interval, so per-phase counters are an estimate at batch
+      granularity; the run totals are exact
+
+    HARDWARE COUNTERS:
+    ------------------
+    On Linux a perf_event_open group is opened for the CALLING thread,
+    so a run_metrics object must be created and used on the worker
+    thread that does the organizing.
+
+    Parallel plan execution (execution_threads > 1) moves files on
+    threads of its own; their counters are NOT included. The report
+    says so in "workers" (the wall time of the transfer phase still
+    covers them: the walking thread waits for them).
+
+    When counters are unavailable (perf_event_paranoid, containers,
+    VMs without a PMU, non-Linux builds) only wall time is collected
+    and the reason is reported instead. This is never an error.
+*/
+
+
+/*
+    run_phase
+    ---------
+    Phases of an organize run.
+
+    none is the "outside any phase" state; time spent there
+    is not charged to anything.
+*/
+enum class run_phase
+{
+    none,
+    scan,           // Reading directory entries
+    normalize,      // Renaming alias folders to canonical names
+    classify,       // Sanitize + classify + placement decision
+    transfer,       // Creating folders, collision check, rename / copy
+    index,          // Persisting the directory index
+    phase_count
+};
+
+
+/*
+    hardware_counter
+    ----------------
+    Counters sampled in the perf group, in group order.
+*/
+enum class hardware_counter
+{
+    cycles,
+    instructions,
+    cache_misses,
+    branch_misses,
+    counter_count
+};
+
+
+/*
+    phase_totals
+    ------------
+    Everything accumulated for a single phase.
+
+    Counter values are scaled when the kernel had to multiplex
+    the group, so they estimate the full-time value.
+*/
+struct phase_totals
+{
+    std::uint64_t wall_ns = 0;
+    std::uint64_t entries = 0;      // How many times the phase was entered
+    std::array<std::uint64_t, static_cast<std::size_t>(hardware_counter::counter_count)> counters{};
+};
+
+
+/*
+    hook_totals
+    -----------
+    Latency of post-move hook invocations (see move_hook.hpp).
+
+    Hooks run on their own threads, outside any phase, so they are
+    tracked separately from the phase table.
+*/
+struct hook_totals
+{
+    std::uint64_t calls = 0;
+    std::uint64_t failures = 0;
+    std::uint64_t files = 0;
+    std::uint64_t total_ns = 0;
+    std::uint64_t max_ns = 0;
+};
+
+
+class run_metrics
+{
+public:
+    /*
+        Starts the clock and, if requested, tries to open the
+        hardware counter group for the calling thread.
+    */
+    explicit run_metrics(bool use_hardware_counters);
+
+    // Closes the counter group
+    ~run_metrics();
+
+    run_metrics(const run_metrics&) = delete;
+    run_metrics& operator=(const run_metrics&) = delete;
+
+    /*
+        Phase boundary: charges the wall time since the previous
+        boundary to the current phase, then makes next_phase current.
+        Entering run_phase::none also takes a final counter sample.
+    */
+    void enter_phase(run_phase next_phase);
+
+    /*
+        Reads the counter group and attributes the counts since the
+        previous sample to the phases, by their share of the wall time
+        in between. Call at batch boundaries, not per file.
+    */
+    void sample_counters();
+
+    /*
+        Records that moves ran on threads worker threads whose hardware
+        counters are not part of this report.
+    */
+    void set_unmeasured_worker_threads(unsigned threads);
+
+    /*
+        True if at least one hardware counter is being sampled.
+    */
+    bool hardware_counters_available() const;
+
+    /*
+        Records one hook invocation covering files moves.
+        Thread-safe: called from the hook sender threads.
+    */
+    void record_hook_call(std::chrono::nanoseconds latency, std::size_t files, bool succeeded);
+
+    /*
+        Counts directory entries read by the scanner, so counters
+        can be reported per entry (e.g. cache misses per file).
+    */
+    void add_scanned_entries(std::size_t count);
+
+    /*
+        Serializes all phases as a JSON object:
+
+        {
+          "total_wall_ms": ...,
+          "scanned_entries": ...,
+          "hardware_counters": { "available": true/false, "reason": "..." },
+          "workers": { "threads": ..., "hardware_counters": false },
+          "phases": {
+            "scan": { "wall_ms": ..., "entries": ..., "cycles": ..., ... },
+            ...
+          },
+          "hooks": { "calls": ..., "files": ..., "failures": ...,
+                     "mean_ms": ..., "max_ms": ... }
+        }
+
+        With cache misses available, every phase also reports
+        "cache_misses_per_entry" (divided by scanned_entries).
+
+        Counters that could not be opened are omitted per phase;
+        "workers" is omitted when no parallel workers ran, "hooks"
+        when no hook ran.
+    */
+    std::string to_json() const;
+
+private:
+    struct counter_sample
+    {
+        std::uint64_t time_enabled = 0;
+        std::uint64_t time_running = 0;
+        std::array<std::uint64_t, static_cast<std::size_t>(hardware_counter::counter_count)> values{};
+    };
+
+    bool read_counters(counter_sample& sample) const;
+
+    // File descriptors of the perf group, -1 if not opened
+    int group_leader = -1;
+    std::array<int, static_cast<std::size_t>(hardware_counter::counter_count)> counter_fds;
+
+    // Position of each counter in a group read, -1 if not opened
+    std::array<int, static_cast<std::size_t>(hardware_counter::counter_count)> counter_slots;
+    int opened_counters = 0;
+
+    std::string unavailable_reason;
+
+    run_phase current_phase = run_phase::none;
+    std::chrono::steady_clock::time_point run_start;
+    std::chrono::steady_clock::time_point last_time;
+    counter_sample last_sample;
+
+    std::array<phase_totals, static_cast<std::size_t>(run_phase::phase_count)> totals;
+    std::uint64_t scanned_entries = 0;
+    unsigned unmeasured_worker_threads = 0;
+
+    // Wall time per phase since the last counter sample
+    std::array<std::uint64_t, static_cast<std::size_t>(run_phase::phase_count)> unsampled_wall_ns{};
+
+    mutable std::mutex hook_mutex;
+    hook_totals hooks;
+};
+
+
+/*
+    write_metrics_file
+    ------------------
+    Writes metrics.to_json() to "<root>/.file_organizer/metrics.json".
+
+    Returns false if the file could not be written.
+*/
+bool write_metrics_file(const std::string& root_path, const run_metrics& metrics);
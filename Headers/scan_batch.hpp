@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+    ===============================
+        scan_batch.hpp
+    ===============================
+
+    Directory scanning in struct-of-arrays batches.
+
+    WHY THIS EXISTS:
+    ----------------
+    Walking with std::filesystem::directory_iterator costs one
+    heap-allocated directory_entry, several path strings and up to two
+    stat() calls (is_regular_file, is_directory) per entry, each of
+    which resolves the full path from the root again.
+
+    The scanner instead reads a directory into a batch of dense arrays:
+
+        name_blob      "photo.jpgnotes.txtDocs..."   (one allocation)
+        name_offsets   [0, 9, 18, 22, ...]           (size + 1 entries)
+        types          [file, file, directory, ...]
+        sizes          [...]
+        mtimes_ns      [...]
+        inodes         [...]
+
+    Classification and planning then stream over these arrays, and a
+    full path string is only built for files that actually move.
+    Metadata comes from one fstatat() per entry, relative to the open
+    directory, so no path lookup from the root is repeated.
+
+    Batches are reused between calls, so a steady-state scan does not
+    allocate at all.
+
+    Builds without POSIX directory streams (Windows) fill the same
+    batches from std::filesystem::directory_iterator.
+*/
+
+
+/*
+    scan_entry_type
+    ---------------
+    Symlinks are followed, exactly like std::filesystem::is_regular_file
+    did in the old loop: a link to a file counts as a file.
+*/
+enum class scan_entry_type : std::uint8_t
+{
+    regular_file,
+    directory,
+    other           // Sockets, devices, dangling links, ...
+};
+
+
+/*
+    scan_status
+    -----------
+    Outcome of opening / reading a directory.
+*/
+enum class scan_status
+{
+    ok,                 // Batch filled (may be the last one)
+    end_of_directory,   // Nothing left, batch is empty
+    permission_denied,
+    failed
+};
+
+
+/*
+    scan_batch
+    ----------
+    Up to max_entries entries of one directory in struct-of-arrays form.
+    "." and ".." are never included.
+*/
+struct scan_batch
+{
+    std::string name_blob;
+    std::vector<std::uint32_t> name_offsets;     // Entry i: [offsets[i], offsets[i + 1])
+    std::vector<scan_entry_type> types;
+    std::vector<std::uint64_t> sizes;
+    std::vector<std::int64_t> mtimes_ns;
+    std::vector<std::uint64_t> inodes;
+
+    std::size_t size() const
+    {
+        return types.size();
+    }
+
+    std::string_view name(std::size_t i) const
+    {
+        return std::string_view(name_blob).substr(name_offsets[i], name_offsets[i + 1] - name_offsets[i]);
+    }
+
+    // Keeps capacity, so the next batch reuses the same memory
+    void clear();
+};
+
+
+/*
+    directory_scanner
+    -----------------
+    Reads one directory batch by batch.
+*/
+class directory_scanner
+{
+public:
+    directory_scanner() = default;
+    ~directory_scanner();
+
+    directory_scanner(const directory_scanner&) = delete;
+    directory_scanner& operator=(const directory_scanner&) = delete;
+
+    scan_status open(const std::string& directory_path);
+
+    /*
+        Opens only the part of the directory whose positions lie in
+        [start, end): the stream is moved to start with seekdir(), and
+        next_batch() stops before the first entry at or past end.
+
+        Only meaningful where positions (telldir cookies) are ordered
+        hash values, see partitioned_scan.hpp. Not supported without
+        POSIX directory streams (returns failed).
+    */
+    scan_status open_range(const std::string& directory_path, std::uint64_t start, std::uint64_t end);
+
+    /*
+        Clears batch and fills it with up to max_entries entries.
+        Returns end_of_directory once everything has been read.
+    */
+    scan_status next_batch(scan_batch& batch, std::size_t max_entries = 1024);
+
+private:
+    void* directory_stream = nullptr;   // DIR* (kept opaque for the header)
+    std::uint64_t range_end = UINT64_MAX;
+
+    // Used instead of directory_stream on non-POSIX builds
+    std::filesystem::directory_iterator fallback_iterator;
+};
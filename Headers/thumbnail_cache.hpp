@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+    ===============================
+        thumbnail_cache.hpp
+    ===============================
+
+    Pre-generates freedesktop.org thumbnails for organized images.
+
+    WHY THIS EXISTS:
+    ----------------
+    Right after a photo dump has been organized, the user opens the
+    category folders in a file manager, which then generates every
+    thumbnail on demand. Doing that work in the background while the
+    user is still reading the result dialog hides most of the wait.
+
+    SPEC:
+    -----
+    Thumbnail Managing Standard (freedesktop.org):
+    - "$XDG_CACHE_HOME/thumbnails/{normal,large}/<md5(uri)>.png"
+      (XDG_CACHE_HOME defaults to ~/.cache)
+    - normal = at most 128 px, large = at most 256 px
+    - PNG text chunks Thumb::URI and Thumb::MTime identify the source;
+      a thumbnail is valid only if both still match
+    - files are written atomically with mode 0600
+
+    This part of the project uses Qt (QImageReader), like the GUI,
+    and is only driven from the GUI after a run has finished, so it
+    never delays the organize itself.
+*/
+
+
+enum class thumbnail_flavor
+{
+    normal,     // 128 x 128
+    large       // 256 x 256
+};
+
+
+/*
+    thumbnail_policy
+    ----------------
+    Disabled by default.
+*/
+struct thumbnail_policy
+{
+    bool enabled = false;
+    thumbnail_flavor flavor = thumbnail_flavor::normal;
+
+    unsigned max_threads = 2;       // Decoders running at once
+    unsigned max_per_second = 20;   // Across all threads; 0 = unlimited
+};
+
+
+enum class thumbnail_status
+{
+    created,
+    already_valid,      // Up-to-date thumbnail found, nothing written
+    unreadable,         // Not an image Qt can decode
+    write_failed
+};
+
+
+/*
+    thumbnail_summary
+    -----------------
+    Result of a pre-generation pass.
+*/
+struct thumbnail_summary
+{
+    std::size_t created = 0;
+    std::size_t already_valid = 0;
+    std::size_t failed = 0;
+};
+
+
+/*
+    "<cache>/thumbnails/normal" or ".../large"
+*/
+std::filesystem::path thumbnail_cache_directory(thumbnail_flavor flavor);
+
+/*
+    Generates the thumbnail of one image unless a valid one exists.
+*/
+thumbnail_status generate_thumbnail(const std::filesystem::path& image_path, thumbnail_flavor flavor);
+
+/*
+    Generates thumbnails for all images on up to max_threads threads,
+    rate-limited to max_per_second. Stops early once *stop_requested
+    becomes true.
+*/
+thumbnail_summary pregenerate_thumbnails(
+    const std::vector<std::filesystem::path>& image_paths,
+    const thumbnail_policy& policy,
+    const std::atomic<bool>* stop_requested
+);
+
+
+/*
+    placed_image_collector
+    ----------------------
+    Remembers the destinations of moved image files.
+
+    Meant to be fed from organize_options::on_file_moved, which may
+    be called from several worker threads at once.
+*/
+class placed_image_collector
+{
+public:
+    // Keeps destination if it is classified as an image
+    void add(const std::filesystem::path& destination);
+
+    // Returns everything collected so far and starts over
+    std::vector<std::filesystem::path> take();
+
+private:
+    std::mutex mutex;
+    std::vector<std::filesystem::path> images;
+};
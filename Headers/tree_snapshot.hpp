@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+/*
+    ===============================
+        tree_snapshot.hpp
+    ===============================
+
+    What changed in a share between two runs.
+
+    WHY THIS EXISTS:
+    ----------------
+    Between two organize runs users add, delete and move files by
+    hand. Finding out which ones used to take a full comparison of
+    two walks held in memory.
+
+    HOW IT WORKS:
+    -------------
+    - After a run (organize_options::record_snapshot), every file
+      below the root is written to a compact snapshot, SORTED by
+      path: (path, inode, size, modification time)
+    - The live tree can be walked in the same order (every folder is
+      read and sorted before descending)
+    - A diff is then one streaming merge of two sorted sequences, like
+      the merge of a sorted move plan: memory is bounded by the
+      deepest folder chain plus the changes found, never by the tree
+    - Files that vanished at one path and appeared at another with
+      the same inode, size and modification time were moved
+
+    Paths are ordered component by component ("a/b" < "a.txt"), which
+    is the order of a walk that visits sorted names depth first.
+    Hidden folders are skipped, like in a real run.
+
+    SNAPSHOT FORMAT (binary, integers as LEB128 varints):
+    -----------------------------------------------------
+        "FOSNAP1\n"
+        root length, root path (absolute)
+        entry count (8 bytes, little endian)
+        per entry:
+            bytes shared with the previous path, suffix length, suffix
+            inode, size, modification time (ns, zigzag)
+
+    Sorted paths share long prefixes, so an entry takes around
+    15-25 bytes.
+
+    REPORT FORMAT:
+    --------------
+    NDJSON with the "source" / "destination" keys of the move hook
+    log (absolute paths), plus what happened:
+
+        {"change":"moved","source":"/a/x.jpg","destination":"/a/b/x.jpg"}
+        {"change":"added","destination":"/a/new.pdf"}
+        {"change":"removed","source":"/a/old.pdf"}
+        {"change":"modified","source":"/a/doc.txt","destination":"/a/doc.txt"}
+*/
+
+
+enum class snapshot_status
+{
+    ok,
+    root_not_found,
+    snapshot_not_found,
+    snapshot_corrupt,
+    write_failed
+};
+
+
+/*
+    snapshot_diff_summary
+    ---------------------
+    Counts of a diff; every single change is in the report file.
+*/
+struct snapshot_diff_summary
+{
+    std::size_t old_entries = 0;
+    std::size_t new_entries = 0;
+
+    std::size_t added = 0;
+    std::size_t removed = 0;
+    std::size_t moved = 0;
+    std::size_t modified = 0;
+
+    double seconds = 0;
+};
+
+
+/*
+    "<root>/.file_organizer/snapshot.bin" (latest run) and
+    "<root>/.file_organizer/snapshot.previous.bin" (the run before).
+*/
+std::filesystem::path get_snapshot_path(const std::string& root_path);
+std::filesystem::path get_previous_snapshot_path(const std::string& root_path);
+
+
+/*
+    Walks root_path and writes its snapshot to snapshot_path.
+
+    The snapshot is written under a temporary name and renamed into
+    place, so a reader never sees half a snapshot.
+*/
+snapshot_status write_tree_snapshot(const std::string& root_path, const std::filesystem::path& snapshot_path);
+
+/*
+    Snapshot after a run: the latest snapshot becomes the previous
+    one, and a new one is written.
+*/
+snapshot_status record_tree_snapshot(const std::string& root_path);
+
+
+/*
+    Diffs two snapshots, writing one NDJSON line per change to
+    report_path.
+*/
+snapshot_status diff_snapshots(
+    const std::filesystem::path& old_snapshot_path,
+    const std::filesystem::path& new_snapshot_path,
+    const std::string& report_path,
+    snapshot_diff_summary& summary
+);
+
+/*
+    Same, with the live tree below root_path as the new side.
+*/
+snapshot_status diff_snapshot_against_tree(
+    const std::filesystem::path& snapshot_path,
+    const std::string& root_path,
+    const std::string& report_path,
+    snapshot_diff_summary& summary
+);
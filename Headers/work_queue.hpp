@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/*
+    ===============================
+        work_queue.hpp
+    ===============================
+
+    Bounded blocking queue used to hand work to worker threads.
+
+    - push() blocks while the queue is full, so a fast producer
+      (e.g. the plan merge) never buffers unbounded work in memory
+    - pop() blocks while the queue is empty
+    - close() wakes everybody up: pushes are rejected, pops drain
+      what is left and then return false
+*/
+template <typename T>
+class work_queue
+{
+public:
+    explicit work_queue(std::size_t capacity)
+        : capacity(capacity == 0 ? 1 : capacity)
+    {
+    }
+
+    /*
+        Returns false if the queue was closed (item is dropped).
+    */
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this] { return closed || items.size() < capacity; });
+
+        if (closed)
+        {
+            return false;
+        }
+
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+        return true;
+    }
+
+    /*
+        Returns false once the queue is closed AND empty.
+    */
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return closed || !items.empty(); });
+
+        if (items.empty())
+        {
+            return false;
+        }
+
+        item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+private:
+    std::size_t capacity;
+    bool closed = false;
+
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+};
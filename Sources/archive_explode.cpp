@@ -0,0 +1,1336 @@
+#include "archive_explode.hpp"
+#include "extensions.hpp"
+#include "filesystem_utils.hpp"
+#include "memory_governor.hpp"
+#include "move_plan.hpp"
+#include "work_queue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ARCHIVE_EXPLODE_POSIX 1
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <zlib.h>
+
+extern char** environ;
+#endif
+
+// Full and smallest I/O buffer (the governor picks in between)
+static const std::size_t IO_BLOCK = 1024 * 1024;
+static const std::size_t MIN_IO_BLOCK = 64 * 1024;
+
+// Decompressed blocks waiting between the gzip thread and the tar reader
+static const std::size_t GZIP_QUEUE_BLOCKS = 4;
+
+static const std::size_t TAR_BLOCK = 512;
+
+/*
+    =========================================================
+        detect_archive_format
+    =========================================================
+*/
+archive_format detect_archive_format(const std::filesystem::path& archive_path)
+{
+    unsigned char head[TAR_BLOCK] = {};
+    std::FILE* file = std::fopen(archive_path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return archive_format::none;
+    }
+    std::size_t got = std::fread(head, 1, sizeof(head), file);
+    std::fclose(file);
+
+    auto starts_with = [&](std::initializer_list<unsigned char> magic)
+    {
+        return got >= magic.size() && std::equal(magic.begin(), magic.end(), head);
+    };
+
+    if (starts_with({'P', 'K', 3, 4}) || starts_with({'P', 'K', 5, 6}))
+    {
+        return archive_format::zip;
+    }
+    if (starts_with({0x1F, 0x8B}))
+    {
+        return archive_format::tar_gzip;
+    }
+    if (starts_with({'B', 'Z', 'h'}))
+    {
+        return archive_format::tar_bzip2;
+    }
+    if (starts_with({0xFD, '7', 'z', 'X', 'Z', 0x00}))
+    {
+        return archive_format::tar_xz;
+    }
+    if (starts_with({0x28, 0xB5, 0x2F, 0xFD}))
+    {
+        return archive_format::tar_zstd;
+    }
+    if (got == TAR_BLOCK && std::memcmp(head + 257, "ustar", 5) == 0)
+    {
+        return archive_format::tar;
+    }
+    return archive_format::none;
+}
+
+#if defined(ARCHIVE_EXPLODE_POSIX)
+
+/*
+    Last path component of a member name ("a/b/photo.jpg" -> "photo.jpg").
+*/
+static std::string member_basename(std::string member_path)
+{
+    while (!member_path.empty() && member_path.back() == '/')
+    {
+        member_path.pop_back();
+    }
+    std::size_t slash = member_path.find_last_of('/');
+    return slash == std::string::npos ? member_path : member_path.substr(slash + 1);
+}
+
+
+/*
+    =========================================================
+        member_writer
+    =========================================================
+
+    Writes one member at a time: temporary file in the partial folder
+    of its destination, then a no-replace rename to a free name.
+*/
+class member_writer
+{
+public:
+    member_writer(const std::string& destination_root, const organize_options& options)
+        : destination_root(destination_root), options(options)
+    {
+    }
+
+    ~member_writer()
+    {
+        abort_member();
+
+        // Partial folders are removed once empty (rmdir fails otherwise)
+        for (const std::filesystem::path& folder : partial_folders)
+        {
+            rmdir(folder.c_str());
+        }
+    }
+
+    /*
+        Starts a member; false (and skip) if its name is unusable,
+        with failed set if the temporary file cannot be created.
+    */
+    bool begin(const std::string& member_path, std::int64_t mtime_seconds, bool& failed)
+    {
+        failed = false;
+        std::string filename = member_basename(member_path);
+        if (filename.empty() || filename == "." || filename == "..")
+        {
+            return false;
+        }
+
+        planned_move move;
+        if (plan_placement(destination_root, filename, options, builtin_rule_table(), move) == organize_status::success)
+        {
+            destination_directory = move.destination_directory;
+            target_filename = move.target_filename;
+        }
+        else
+        {
+            destination_directory = destination_root;
+            target_filename = filename;
+        }
+
+        std::error_code ec;
+        std::filesystem::path partial_folder = std::filesystem::path(destination_directory) / PARTIAL_FOLDER_NAME;
+        std::filesystem::create_directories(partial_folder, ec);
+        partial_folders.insert(partial_folder);
+
+        temp_path = partial_folder / ("explode-" + std::to_string(getpid()) + "-" + std::to_string(counter++));
+        fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        if (fd < 0)
+        {
+            failed = true;
+            return false;
+        }
+
+        current_member = member_path;
+        mtime = mtime_seconds;
+        member_bytes = 0;
+        return true;
+    }
+
+    bool write(const char* data, std::size_t length)
+    {
+        member_bytes += length;
+        return write_all_bytes(fd, data, length);
+    }
+
+    /*
+        Publishes the member under a collision-free name
+        ("photo.jpg", "photo(1).jpg", ...).
+    */
+    bool commit(const exploded_member_callback& on_member, std::filesystem::path& final_path)
+    {
+        struct timespec times[2];
+        times[0].tv_sec = mtime;
+        times[0].tv_nsec = 0;
+        times[1] = times[0];
+        futimens(fd, times);
+
+        bool closed = ::close(fd) == 0;
+        fd = -1;
+        if (!closed)
+        {
+            abort_member();
+            return false;
+        }
+
+        if (transfer_to_unique_path(temp_path, destination_directory, target_filename, atomic_transfer_to_path, &final_path)
+            != file_move_status::successful_transfer)
+        {
+            abort_member();
+            return false;
+        }
+
+        temp_path.clear();
+        written += member_bytes;
+        if (on_member)
+        {
+            on_member(current_member, final_path);
+        }
+        return true;
+    }
+
+    void abort_member()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+        if (!temp_path.empty())
+        {
+            unlink(temp_path.c_str());
+            temp_path.clear();
+        }
+    }
+
+    // Bytes of the members published so far
+    std::uint64_t bytes_written() const
+    {
+        return written;
+    }
+
+private:
+    std::string destination_root;
+    const organize_options& options;
+
+    std::set<std::filesystem::path> partial_folders;
+    std::uint64_t counter = 0;
+    std::uint64_t written = 0;
+
+    std::string current_member;
+    std::string destination_directory;
+    std::string target_filename;
+    std::filesystem::path temp_path;
+    std::int64_t mtime = 0;
+    std::uint64_t member_bytes = 0;
+    int fd = -1;
+};
+
+
+/*
+    =========================================================
+        byte sources (tar input)
+    =========================================================
+
+    read() returns the number of bytes read, 0 at the end, -1 on error.
+    finish() is false if decompression failed.
+*/
+class byte_source
+{
+public:
+    virtual ~byte_source() = default;
+    virtual ssize_t read(char* data, std::size_t length) = 0;
+    virtual bool finish()
+    {
+        return true;
+    }
+};
+
+// Uncompressed tar
+class file_source : public byte_source
+{
+public:
+    explicit file_source(int fd) : fd(fd)
+    {
+    }
+
+    ssize_t read(char* data, std::size_t length) override
+    {
+        ssize_t n;
+        do
+        {
+            n = ::read(fd, data, length);
+        }
+        while (n < 0 && errno == EINTR);
+        return n;
+    }
+
+private:
+    int fd;
+};
+
+/*
+    gzip, inflated by zlib on a thread of its own, so inflating the
+    next block overlaps with writing the previous one. Concatenated
+    gzip members (as written by pigz or "cat a.gz b.gz") are followed.
+*/
+class gzip_source : public byte_source
+{
+public:
+    explicit gzip_source(int fd)
+        : fd(fd), blocks(GZIP_QUEUE_BLOCKS)
+    {
+        producer = std::thread(&gzip_source::inflate_all, this);
+    }
+
+    ~gzip_source() override
+    {
+        blocks.close();         // Unblocks the producer if we stopped early
+        producer.join();
+    }
+
+    ssize_t read(char* data, std::size_t length) override
+    {
+        if (offset == current.size())
+        {
+            current.clear();
+            offset = 0;
+            if (!blocks.pop(current))
+            {
+                return failed ? -1 : 0;
+            }
+        }
+        std::size_t n = std::min(length, current.size() - offset);
+        std::memcpy(data, current.data() + offset, n);
+        offset += n;
+        return static_cast<ssize_t>(n);
+    }
+
+    bool finish() override
+    {
+        return !failed;
+    }
+
+private:
+    void inflate_all()
+    {
+        z_stream stream{};
+        if (inflateInit2(&stream, 15 + 32) != Z_OK)     // 32: gzip header expected
+        {
+            failed = true;
+            blocks.close();
+            return;
+        }
+
+        std::size_t block_size = memory_governor::shared().scaled(IO_BLOCK, MIN_IO_BLOCK);
+        std::vector<unsigned char> input(block_size);
+        bool at_end = false;
+        bool stream_ended = false;
+
+        while (!at_end)
+        {
+            ssize_t n = ::read(fd, input.data(), input.size());
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n < 0)
+            {
+                failed = true;
+                break;
+            }
+            if (n == 0)
+            {
+                failed = !stream_ended;     // Truncated stream
+                break;
+            }
+
+            stream.next_in = input.data();
+            stream.avail_in = static_cast<uInt>(n);
+
+            while (stream.avail_in > 0)
+            {
+                std::vector<char> output(block_size);
+                stream.next_out = reinterpret_cast<Bytef*>(output.data());
+                stream.avail_out = static_cast<uInt>(output.size());
+
+                int result = inflate(&stream, Z_NO_FLUSH);
+                if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+                {
+                    failed = true;
+                    at_end = true;
+                    break;
+                }
+
+                output.resize(output.size() - stream.avail_out);
+                if (!output.empty() && !blocks.push(std::move(output)))
+                {
+                    at_end = true;      // Reader gave up
+                    break;
+                }
+
+                stream_ended = (result == Z_STREAM_END);
+                if (stream_ended)
+                {
+                    inflateReset(&stream);      // Next gzip member, if any
+                }
+                else if (result == Z_BUF_ERROR)
+                {
+                    break;
+                }
+            }
+        }
+
+        inflateEnd(&stream);
+        blocks.close();
+    }
+
+    int fd;
+    work_queue<std::vector<char>> blocks;
+    std::thread producer;
+    std::atomic<bool> failed{false};
+
+    std::vector<char> current;
+    std::size_t offset = 0;
+};
+
+/*
+    bzip2 / xz / zstd through their command line tool:
+    archive on stdin, tar on stdout.
+*/
+class process_source : public byte_source
+{
+public:
+    process_source(int archive_fd, const std::vector<std::string>& command)
+    {
+        int pipe_fds[2];
+        if (pipe2(pipe_fds, O_CLOEXEC) == -1)
+        {
+            return;
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, archive_fd, STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+
+        // The child starts with default signal handling, so closing the pipe ends it
+        posix_spawnattr_t attributes;
+        posix_spawnattr_init(&attributes);
+        sigset_t empty_mask;
+        sigset_t default_signals;
+        sigemptyset(&empty_mask);
+        sigemptyset(&default_signals);
+        sigaddset(&default_signals, SIGPIPE);
+        posix_spawnattr_setsigmask(&attributes, &empty_mask);
+        posix_spawnattr_setsigdefault(&attributes, &default_signals);
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+        std::vector<char*> argv;
+        for (const std::string& argument : command)
+        {
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        int spawn_result = posix_spawnp(&child, argv[0], &actions, &attributes, argv.data(), environ);
+
+        posix_spawn_file_actions_destroy(&actions);
+        posix_spawnattr_destroy(&attributes);
+        ::close(pipe_fds[1]);
+
+        if (spawn_result != 0)
+        {
+            child = -1;
+            ::close(pipe_fds[0]);
+            return;
+        }
+        output_fd = pipe_fds[0];
+    }
+
+    ~process_source() override
+    {
+        finish();
+    }
+
+    bool started() const
+    {
+        return child > 0;
+    }
+
+    ssize_t read(char* data, std::size_t length) override
+    {
+        ssize_t n;
+        do
+        {
+            n = ::read(output_fd, data, length);
+        }
+        while (n < 0 && errno == EINTR);
+        return n;
+    }
+
+    /*
+        Waits for the tool; true if it exited with status 0. The rest
+        of its output (tar end-of-archive padding) is read first, so
+        the tool is not killed by SIGPIPE.
+    */
+    bool finish() override
+    {
+        if (output_fd >= 0)
+        {
+            char rest[TAR_BLOCK * 16];
+            while (read(rest, sizeof(rest)) > 0)
+            {
+            }
+            ::close(output_fd);
+            output_fd = -1;
+        }
+        if (child > 0)
+        {
+            int wait_status = 0;
+            while (waitpid(child, &wait_status, 0) == -1 && errno == EINTR)
+            {
+            }
+            succeeded = WIFEXITED(wait_status) && WEXITSTATUS(wait_status) == 0;
+            child = -1;
+        }
+        return succeeded;
+    }
+
+private:
+    pid_t child = -1;
+    int output_fd = -1;
+    bool succeeded = false;
+};
+
+
+/*
+    =========================================================
+        explode_tar
+    =========================================================
+*/
+
+/*
+    Buffered reads over a byte_source.
+*/
+class tar_reader
+{
+public:
+    explicit tar_reader(byte_source& source)
+        : source(source), buffer(memory_governor::shared().scaled(IO_BLOCK, MIN_IO_BLOCK))
+    {
+    }
+
+    // Fills up to length bytes; returns how many (short only at the end or on error)
+    std::size_t read(char* data, std::size_t length)
+    {
+        std::size_t done = 0;
+        while (done < length)
+        {
+            if (position == filled)
+            {
+                ssize_t n = source.read(buffer.data(), buffer.size());
+                if (n <= 0)
+                {
+                    failed = failed || n < 0;
+                    break;
+                }
+                filled = static_cast<std::size_t>(n);
+                position = 0;
+            }
+            std::size_t n = std::min(length - done, filled - position);
+            std::memcpy(data + done, buffer.data() + position, n);
+            position += n;
+            done += n;
+        }
+        return done;
+    }
+
+    /*
+        Hands out up to length bytes without copying them: data points
+        into the internal buffer until the next call.
+    */
+    std::size_t peek(const char*& data, std::size_t length)
+    {
+        if (position == filled)
+        {
+            ssize_t n = source.read(buffer.data(), buffer.size());
+            if (n <= 0)
+            {
+                failed = failed || n < 0;
+                return 0;
+            }
+            filled = static_cast<std::size_t>(n);
+            position = 0;
+        }
+        std::size_t n = std::min(length, filled - position);
+        data = buffer.data() + position;
+        position += n;
+        return n;
+    }
+
+    bool skip(std::uint64_t length)
+    {
+        const char* ignored = nullptr;
+        while (length > 0)
+        {
+            std::size_t n = peek(ignored, static_cast<std::size_t>(std::min<std::uint64_t>(length, buffer.size())));
+            if (n == 0)
+            {
+                return false;
+            }
+            length -= n;
+        }
+        return true;
+    }
+
+    bool failed = false;
+
+private:
+    byte_source& source;
+    std::vector<char> buffer;
+    std::size_t position = 0;
+    std::size_t filled = 0;
+};
+
+/*
+    Numeric tar field: octal text, or base-256 when the top bit of the
+    first byte is set (GNU, sizes of 8 GiB and more).
+*/
+static std::uint64_t tar_number(const char* field, std::size_t length)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(field);
+    std::uint64_t value = 0;
+
+    if (bytes[0] & 0x80)
+    {
+        value = bytes[0] & 0x7F;
+        for (std::size_t i = 1; i < length; i++)
+        {
+            value = (value << 8) | bytes[i];
+        }
+        return value;
+    }
+
+    std::size_t i = 0;
+    while (i < length && (field[i] == ' ' || field[i] == '\0'))
+    {
+        i++;
+    }
+    for (; i < length && field[i] >= '0' && field[i] <= '7'; i++)
+    {
+        value = value * 8 + static_cast<std::uint64_t>(field[i] - '0');
+    }
+    return value;
+}
+
+static bool tar_checksum_ok(const unsigned char* header)
+{
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < TAR_BLOCK; i++)
+    {
+        sum += (i >= 148 && i < 156) ? ' ' : header[i];
+    }
+    return sum == tar_number(reinterpret_cast<const char*>(header) + 148, 8);
+}
+
+static std::string tar_string(const char* field, std::size_t length)
+{
+    return std::string(field, strnlen(field, length));
+}
+
+/*
+    path / size / mtime from pax extended header records
+    ("<length> <key>=<value>\n").
+*/
+static void parse_pax(const std::string& records, std::string& path, std::uint64_t& size, bool& has_size, std::int64_t& mtime)
+{
+    std::size_t position = 0;
+    while (position < records.size())
+    {
+        std::size_t space = records.find(' ', position);
+        if (space == std::string::npos)
+        {
+            return;
+        }
+        std::uint64_t length = std::strtoull(records.c_str() + position, nullptr, 10);
+        if (length == 0 || position + length > records.size())
+        {
+            return;
+        }
+
+        std::string record = records.substr(space + 1, position + length - space - 2);     // Without '\n'
+        std::size_t equals = record.find('=');
+        if (equals != std::string::npos)
+        {
+            std::string key = record.substr(0, equals);
+            std::string value = record.substr(equals + 1);
+            if (key == "path")
+            {
+                path = value;
+            }
+            else if (key == "size")
+            {
+                size = std::strtoull(value.c_str(), nullptr, 10);
+                has_size = true;
+            }
+            else if (key == "mtime")
+            {
+                mtime = std::strtoll(value.c_str(), nullptr, 10);
+            }
+        }
+        position += length;
+    }
+}
+
+static void explode_tar(byte_source& source, member_writer& writer, const exploded_member_callback& on_member, explode_summary& summary)
+{
+    tar_reader reader(source);
+    unsigned char header[TAR_BLOCK];
+
+    // Overrides for the next member from GNU long-name or pax headers
+    std::string next_path;
+    std::uint64_t next_size = 0;
+    bool has_next_size = false;
+    std::int64_t next_mtime = -1;
+
+    for (;;)
+    {
+        std::size_t got = reader.read(reinterpret_cast<char*>(header), TAR_BLOCK);
+        if (got == 0 && !reader.failed)
+        {
+            return;     // End without the two zero blocks: accepted, like GNU tar
+        }
+        if (got != TAR_BLOCK)
+        {
+            summary.status = reader.failed ? explode_status::decompressor_failed : explode_status::corrupt;
+            return;
+        }
+        if (std::all_of(header, header + TAR_BLOCK, [](unsigned char c) { return c == 0; }))
+        {
+            return;     // End-of-archive marker
+        }
+        if (!tar_checksum_ok(header))
+        {
+            summary.status = explode_status::corrupt;
+            return;
+        }
+
+        const char* fields = reinterpret_cast<const char*>(header);
+        char type = fields[156];
+        std::uint64_t size = has_next_size ? next_size : tar_number(fields + 124, 12);
+        std::int64_t mtime = next_mtime >= 0 ? next_mtime : static_cast<std::int64_t>(tar_number(fields + 136, 12));
+        std::uint64_t padding = (TAR_BLOCK - size % TAR_BLOCK) % TAR_BLOCK;
+
+        std::string path = next_path;
+        if (path.empty())
+        {
+            path = tar_string(fields, 100);
+            if (std::memcmp(fields + 257, "ustar", 5) == 0 && fields[345] != '\0')
+            {
+                path = tar_string(fields + 345, 155) + "/" + path;
+            }
+        }
+
+        // Long names and pax records describe the NEXT header
+        if (type == 'L' || type == 'x')
+        {
+            if (size > 1024 * 1024)
+            {
+                summary.status = explode_status::corrupt;
+                return;
+            }
+            std::string data(static_cast<std::size_t>(size), '\0');
+            if (reader.read(data.data(), data.size()) != data.size() || !reader.skip(padding))
+            {
+                summary.status = explode_status::corrupt;
+                return;
+            }
+
+            if (type == 'L')
+            {
+                next_path = tar_string(data.data(), data.size());
+            }
+            else
+            {
+                parse_pax(data, next_path, next_size, has_next_size, next_mtime);
+            }
+            continue;
+        }
+
+        next_path.clear();
+        has_next_size = false;
+        next_mtime = -1;
+
+        bool regular = (type == '0' || type == '\0' || type == '7');
+        if (!regular)
+        {
+            if (type != '5' && type != 'g')
+            {
+                summary.skipped++;      // Links, devices, FIFOs, ...
+            }
+            if (!reader.skip(size + padding))
+            {
+                summary.status = explode_status::corrupt;
+                return;
+            }
+            continue;
+        }
+
+        bool failed = false;
+        if (!writer.begin(path, mtime, failed))
+        {
+            if (failed)
+            {
+                summary.status = explode_status::write_failed;
+                return;
+            }
+            summary.skipped++;
+            if (!reader.skip(size + padding))
+            {
+                summary.status = explode_status::corrupt;
+                return;
+            }
+            continue;
+        }
+
+        std::uint64_t remaining = size;
+        while (remaining > 0)
+        {
+            const char* data = nullptr;
+            std::size_t n = reader.peek(data, static_cast<std::size_t>(std::min<std::uint64_t>(remaining, IO_BLOCK)));
+            if (n == 0)
+            {
+                writer.abort_member();
+                summary.status = reader.failed ? explode_status::decompressor_failed : explode_status::corrupt;
+                return;
+            }
+            if (!writer.write(data, n))
+            {
+                writer.abort_member();
+                summary.status = explode_status::write_failed;
+                return;
+            }
+            remaining -= n;
+        }
+
+        std::filesystem::path final_path;
+        if (!reader.skip(padding))
+        {
+            writer.abort_member();
+            summary.status = explode_status::corrupt;
+            return;
+        }
+        if (!writer.commit(on_member, final_path))
+        {
+            summary.status = explode_status::write_failed;
+            return;
+        }
+        summary.members++;
+    }
+}
+
+
+/*
+    =========================================================
+        explode_zip
+    =========================================================
+*/
+static std::uint16_t le16(const unsigned char* p)
+{
+    return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+}
+
+static std::uint32_t le32(const unsigned char* p)
+{
+    return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8)
+         | (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+static std::uint64_t le64(const unsigned char* p)
+{
+    return static_cast<std::uint64_t>(le32(p)) | (static_cast<std::uint64_t>(le32(p + 4)) << 32);
+}
+
+static bool read_at(int fd, std::uint64_t offset, void* data, std::size_t length)
+{
+    char* out = static_cast<char*>(data);
+    while (length > 0)
+    {
+        ssize_t n = pread(fd, out, length, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        out += n;
+        offset += static_cast<std::uint64_t>(n);
+        length -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+/*
+    One central directory entry, with zip64 sizes applied.
+*/
+struct zip_member
+{
+    std::string name;
+    std::uint16_t flags = 0;
+    std::uint16_t method = 0;
+    std::uint32_t crc = 0;
+    std::uint64_t compressed_size = 0;
+    std::uint64_t size = 0;
+    std::uint64_t local_header_offset = 0;
+    std::int64_t mtime = 0;
+    bool symlink = false;
+};
+
+// MS-DOS date and time (local time) to seconds since the epoch
+static std::int64_t dos_time(std::uint16_t time, std::uint16_t date)
+{
+    std::tm parts{};
+    parts.tm_year = ((date >> 9) & 0x7F) + 80;
+    parts.tm_mon = ((date >> 5) & 0x0F) - 1;
+    parts.tm_mday = date & 0x1F;
+    parts.tm_hour = (time >> 11) & 0x1F;
+    parts.tm_min = (time >> 5) & 0x3F;
+    parts.tm_sec = (time & 0x1F) * 2;
+    parts.tm_isdst = -1;
+    return static_cast<std::int64_t>(std::mktime(&parts));
+}
+
+/*
+    Reads the end-of-central-directory record (zip64 aware) and every
+    central directory entry.
+*/
+static bool read_zip_directory(int fd, std::vector<zip_member>& members)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 22)
+    {
+        return false;
+    }
+    std::uint64_t file_size = static_cast<std::uint64_t>(st.st_size);
+
+    // The record is in the last 22 bytes plus a comment of up to 64 KiB
+    std::uint64_t tail_length = std::min<std::uint64_t>(file_size, 22 + 65535);
+    std::vector<unsigned char> tail(static_cast<std::size_t>(tail_length));
+    if (!read_at(fd, file_size - tail_length, tail.data(), tail.size()))
+    {
+        return false;
+    }
+
+    std::size_t record = std::string::npos;
+    for (std::size_t i = tail.size() - 22 + 1; i-- > 0; )
+    {
+        if (le32(&tail[i]) == 0x06054B50)
+        {
+            record = i;
+            break;
+        }
+    }
+    if (record == std::string::npos)
+    {
+        return false;
+    }
+
+    std::uint64_t record_offset = file_size - tail_length + record;
+    std::uint64_t entry_count = le16(&tail[record + 10]);
+    std::uint64_t directory_size = le32(&tail[record + 12]);
+    std::uint64_t directory_offset = le32(&tail[record + 16]);
+
+    // Zip64: the locator sits right before the classic record
+    if ((entry_count == 0xFFFF || directory_size == 0xFFFFFFFF || directory_offset == 0xFFFFFFFF)
+        && record_offset >= 20)
+    {
+        unsigned char locator[20];
+        unsigned char zip64_record[56];
+        if (!read_at(fd, record_offset - 20, locator, sizeof(locator)) || le32(locator) != 0x07064B50
+            || !read_at(fd, le64(locator + 8), zip64_record, sizeof(zip64_record))
+            || le32(zip64_record) != 0x06064B50)
+        {
+            return false;
+        }
+        entry_count = le64(zip64_record + 32);
+        directory_size = le64(zip64_record + 40);
+        directory_offset = le64(zip64_record + 48);
+    }
+
+    if (directory_offset + directory_size > file_size)
+    {
+        return false;
+    }
+
+    std::vector<unsigned char> directory(static_cast<std::size_t>(directory_size));
+    if (!read_at(fd, directory_offset, directory.data(), directory.size()))
+    {
+        return false;
+    }
+
+    std::size_t position = 0;
+    for (std::uint64_t i = 0; i < entry_count; i++)
+    {
+        if (position + 46 > directory.size() || le32(&directory[position]) != 0x02014B50)
+        {
+            return false;
+        }
+        const unsigned char* entry = &directory[position];
+        std::size_t name_length = le16(entry + 28);
+        std::size_t extra_length = le16(entry + 30);
+        std::size_t comment_length = le16(entry + 32);
+        if (position + 46 + name_length + extra_length + comment_length > directory.size())
+        {
+            return false;
+        }
+
+        zip_member member;
+        member.flags = le16(entry + 8);
+        member.method = le16(entry + 10);
+        member.mtime = dos_time(le16(entry + 12), le16(entry + 14));
+        member.crc = le32(entry + 16);
+        member.compressed_size = le32(entry + 20);
+        member.size = le32(entry + 24);
+        member.local_header_offset = le32(entry + 42);
+
+        // Made on Unix: mode bits in the high half of the external attributes
+        std::uint32_t unix_mode = le32(entry + 38) >> 16;
+        member.symlink = (entry[5] == 3) && (unix_mode & S_IFMT) == S_IFLNK;
+        member.name.assign(reinterpret_cast<const char*>(entry + 46), name_length);
+
+        // Extra fields: zip64 sizes (0x0001), Unix modification time (0x5455)
+        const unsigned char* extra = entry + 46 + name_length;
+        for (std::size_t e = 0; e + 4 <= extra_length; )
+        {
+            std::uint16_t id = le16(extra + e);
+            std::uint16_t length = le16(extra + e + 2);
+            const unsigned char* data = extra + e + 4;
+            if (e + 4 + length > extra_length)
+            {
+                break;
+            }
+
+            if (id == 0x0001)
+            {
+                std::size_t field = 0;
+                if (member.size == 0xFFFFFFFF && field + 8 <= length)
+                {
+                    member.size = le64(data + field);
+                    field += 8;
+                }
+                if (member.compressed_size == 0xFFFFFFFF && field + 8 <= length)
+                {
+                    member.compressed_size = le64(data + field);
+                    field += 8;
+                }
+                if (member.local_header_offset == 0xFFFFFFFF && field + 8 <= length)
+                {
+                    member.local_header_offset = le64(data + field);
+                }
+            }
+            else if (id == 0x5455 && length >= 5 && (data[0] & 1))
+            {
+                member.mtime = static_cast<std::int32_t>(le32(data + 1));
+            }
+            e += 4 + length;
+        }
+
+        members.push_back(std::move(member));
+        position += 46 + name_length + extra_length + comment_length;
+    }
+    return true;
+}
+
+static void explode_zip(int fd, member_writer& writer, const exploded_member_callback& on_member, explode_summary& summary)
+{
+    std::vector<zip_member> members;
+    if (!read_zip_directory(fd, members))
+    {
+        summary.status = explode_status::corrupt;
+        return;
+    }
+
+    std::size_t block_size = memory_governor::shared().scaled(IO_BLOCK, MIN_IO_BLOCK);
+    std::vector<unsigned char> input(block_size);
+    std::vector<unsigned char> output(block_size);
+
+    for (const zip_member& member : members)
+    {
+        if (!member.name.empty() && member.name.back() == '/')
+        {
+            continue;   // Folder entry
+        }
+
+        // Symlink, encrypted, or a method other than stored / deflate
+        if (member.symlink || (member.flags & 1) != 0 || (member.method != 0 && member.method != 8))
+        {
+            summary.skipped++;
+            continue;
+        }
+
+        unsigned char local[30];
+        if (!read_at(fd, member.local_header_offset, local, sizeof(local)) || le32(local) != 0x04034B50)
+        {
+            summary.status = explode_status::corrupt;
+            return;
+        }
+        std::uint64_t data_offset = member.local_header_offset + 30 + le16(local + 26) + le16(local + 28);
+
+        bool failed = false;
+        if (!writer.begin(member.name, member.mtime, failed))
+        {
+            if (failed)
+            {
+                summary.status = explode_status::write_failed;
+                return;
+            }
+            summary.skipped++;
+            continue;
+        }
+
+        z_stream stream{};
+        bool inflating = (member.method == 8);
+        if (inflating && inflateInit2(&stream, -MAX_WBITS) != Z_OK)     // Raw deflate
+        {
+            writer.abort_member();
+            summary.status = explode_status::corrupt;
+            return;
+        }
+
+        uLong crc = crc32(0L, Z_NULL, 0);
+        std::uint64_t remaining = member.compressed_size;
+        std::uint64_t offset = data_offset;
+        std::uint64_t produced = 0;
+        explode_status member_status = explode_status::ok;
+        bool stream_ended = !inflating;
+
+        while (remaining > 0 && member_status == explode_status::ok)
+        {
+            std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(remaining, input.size()));
+            if (!read_at(fd, offset, input.data(), n))
+            {
+                member_status = explode_status::corrupt;
+                break;
+            }
+            offset += n;
+            remaining -= n;
+
+            if (!inflating)
+            {
+                crc = crc32(crc, input.data(), static_cast<uInt>(n));
+                produced += n;
+                if (!writer.write(reinterpret_cast<const char*>(input.data()), n))
+                {
+                    member_status = explode_status::write_failed;
+                }
+                continue;
+            }
+
+            stream.next_in = input.data();
+            stream.avail_in = static_cast<uInt>(n);
+            while (stream.avail_in > 0 && !stream_ended)
+            {
+                stream.next_out = output.data();
+                stream.avail_out = static_cast<uInt>(output.size());
+
+                int result = inflate(&stream, Z_NO_FLUSH);
+                if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+                {
+                    member_status = explode_status::corrupt;
+                    break;
+                }
+
+                std::size_t out = output.size() - stream.avail_out;
+                crc = crc32(crc, output.data(), static_cast<uInt>(out));
+                produced += out;
+                if (out > 0 && !writer.write(reinterpret_cast<const char*>(output.data()), out))
+                {
+                    member_status = explode_status::write_failed;
+                    break;
+                }
+                stream_ended = (result == Z_STREAM_END);
+                if (result == Z_BUF_ERROR)
+                {
+                    break;
+                }
+            }
+        }
+
+        if (inflating)
+        {
+            inflateEnd(&stream);
+        }
+
+        if (member_status == explode_status::ok
+            && (!stream_ended || produced != member.size || crc != member.crc))
+        {
+            member_status = explode_status::corrupt;
+        }
+
+        std::filesystem::path final_path;
+        if (member_status != explode_status::ok)
+        {
+            writer.abort_member();
+            summary.status = member_status;
+            return;
+        }
+        if (!writer.commit(on_member, final_path))
+        {
+            summary.status = explode_status::write_failed;
+            return;
+        }
+        summary.members++;
+    }
+}
+
+
+/*
+    =========================================================
+        explode_archive
+    =========================================================
+*/
+explode_summary explode_archive(
+    const std::filesystem::path& archive_path,
+    const std::string& destination_root,
+    const organize_options& options,
+    const explode_policy& policy,
+    const exploded_member_callback& on_member)
+{
+    explode_summary summary;
+
+    archive_format format = detect_archive_format(archive_path);
+    if (format == archive_format::none)
+    {
+        summary.status = explode_status::not_an_archive;
+        return summary;
+    }
+
+    int fd = open(archive_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        summary.status = explode_status::open_failed;
+        return summary;
+    }
+
+    {
+        member_writer writer(destination_root, options);
+        std::string threads = "-T" + std::to_string(policy.decompressor_threads);
+
+        switch (format)
+        {
+        case archive_format::zip:
+            explode_zip(fd, writer, on_member, summary);
+            break;
+
+        case archive_format::tar:
+        {
+            file_source source(fd);
+            explode_tar(source, writer, on_member, summary);
+            break;
+        }
+
+        case archive_format::tar_gzip:
+        {
+            gzip_source source(fd);
+            explode_tar(source, writer, on_member, summary);
+            if (summary.status == explode_status::ok && !source.finish())
+            {
+                summary.status = explode_status::corrupt;
+            }
+            break;
+        }
+
+        case archive_format::tar_bzip2:
+        case archive_format::tar_xz:
+        case archive_format::tar_zstd:
+        {
+            std::vector<std::string> command;
+            if (format == archive_format::tar_bzip2)
+            {
+                command = {"bzip2", "-dc"};
+            }
+            else
+            {
+                command = {format == archive_format::tar_xz ? "xz" : "zstd", "-dc", threads};
+            }
+
+            process_source source(fd, command);
+            if (!source.started())
+            {
+                summary.status = explode_status::decompressor_failed;
+                break;
+            }
+            explode_tar(source, writer, on_member, summary);
+            if (!source.finish() && summary.status == explode_status::ok)
+            {
+                summary.status = explode_status::decompressor_failed;
+            }
+            break;
+        }
+
+        case archive_format::none:
+            break;
+        }
+
+        summary.bytes = writer.bytes_written();
+    }
+
+    close(fd);
+
+    if (summary.status == explode_status::ok && summary.skipped == 0 && policy.remove_archive)
+    {
+        std::error_code ec;
+        std::filesystem::remove(archive_path, ec);
+    }
+    return summary;
+}
+
+#else
+
+explode_summary explode_archive(
+    const std::filesystem::path& archive_path,
+    const std::string& destination_root,
+    const organize_options& options,
+    const explode_policy& policy,
+    const exploded_member_callback& on_member)
+{
+    (void)archive_path;
+    (void)destination_root;
+    (void)options;
+    (void)policy;
+    (void)on_member;
+
+    explode_summary summary;
+    summary.status = explode_status::unsupported;
+    return summary;
+}
+
+#endif
@@ -0,0 +1,212 @@
+#include "category_shards.hpp"
+#include "extensions.hpp"
+#include "filesystem_utils.hpp"
+
+#include <cctype>
+#include <cstdio>
+
+static const std::string SHARD_PREFIX = "shard-";
+
+/*
+    =========================================================
+        fnv1a_hash
+    =========================================================
+
+    32-bit FNV-1a.
+
+    std::hash is NOT used on purpose: its result may differ between
+    standard libraries, and shard routing must be identical everywhere.
+*/
+static std::uint32_t fnv1a_hash(const std::string& text)
+{
+    std::uint32_t hash = 2166136261u;
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool is_shard_folder_name(const std::string& folder_name)
+{
+    return folder_name.size() > SHARD_PREFIX.size()
+        && folder_name.compare(0, SHARD_PREFIX.size(), SHARD_PREFIX) == 0;
+}
+
+/*
+    =========================================================
+        shard_folder_name
+    =========================================================
+*/
+std::string shard_folder_name(const std::string& filename, const shard_policy& policy)
+{
+    if (policy.scheme == shard_scheme::name_prefix)
+    {
+        unsigned char first = filename.empty() ? '_' : static_cast<unsigned char>(filename[0]);
+
+        // Letters and digits get their own shard, everything else shares one
+        if (std::isalnum(first) && first < 0x80)
+        {
+            return SHARD_PREFIX + static_cast<char>(std::tolower(first));
+        }
+        return SHARD_PREFIX + "_";
+    }
+
+    unsigned buckets = policy.hash_buckets == 0 ? 1 : policy.hash_buckets;
+    unsigned bucket = fnv1a_hash(filename) % buckets;
+
+    // Zero-padded hex, wide enough for the largest bucket number
+    int width = 1;
+    for (unsigned limit = buckets - 1; limit > 0xF; limit >>= 4)
+    {
+        width++;
+    }
+
+    char hex[16];
+    std::snprintf(hex, sizeof(hex), "%0*x", width, bucket);
+    return SHARD_PREFIX + hex;
+}
+
+/*
+    =========================================================
+        shard_registry
+    =========================================================
+*/
+shard_registry::shard_registry(const shard_policy& policy)
+    : policy(policy)
+{
+}
+
+/*
+    Scans a category folder the first time it is seen in this run.
+*/
+shard_registry::folder_state& shard_registry::state_of(const std::filesystem::path& category_directory)
+{
+    std::map<std::filesystem::path, folder_state>::iterator it = folders.find(category_directory);
+    if (it != folders.end())
+    {
+        return it->second;
+    }
+
+    folder_state state;
+    std::error_code ec;
+
+    for (std::filesystem::directory_iterator entry(category_directory, ec), end; !ec && entry != end; entry.increment(ec))
+    {
+        if (entry->is_directory(ec) && is_shard_folder_name(entry->path().filename().string()))
+        {
+            state.sharded = true;
+        }
+        else
+        {
+            state.loose_entries++;
+        }
+    }
+
+    return folders.emplace(category_directory, state).first->second;
+}
+
+/*
+    Moves every loose file of a category folder into its shard.
+
+    Runs at most once per folder: afterwards the folder is sharded
+    and only receives files through route().
+    Loose sub-folders are user structure and stay where they are, and
+    misplaced files are left for the organizer to move out.
+*/
+void shard_registry::split_folder(const std::filesystem::path& category_directory, folder_state& state)
+{
+    std::vector<std::filesystem::path> loose_files;
+    std::error_code ec;
+
+    for (std::filesystem::directory_iterator entry(category_directory, ec), end; !ec && entry != end; entry.increment(ec))
+    {
+        if (entry->is_regular_file(ec)
+            && classify_file_by_extension(entry->path().string()) == category_directory.filename().string())
+        {
+            loose_files.push_back(entry->path());
+        }
+    }
+
+    std::size_t remaining = state.loose_entries;
+
+    for (const std::filesystem::path& file_path : loose_files)
+    {
+        std::string filename = file_path.filename().string();
+        std::filesystem::path shard_directory = category_directory / shard_folder_name(filename, policy);
+
+        create_directory_status creation = create_directory(shard_directory.string());
+        if (creation != create_directory_status::successful_creation
+            && creation != create_directory_status::already_exists)
+        {
+            continue;
+        }
+
+        // Never over a file created in the shard since it was checked
+        std::filesystem::path new_path;
+        if (transfer_to_unique_path(file_path, shard_directory, filename, atomic_transfer_to_path, &new_path)
+            == file_move_status::successful_transfer)
+        {
+            relocations.emplace_back(file_path, new_path);
+            remaining--;
+        }
+    }
+
+    state.sharded = true;
+    state.loose_entries = remaining;
+}
+
+/*
+    =========================================================
+        shard_registry::route
+    =========================================================
+*/
+std::filesystem::path shard_registry::route(
+    const std::filesystem::path& category_directory,
+    const std::string& filename,
+    bool already_inside
+    )
+{
+    folder_state& state = state_of(category_directory);
+
+    if (!state.sharded && !already_inside)
+    {
+        if (state.loose_entries + 1 <= policy.max_entries)
+        {
+            state.loose_entries++;
+            return category_directory;
+        }
+        split_folder(category_directory, state);
+    }
+
+    if (!state.sharded)
+    {
+        // Already counted when the folder was scanned
+        return category_directory;
+    }
+
+    std::filesystem::path shard_directory = category_directory / shard_folder_name(filename, policy);
+    create_directory(shard_directory.string());
+    return shard_directory;
+}
+
+std::filesystem::path shard_registry::settled_directory(
+    const std::filesystem::path& directory,
+    const std::string& filename
+    ) const
+{
+    std::map<std::filesystem::path, folder_state>::const_iterator it = folders.find(directory);
+    if (it == folders.end() || !it->second.sharded)
+    {
+        return directory;
+    }
+    return directory / shard_folder_name(filename, policy);
+}
+
+std::vector<std::pair<std::filesystem::path, std::filesystem::path>> shard_registry::take_relocations()
+{
+    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> taken;
+    taken.swap(relocations);
+    return taken;
+}
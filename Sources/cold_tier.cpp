@@ -0,0 +1,361 @@
+#include "cold_tier.hpp"
+#include "content_hash_cache.hpp"
+#include "extensions.hpp"
+#include "filesystem_utils.hpp"
+#include "layout_learner.hpp"
+#include "resumable_copy.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define COLD_TIER_POSIX 1
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+    =========================================================
+        read_clock
+    =========================================================
+
+    Seconds since the epoch of the timestamp selected by clock.
+    Returns false if the file (or its filesystem) has none.
+*/
+static bool read_clock(const std::filesystem::path& file_path, tier_clock clock, std::int64_t& seconds)
+{
+#if defined(__linux__) && defined(STATX_BTIME)
+    struct statx stx;
+    unsigned mask = clock == tier_clock::birth_time ? STATX_BTIME : STATX_ATIME;
+
+    if (statx(AT_FDCWD, file_path.c_str(), AT_SYMLINK_NOFOLLOW, mask, &stx) != 0
+        || (stx.stx_mask & mask) == 0)
+    {
+        return false;
+    }
+    seconds = clock == tier_clock::birth_time ? stx.stx_btime.tv_sec : stx.stx_atime.tv_sec;
+    return true;
+#elif defined(COLD_TIER_POSIX)
+    struct stat st;
+    if (lstat(file_path.c_str(), &st) != 0)
+    {
+        return false;
+    }
+#if defined(__APPLE__)
+    seconds = clock == tier_clock::birth_time ? st.st_birthtimespec.tv_sec : st.st_atimespec.tv_sec;
+    return true;
+#else
+    if (clock == tier_clock::birth_time)
+    {
+        return false;
+    }
+    seconds = st.st_atim.tv_sec;
+    return true;
+#endif
+#else
+    // No access or birth time in std::filesystem: never tier
+    (void)file_path;
+    (void)clock;
+    (void)seconds;
+    return false;
+#endif
+}
+
+/*
+    =========================================================
+        move_to_tier
+    =========================================================
+
+    rename() where possible. Across devices, the copy engine of the
+    fallback transfers (resumable_copy): a temporary name, journaled
+    chunks that survive an interruption, a byte-for-byte read-back
+    against the source, and a publish that never replaces a file.
+    The source is deleted only after all of that succeeded.
+*/
+static file_move_status move_to_tier(const std::filesystem::path& source, const std::filesystem::path& destination)
+{
+    file_move_status result = atomic_transfer_to_path(source, destination);
+    if (result != file_move_status::cross_device_error)
+    {
+        return result;
+    }
+
+    resumable_copy_policy copy_policy;
+    copy_policy.verify = true;
+
+    std::uint64_t content_hash = 0;
+    result = resumable_copy(source, destination, copy_policy, &content_hash);
+    if (result != file_move_status::successful_transfer)
+    {
+        return result;
+    }
+
+    /*
+        The copy was just read back and compared: record its hash, so
+        later hashing of the archived file does not read it again.
+    */
+    file_identity identity;
+    if (content_hash != 0 && identify_file(destination, identity))
+    {
+        content_hash_cache::shared().store_full(identity, content_hash);
+    }
+
+    // The verified copy is in place: losing the source is now harmless
+    std::error_code ec;
+    std::filesystem::remove(source, ec);
+    return file_move_status::successful_transfer;
+}
+
+/*
+    True if link_path is a symlink resolving to target (the link
+    tiering left for it); link_target receives the link's contents.
+*/
+static bool points_to(const std::filesystem::path& link_path, const std::filesystem::path& target,
+                      std::filesystem::path& link_target)
+{
+    std::error_code ec;
+    if (!std::filesystem::is_symlink(std::filesystem::symlink_status(link_path, ec)))
+    {
+        return false;
+    }
+
+    link_target = std::filesystem::read_symlink(link_path, ec);
+    if (ec)
+    {
+        return false;
+    }
+
+    std::filesystem::path resolved = link_target.is_absolute() ? link_target : link_path.parent_path() / link_target;
+    return std::filesystem::weakly_canonical(resolved, ec) == std::filesystem::weakly_canonical(target, ec);
+}
+
+/*
+    Neither root may lie inside the other: tiering would then
+    walk into its own output (or recall into its own input).
+*/
+static bool roots_overlap(const std::string& root_path, const std::string& cold_root)
+{
+    std::error_code ec;
+    std::string tree = std::filesystem::weakly_canonical(root_path, ec).string();
+    std::string cold = std::filesystem::weakly_canonical(cold_root, ec).string();
+
+    return is_within_folder(tree, cold) || is_within_folder(cold, tree);
+}
+
+/*
+    Walks folder_path (no recursion, hidden folders skipped) and calls
+    visit(file) for every regular file that is not a symlink.
+*/
+template <typename Visitor>
+static void walk_regular_files(const std::filesystem::path& folder_path, Visitor visit)
+{
+    std::vector<std::filesystem::path> directories;
+    directories.push_back(folder_path);
+
+    while (!directories.empty())
+    {
+        std::filesystem::path current = directories.back();
+        directories.pop_back();
+
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(current, ec), end; !ec && it != end; it.increment(ec))
+        {
+            std::filesystem::file_status status = it->symlink_status(ec);
+            std::string name = it->path().filename().string();
+
+            if (std::filesystem::is_directory(status))
+            {
+                if (!name.empty() && name[0] != '.')
+                {
+                    directories.push_back(it->path());
+                }
+            }
+            else if (std::filesystem::is_regular_file(status))
+            {
+                if (!visit(it->path()))
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+/*
+    =========================================================
+        tier_cold_files
+    =========================================================
+*/
+tiering_summary tier_cold_files(
+    const std::string& root_path,
+    const tiering_policy& policy,
+    const std::atomic<bool>* stop_requested
+    )
+{
+    tiering_summary summary;
+
+    if (validate_path(root_path) != path_status::ok)
+    {
+        summary.status = tiering_status::path_not_found;
+        return summary;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(policy.cold_root, ec);
+    if (policy.cold_root.empty() || !std::filesystem::is_directory(policy.cold_root, ec))
+    {
+        summary.status = tiering_status::cold_root_unavailable;
+        return summary;
+    }
+
+    if (roots_overlap(root_path, policy.cold_root))
+    {
+        summary.status = tiering_status::cold_root_overlaps_tree;
+        return summary;
+    }
+
+    std::int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    walk_regular_files(root_path, [&](const std::filesystem::path& file_path)
+    {
+        if (stop_requested != nullptr && stop_requested->load())
+        {
+            return false;
+        }
+
+        // Threshold of the file's category
+        unsigned age_days = policy.default_age_days;
+        std::map<std::string, unsigned>::const_iterator category_age =
+            policy.age_days_by_category.find(classify_file_by_extension(file_path.filename().string()));
+        if (category_age != policy.age_days_by_category.end())
+        {
+            age_days = category_age->second;
+        }
+
+        std::int64_t stamp = 0;
+        if (age_days == 0
+            || !read_clock(file_path, policy.clock, stamp)
+            || now - stamp < static_cast<std::int64_t>(age_days) * 86400)
+        {
+            return true;
+        }
+
+        // Same relative path in the cold tier: the category layout is kept
+        std::error_code file_ec;
+        std::filesystem::path relative = file_path.lexically_relative(root_path);
+        std::filesystem::path destination_directory = (std::filesystem::path(policy.cold_root) / relative).parent_path();
+        std::filesystem::create_directories(destination_directory, file_ec);
+
+        std::filesystem::path destination;
+        std::uint64_t size = std::filesystem::file_size(file_path, file_ec);
+
+        if (transfer_to_unique_path(file_path, destination_directory, file_path.filename().string(), move_to_tier, &destination)
+            != file_move_status::successful_transfer)
+        {
+            summary.files_failed++;
+            return true;
+        }
+
+        summary.files_moved++;
+        summary.bytes_moved += size;
+
+        if (policy.leave_symlink)
+        {
+            // The file itself is safe in the cold tier even if this fails
+            std::filesystem::create_symlink(std::filesystem::absolute(destination, file_ec), file_path, file_ec);
+        }
+        return true;
+    });
+
+    if (summary.files_failed > 0)
+    {
+        summary.status = tiering_status::partial;
+    }
+    return summary;
+}
+
+/*
+    =========================================================
+        recall_cold_files
+    =========================================================
+*/
+tiering_summary recall_cold_files(
+    const std::string& root_path,
+    const tiering_policy& policy,
+    const std::string& relative_path
+    )
+{
+    tiering_summary summary;
+
+    std::error_code ec;
+    std::filesystem::path cold_source = relative_path.empty()
+        ? std::filesystem::path(policy.cold_root)
+        : std::filesystem::path(policy.cold_root) / relative_path;
+
+    if (validate_path(root_path) != path_status::ok || !std::filesystem::exists(cold_source, ec))
+    {
+        summary.status = tiering_status::path_not_found;
+        return summary;
+    }
+
+    if (roots_overlap(root_path, policy.cold_root))
+    {
+        summary.status = tiering_status::cold_root_overlaps_tree;
+        return summary;
+    }
+
+    auto recall = [&](const std::filesystem::path& cold_file)
+    {
+        std::error_code file_ec;
+        std::filesystem::path relative = cold_file.lexically_relative(policy.cold_root);
+        std::filesystem::path original = std::filesystem::path(root_path) / relative;
+        std::filesystem::create_directories(original.parent_path(), file_ec);
+
+        /*
+            The symlink left by tiering must go before the file can take
+            its name back: moves never replace anything. Only OUR link is
+            removed (one the user re-pointed or replaced is kept, and the
+            file comes back under a numbered name), and it is restored
+            if the file cannot be moved back.
+        */
+        std::filesystem::path link_target;
+        bool replaces_link = points_to(original, cold_file, link_target)
+                          && std::filesystem::remove(original, file_ec);
+
+        std::uint64_t size = std::filesystem::file_size(cold_file, file_ec);
+
+        if (transfer_to_unique_path(cold_file, original.parent_path(), original.filename().string(), move_to_tier)
+            != file_move_status::successful_transfer)
+        {
+            if (replaces_link)
+            {
+                std::filesystem::create_symlink(link_target, original, file_ec);
+            }
+            summary.files_failed++;
+            return true;
+        }
+
+        summary.files_moved++;
+        summary.bytes_moved += size;
+        return true;
+    };
+
+    if (std::filesystem::is_directory(cold_source, ec))
+    {
+        walk_regular_files(cold_source, recall);
+    }
+    else
+    {
+        recall(cold_source);
+    }
+
+    if (summary.files_failed > 0)
+    {
+        summary.status = tiering_status::partial;
+    }
+    return summary;
+}
@@ -0,0 +1,769 @@
+#include "content_hash_cache.hpp"
+#include "memory_governor.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HASH_CACHE_POSIX 1
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char TABLE_MAGIC[8] = {'F', 'O', 'H', 'A', 'S', 'H', '1', '\n'};
+
+// 4 MiB file; grows by compaction
+static const std::uint64_t INITIAL_SLOTS = 1ULL << 16;
+
+// Size of each end read for the partial hash
+static const std::size_t PARTIAL_BLOCK = 64 * 1024;
+
+// Full and smallest read buffer (the governor picks in between)
+static const std::size_t READ_BLOCK = 1024 * 1024;
+static const std::size_t MIN_READ_BLOCK = 64 * 1024;
+
+static const std::uint64_t SLOT_READY = 1;
+static const std::uint64_t HAS_PARTIAL = 1;
+static const std::uint64_t HAS_FULL = 2;
+
+/*
+    On-disk layout, see the header. Both are one cache line.
+*/
+struct table_header
+{
+    char magic[8];
+    std::uint64_t slot_count;
+    std::uint64_t used;
+    std::uint64_t reserved[5];
+};
+
+struct table_slot
+{
+    std::uint64_t state;
+    std::uint64_t device;
+    std::uint64_t inode;
+    std::uint64_t size;
+    std::int64_t mtime_ns;
+    std::uint64_t partial;
+    std::uint64_t full;
+    std::uint64_t flags;
+};
+
+static_assert(sizeof(table_header) == 64 && sizeof(table_slot) == 64, "cache layout is fixed");
+
+static std::size_t table_length(std::uint64_t slot_count)
+{
+    return sizeof(table_header) + static_cast<std::size_t>(slot_count) * sizeof(table_slot);
+}
+
+static table_header* header_of(void* base)
+{
+    return static_cast<table_header*>(base);
+}
+
+static table_slot* slots_of(void* base)
+{
+    return reinterpret_cast<table_slot*>(static_cast<char*>(base) + sizeof(table_header));
+}
+
+/*
+    Home slot of an identity (splitmix64 finalizer over all four
+    fields, so files of one folder spread over the table).
+*/
+static std::uint64_t slot_hash(const file_identity& identity)
+{
+    std::uint64_t x = identity.device * 0x9E3779B97F4A7C15ULL ^ identity.inode;
+    x ^= identity.size * 0xC2B2AE3D27D4EB4FULL ^ static_cast<std::uint64_t>(identity.mtime_ns);
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static bool same_identity(const table_slot& slot, const file_identity& identity)
+{
+    return slot.device == identity.device && slot.inode == identity.inode
+        && slot.size == identity.size && slot.mtime_ns == identity.mtime_ns;
+}
+
+/*
+    =========================================================
+        identify_file
+    =========================================================
+*/
+bool identify_file(const std::filesystem::path& path, file_identity& identity)
+{
+#if defined(HASH_CACHE_POSIX)
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        return false;
+    }
+
+    identity.device = static_cast<std::uint64_t>(st.st_dev);
+    identity.inode = static_cast<std::uint64_t>(st.st_ino);
+    identity.size = static_cast<std::uint64_t>(st.st_size);
+#if defined(__APPLE__)
+    identity.mtime_ns = static_cast<std::int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    identity.mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return true;
+#else
+    (void)path;
+    (void)identity;
+    return false;
+#endif
+}
+
+/*
+    =========================================================
+        content_hash_cache
+    =========================================================
+*/
+content_hash_cache& content_hash_cache::shared()
+{
+    static content_hash_cache cache;
+    return cache;
+}
+
+std::filesystem::path content_hash_cache::default_path()
+{
+    const char* cache_home = std::getenv("XDG_CACHE_HOME");
+    std::filesystem::path base;
+
+    if (cache_home != nullptr && cache_home[0] != '\0')
+    {
+        base = cache_home;
+    }
+    else
+    {
+        const char* home = std::getenv("HOME");
+        base = std::filesystem::path(home != nullptr ? home : ".") / ".cache";
+    }
+    return base / "file_organizer" / "content_hashes.bin";
+}
+
+content_hash_cache::~content_hash_cache()
+{
+    close();
+}
+
+#if defined(HASH_CACHE_POSIX)
+
+content_hash_cache::table_mapping* content_hash_cache::create_table(
+    const std::filesystem::path& table_path, std::uint64_t slot_count, int& table_fd)
+{
+    table_fd = ::open(table_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (table_fd < 0)
+    {
+        return nullptr;
+    }
+
+    // Sparse: untouched slots read as zero (= empty) and cost no disk
+    std::size_t length = table_length(slot_count);
+    void* base = MAP_FAILED;
+    if (ftruncate(table_fd, static_cast<off_t>(length)) == 0)
+    {
+        base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, table_fd, 0);
+    }
+
+    if (base == MAP_FAILED)
+    {
+        ::close(table_fd);
+        table_fd = -1;
+        unlink(table_path.c_str());
+        return nullptr;
+    }
+
+    std::memcpy(header_of(base)->magic, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    header_of(base)->slot_count = slot_count;
+
+    table_mapping* mapping = new table_mapping;
+    mapping->base = base;
+    mapping->length = length;
+    mapping->slot_count = slot_count;
+    return mapping;
+}
+
+/*
+    =========================================================
+        content_hash_cache::open
+    =========================================================
+*/
+hash_cache_status content_hash_cache::open(const std::filesystem::path& cache_path)
+{
+    close();
+
+    bool orphaned = false;
+    hash_cache_status status;
+    do
+    {
+        orphaned = false;
+        status = open_table(cache_path, orphaned);
+    }
+    while (orphaned);
+
+    return status;
+}
+
+hash_cache_status content_hash_cache::open_table(const std::filesystem::path& cache_path, bool& orphaned)
+{
+    std::lock_guard<std::mutex> lock(append_mutex);
+
+    path = cache_path;
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0 && errno == ENOENT)
+    {
+        /*
+            Created under a private name and linked into place, so two
+            processes starting at once end up sharing one table.
+        */
+        std::filesystem::path fresh = path;
+        fresh += ".new." + std::to_string(getpid());
+
+        int fresh_fd = -1;
+        table_mapping* table = create_table(fresh, INITIAL_SLOTS, fresh_fd);
+        if (table != nullptr)
+        {
+            munmap(table->base, table->length);
+            delete table;
+            ::close(fresh_fd);
+            link(fresh.c_str(), path.c_str());      // EEXIST: somebody else won
+            unlink(fresh.c_str());
+        }
+        fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    }
+    if (fd < 0)
+    {
+        return hash_cache_status::unavailable;
+    }
+
+    appender = flock(fd, LOCK_EX | LOCK_NB) == 0;
+
+    /*
+        The appender may have compacted (renamed a new table over
+        path) between our open() and flock(): the lock would then be
+        on an orphaned table. Start over with the current file.
+    */
+    struct stat opened;
+    struct stat named;
+    if (appender && fstat(fd, &opened) == 0 && stat(path.c_str(), &named) == 0
+        && (opened.st_dev != named.st_dev || opened.st_ino != named.st_ino))
+    {
+        ::close(fd);
+        fd = -1;
+        appender = false;
+        orphaned = true;
+        return hash_cache_status::unavailable;
+    }
+
+    // Header check before trusting slot_count
+    struct stat st;
+    table_header header;
+    bool valid = fstat(fd, &st) == 0
+        && static_cast<std::size_t>(st.st_size) >= sizeof(table_header)
+        && pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header))
+        && std::memcmp(header.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC)) == 0
+        && header.slot_count != 0
+        && (header.slot_count & (header.slot_count - 1)) == 0
+        && static_cast<std::size_t>(st.st_size) == table_length(header.slot_count);
+
+    if (!valid)
+    {
+        if (!appender)
+        {
+            ::close(fd);
+            fd = -1;
+            return hash_cache_status::unavailable;
+        }
+
+        // Damaged cache: start over, it only holds what can be recomputed
+        int fresh_fd = -1;
+        std::filesystem::path fresh = path;
+        fresh += ".new." + std::to_string(getpid());
+
+        table_mapping* table = create_table(fresh, INITIAL_SLOTS, fresh_fd);
+        if (table == nullptr || flock(fresh_fd, LOCK_EX | LOCK_NB) != 0
+            || rename(fresh.c_str(), path.c_str()) != 0)
+        {
+            if (table != nullptr)
+            {
+                munmap(table->base, table->length);
+                delete table;
+                ::close(fresh_fd);
+                unlink(fresh.c_str());
+            }
+            ::close(fd);
+            fd = -1;
+            appender = false;
+            return hash_cache_status::unavailable;
+        }
+
+        ::close(fd);
+        fd = fresh_fd;
+        current.store(table, std::memory_order_release);
+        return hash_cache_status::ok;
+    }
+
+    std::size_t length = table_length(header.slot_count);
+    void* base = mmap(nullptr, length, appender ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        ::close(fd);
+        fd = -1;
+        appender = false;
+        return hash_cache_status::unavailable;
+    }
+
+    table_mapping* table = new table_mapping;
+    table->base = base;
+    table->length = length;
+    table->slot_count = header.slot_count;
+    current.store(table, std::memory_order_release);
+
+    return appender ? hash_cache_status::ok : hash_cache_status::read_only;
+}
+
+/*
+    Not safe while other threads are still looking up.
+*/
+void content_hash_cache::close()
+{
+    std::lock_guard<std::mutex> lock(append_mutex);
+
+    table_mapping* table = current.exchange(nullptr);
+    if (table != nullptr)
+    {
+        retired.push_back(table);
+    }
+    for (table_mapping* old : retired)
+    {
+        munmap(old->base, old->length);
+        delete old;
+    }
+    retired.clear();
+
+    if (fd >= 0)
+    {
+        ::close(fd);    // Also releases the appender lock
+        fd = -1;
+    }
+    appender = false;
+}
+
+/*
+    =========================================================
+        content_hash_cache::lookup
+    =========================================================
+
+    Lock-free: the state of a slot is stored last (release), so once
+    it reads SLOT_READY (acquire) the key fields are complete and never
+    change again. The hashes are guarded the same way by flags.
+*/
+bool content_hash_cache::lookup(const file_identity& identity, cached_hashes& hashes) const
+{
+    hashes = cached_hashes();
+
+    table_mapping* table = current.load(std::memory_order_acquire);
+    if (table == nullptr)
+    {
+        return false;
+    }
+
+    table_slot* slots = slots_of(table->base);
+    std::uint64_t mask = table->slot_count - 1;
+    std::uint64_t index = slot_hash(identity) & mask;
+
+    for (std::uint64_t probe = 0; probe < table->slot_count; probe++, index = (index + 1) & mask)
+    {
+        table_slot& slot = slots[index];
+        if (std::atomic_ref<std::uint64_t>(slot.state).load(std::memory_order_acquire) != SLOT_READY)
+        {
+            return false;   // End of the probe chain
+        }
+        if (!same_identity(slot, identity))
+        {
+            continue;
+        }
+
+        std::uint64_t flags = std::atomic_ref<std::uint64_t>(slot.flags).load(std::memory_order_acquire);
+        hashes.has_partial = (flags & HAS_PARTIAL) != 0;
+        hashes.has_full = (flags & HAS_FULL) != 0;
+        hashes.partial = hashes.has_partial ? std::atomic_ref<std::uint64_t>(slot.partial).load(std::memory_order_relaxed) : 0;
+        hashes.full = hashes.has_full ? std::atomic_ref<std::uint64_t>(slot.full).load(std::memory_order_relaxed) : 0;
+        return flags != 0;
+    }
+    return false;
+}
+
+/*
+    =========================================================
+        content_hash_cache::store
+    =========================================================
+
+    Single appender (append_mutex): a new slot gets its key and hash
+    first and its state last; a known slot gets the hash first and
+    the flag last.
+*/
+void content_hash_cache::store(const file_identity& identity, std::uint64_t hash, bool full)
+{
+    std::lock_guard<std::mutex> lock(append_mutex);
+
+    table_mapping* table = current.load();
+    if (!appender || table == nullptr)
+    {
+        return;
+    }
+
+    // Keep probe chains short: compact (and grow) at three quarters
+    if (std::atomic_ref<std::uint64_t>(header_of(table->base)->used).load() + 1 > table->slot_count / 4 * 3)
+    {
+        if (compact_locked() != hash_cache_status::ok)
+        {
+            return;
+        }
+        table = current.load();
+    }
+
+    table_slot* slots = slots_of(table->base);
+    std::uint64_t mask = table->slot_count - 1;
+    std::uint64_t index = slot_hash(identity) & mask;
+    std::uint64_t bit = full ? HAS_FULL : HAS_PARTIAL;
+
+    for (std::uint64_t probe = 0; probe < table->slot_count; probe++, index = (index + 1) & mask)
+    {
+        table_slot& slot = slots[index];
+        std::atomic_ref<std::uint64_t> state(slot.state);
+
+        if (state.load() == SLOT_READY)
+        {
+            if (!same_identity(slot, identity))
+            {
+                continue;
+            }
+            std::atomic_ref<std::uint64_t>(full ? slot.full : slot.partial).store(hash, std::memory_order_relaxed);
+            std::atomic_ref<std::uint64_t> flags(slot.flags);
+            flags.store(flags.load() | bit, std::memory_order_release);
+            return;
+        }
+
+        // Empty (or left half-written by a crashed appender)
+        slot.device = identity.device;
+        slot.inode = identity.inode;
+        slot.size = identity.size;
+        slot.mtime_ns = identity.mtime_ns;
+        slot.partial = full ? 0 : hash;
+        slot.full = full ? hash : 0;
+        slot.flags = bit;
+        state.store(SLOT_READY, std::memory_order_release);
+        std::atomic_ref<std::uint64_t>(header_of(table->base)->used).fetch_add(1);
+        return;
+    }
+}
+
+void content_hash_cache::store_partial(const file_identity& identity, std::uint64_t hash)
+{
+    store(identity, hash, false);
+}
+
+void content_hash_cache::store_full(const file_identity& identity, std::uint64_t hash)
+{
+    store(identity, hash, true);
+}
+
+/*
+    =========================================================
+        content_hash_cache::compact
+    =========================================================
+
+    1. Copy every published slot
+    2. Keep the newest (mtime, then size) of each (device, inode):
+       older ones describe content the file no longer has
+    3. Insert them into a fresh table of twice their number, written
+       under a temporary name, locked, and renamed over the old file
+
+    The old mapping is retired, not unmapped: lock-free readers may
+    still be walking it.
+*/
+hash_cache_status content_hash_cache::compact()
+{
+    std::lock_guard<std::mutex> lock(append_mutex);
+    return compact_locked();
+}
+
+hash_cache_status content_hash_cache::compact_locked()
+{
+    table_mapping* old_table = current.load();
+    if (!appender || old_table == nullptr)
+    {
+        return hash_cache_status::read_only;
+    }
+
+    std::vector<table_slot> kept;
+    table_slot* old_slots = slots_of(old_table->base);
+    for (std::uint64_t i = 0; i < old_table->slot_count; i++)
+    {
+        if (old_slots[i].state == SLOT_READY && old_slots[i].flags != 0)
+        {
+            kept.push_back(old_slots[i]);
+        }
+    }
+
+    std::sort(kept.begin(), kept.end(), [](const table_slot& a, const table_slot& b)
+    {
+        if (a.device != b.device) return a.device < b.device;
+        if (a.inode != b.inode) return a.inode < b.inode;
+        if (a.mtime_ns != b.mtime_ns) return a.mtime_ns < b.mtime_ns;
+        return a.size < b.size;
+    });
+    std::vector<table_slot>::iterator last = std::unique(kept.rbegin(), kept.rend(),
+        [](const table_slot& a, const table_slot& b) { return a.device == b.device && a.inode == b.inode; }).base();
+    kept.erase(kept.begin(), last);
+
+    std::uint64_t slot_count = INITIAL_SLOTS;
+    while (slot_count < 2 * static_cast<std::uint64_t>(kept.size()))
+    {
+        slot_count *= 2;
+    }
+
+    std::filesystem::path fresh = path;
+    fresh += ".compact." + std::to_string(getpid());
+
+    int fresh_fd = -1;
+    table_mapping* table = create_table(fresh, slot_count, fresh_fd);
+    if (table == nullptr)
+    {
+        return hash_cache_status::unavailable;
+    }
+
+    // Nobody else can see the fresh table yet: plain stores are enough
+    table_slot* slots = slots_of(table->base);
+    std::uint64_t mask = slot_count - 1;
+    for (const table_slot& entry : kept)
+    {
+        file_identity identity{entry.device, entry.inode, entry.size, entry.mtime_ns};
+        std::uint64_t index = slot_hash(identity) & mask;
+        while (slots[index].state == SLOT_READY)
+        {
+            index = (index + 1) & mask;
+        }
+        slots[index] = entry;
+    }
+    header_of(table->base)->used = kept.size();
+
+    if (flock(fresh_fd, LOCK_EX | LOCK_NB) != 0 || rename(fresh.c_str(), path.c_str()) != 0)
+    {
+        munmap(table->base, table->length);
+        delete table;
+        ::close(fresh_fd);
+        unlink(fresh.c_str());
+        return hash_cache_status::unavailable;
+    }
+
+    ::close(fd);
+    fd = fresh_fd;
+    retired.push_back(old_table);
+    current.store(table, std::memory_order_release);
+    return hash_cache_status::ok;
+}
+
+#else
+
+/*
+    =========================================================
+        content_hash_cache (no mmap)
+    =========================================================
+
+    Always closed: lookups miss, stores are dropped.
+*/
+hash_cache_status content_hash_cache::open(const std::filesystem::path& cache_path)
+{
+    path = cache_path;
+    return hash_cache_status::unavailable;
+}
+
+void content_hash_cache::close()
+{
+}
+
+bool content_hash_cache::lookup(const file_identity& identity, cached_hashes& hashes) const
+{
+    (void)identity;
+    hashes = cached_hashes();
+    return false;
+}
+
+void content_hash_cache::store_partial(const file_identity& identity, std::uint64_t hash)
+{
+    (void)identity;
+    (void)hash;
+}
+
+void content_hash_cache::store_full(const file_identity& identity, std::uint64_t hash)
+{
+    (void)identity;
+    (void)hash;
+}
+
+hash_cache_status content_hash_cache::compact()
+{
+    return hash_cache_status::unavailable;
+}
+
+#endif
+
+std::size_t content_hash_cache::entries() const
+{
+    table_mapping* table = current.load(std::memory_order_acquire);
+    return table == nullptr ? 0
+                            : static_cast<std::size_t>(std::atomic_ref<std::uint64_t>(header_of(table->base)->used).load());
+}
+
+std::size_t content_hash_cache::capacity() const
+{
+    table_mapping* table = current.load(std::memory_order_acquire);
+    return table == nullptr ? 0 : static_cast<std::size_t>(table->slot_count);
+}
+
+
+/*
+    =========================================================
+        partial_content_hash / full_content_hash
+    =========================================================
+
+    FNV-1a, 64 bit, like copy verification (cold_tier), so a hash
+    recorded by a verified copy is a valid full hash here.
+*/
+static const std::uint64_t FNV_SEED = 14695981039346656037ULL;
+
+static void hash_block(std::uint64_t& hash, const char* data, std::size_t length)
+{
+    for (std::size_t i = 0; i < length; i++)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+}
+
+// Hashes [offset, offset + length) of in into hash
+static bool hash_range(std::ifstream& in, std::uint64_t offset, std::uint64_t length,
+                       std::vector<char>& buffer, std::uint64_t& hash)
+{
+    in.seekg(static_cast<std::streamoff>(offset));
+    while (length > 0 && in)
+    {
+        std::size_t wanted = static_cast<std::size_t>(std::min<std::uint64_t>(length, buffer.size()));
+        in.read(buffer.data(), static_cast<std::streamsize>(wanted));
+        std::size_t got = static_cast<std::size_t>(in.gcount());
+        if (got == 0)
+        {
+            return false;
+        }
+        hash_block(hash, buffer.data(), got);
+        length -= got;
+    }
+    return length == 0;
+}
+
+/*
+    Hash of the content of file_path (partial or full), ignoring the
+    cache. size is the size the file had when it was identified.
+*/
+static bool compute_content_hash(const std::filesystem::path& file_path, std::uint64_t size, bool full, std::uint64_t& hash)
+{
+    std::ifstream in(file_path, std::ios::binary);
+    if (!in.is_open())
+    {
+        return false;
+    }
+
+    std::vector<char> buffer(memory_governor::shared().scaled(READ_BLOCK, MIN_READ_BLOCK));
+    hash = FNV_SEED;
+
+    if (full)
+    {
+        return hash_range(in, 0, size, buffer, hash);
+    }
+
+    // Size first, so files that only differ in their middle length differ here
+    char size_bytes[8];
+    for (int i = 0; i < 8; i++)
+    {
+        size_bytes[i] = static_cast<char>((size >> (8 * i)) & 0xFF);
+    }
+    hash_block(hash, size_bytes, sizeof(size_bytes));
+
+    std::uint64_t head = std::min<std::uint64_t>(size, PARTIAL_BLOCK);
+    std::uint64_t tail = std::min<std::uint64_t>(size - head, PARTIAL_BLOCK);
+    return hash_range(in, 0, head, buffer, hash)
+        && hash_range(in, size - tail, tail, buffer, hash);
+}
+
+static hash_cache_status cached_content_hash(const std::filesystem::path& file_path, bool full, std::uint64_t& hash)
+{
+    content_hash_cache& cache = content_hash_cache::shared();
+    file_identity identity;
+    bool identified = identify_file(file_path, identity);
+
+    cached_hashes known;
+    if (identified && cache.lookup(identity, known) && (full ? known.has_full : known.has_partial))
+    {
+        hash = full ? known.full : known.partial;
+        return hash_cache_status::ok;
+    }
+
+    std::uint64_t size = identified ? identity.size : 0;
+    if (!identified)
+    {
+        std::error_code ec;
+        size = std::filesystem::file_size(file_path, ec);
+        if (ec)
+        {
+            return hash_cache_status::read_failed;
+        }
+    }
+
+    if (!compute_content_hash(file_path, size, full, hash))
+    {
+        return hash_cache_status::read_failed;
+    }
+
+    // Only recorded if the file did not change while it was read
+    file_identity after;
+    if (identified && identify_file(file_path, after)
+        && after.device == identity.device && after.inode == identity.inode
+        && after.size == identity.size && after.mtime_ns == identity.mtime_ns)
+    {
+        if (full)
+        {
+            cache.store_full(identity, hash);
+        }
+        else
+        {
+            cache.store_partial(identity, hash);
+        }
+    }
+    return hash_cache_status::ok;
+}
+
+hash_cache_status partial_content_hash(const std::filesystem::path& file_path, std::uint64_t& hash)
+{
+    return cached_content_hash(file_path, false, hash);
+}
+
+hash_cache_status full_content_hash(const std::filesystem::path& file_path, std::uint64_t& hash)
+{
+    return cached_content_hash(file_path, true, hash);
+}
@@ -0,0 +1,45 @@
+#include "decision_queue.hpp"
+
+/*
+    =========================================================
+        decision_queue
+    =========================================================
+*/
+void decision_queue::park(deferred_decision decision)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    parked.push_back(std::move(decision));
+}
+
+std::size_t decision_queue::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return parked.size();
+}
+
+std::vector<deferred_decision> decision_queue::take_all()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<deferred_decision> taken;
+    taken.swap(parked);
+    return taken;
+}
+
+/*
+    =========================================================
+        decide_all
+    =========================================================
+*/
+std::size_t decide_all(std::vector<deferred_decision>& decisions, decision_kind kind, decision_choice choice)
+{
+    std::size_t changed = 0;
+    for (deferred_decision& decision : decisions)
+    {
+        if (decision.kind == kind && decision.choice == decision_choice::undecided)
+        {
+            decision.choice = choice;
+            changed++;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,560 @@
+#include "directory_index.hpp"
+#include "extensions.hpp"
+#include "memory_governor.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+/*
+    =========================================================
+        Index file format
+    =========================================================
+
+    Plain text, one record per line, fields separated by TAB:
+
+        file_organizer_index 1
+        R   <extension>   <category>
+        F   <extension>   <relative path>
+
+    Text keeps the index debuggable with any editor.
+    Paths containing a newline cannot be represented and are
+    simply not indexed (they are still organized by a full run).
+*/
+static const char* INDEX_HEADER = "file_organizer_index 1";
+static const char* INDEX_FILE_NAME = "directory_index";
+
+/*
+    Spilled runs hold F records only, in the same (extension, path)
+    order as the index file, named "directory_index.run-<n>".
+
+    In-memory locations are spilled past INDEX_MEMORY_BUDGET, or past
+    MIN_PRESSURE_SPILL_BYTES once the heap target is reached (smaller
+    runs would save too little to be worth a file).
+*/
+static const std::size_t INDEX_MEMORY_BUDGET = 32 * 1024 * 1024;
+static const std::size_t MIN_PRESSURE_SPILL_BYTES = 1024 * 1024;
+
+/*
+    Rough heap footprint of one location: the path's buffer,
+    its std::string and the set node around it.
+*/
+static std::size_t estimated_size(const std::string& relative_path)
+{
+    return relative_path.capacity() + sizeof(std::string) + 4 * sizeof(void*);
+}
+
+/*
+    Splits "<kind>\t<extension>\t<value>".
+    Returns the kind ('R' / 'F'), or 0 if the line is malformed.
+*/
+static char parse_record(const std::string& line, std::string& extension, std::string& value)
+{
+    std::string::size_type first_tab = line.find('\t');
+    std::string::size_type second_tab =
+        (first_tab == std::string::npos) ? std::string::npos : line.find('\t', first_tab + 1);
+
+    if (first_tab != 1 || second_tab == std::string::npos || (line[0] != 'R' && line[0] != 'F'))
+    {
+        return 0;
+    }
+
+    extension = line.substr(first_tab + 1, second_tab - first_tab - 1);
+    value = line.substr(second_tab + 1);
+    return line[0];
+}
+
+
+std::filesystem::path get_state_directory(const std::string& root_path)
+{
+    return std::filesystem::path(root_path) / ".file_organizer";
+}
+
+/*
+    =========================================================
+        index_spill
+    =========================================================
+*/
+index_spill::~index_spill()
+{
+    remove_runs();
+}
+
+index_spill::index_spill(index_spill&& other) noexcept
+    : paged_from(std::move(other.paged_from))
+    , run_files(std::move(other.run_files))
+    , forgotten(std::move(other.forgotten))
+    , memory_bytes(other.memory_bytes)
+    , failed(other.failed)
+{
+    other.run_files.clear();
+}
+
+index_spill& index_spill::operator=(index_spill&& other) noexcept
+{
+    if (this != &other)
+    {
+        remove_runs();
+        paged_from = std::move(other.paged_from);
+        run_files = std::move(other.run_files);
+        forgotten = std::move(other.forgotten);
+        memory_bytes = other.memory_bytes;
+        failed = other.failed;
+        other.run_files.clear();
+    }
+    return *this;
+}
+
+bool index_spill::has_disk_part() const
+{
+    return !paged_from.empty() || !run_files.empty();
+}
+
+void index_spill::remove_runs()
+{
+    std::error_code ec;
+    for (const std::filesystem::path& run : run_files)
+    {
+        std::filesystem::remove(run, ec);
+    }
+    run_files.clear();
+}
+
+/*
+    =========================================================
+        load_directory_index
+    =========================================================
+
+    extensions == nullptr loads every group. Otherwise only the
+    listed groups are loaded and the file stays the disk part of
+    the index; rules come first in every index this code writes,
+    so a rules-only load stops at the first location.
+*/
+static index_status load_index_file(
+    const std::string& root_path,
+    directory_index& index,
+    const std::set<std::string>* extensions
+    )
+{
+    index.rules.clear();
+    index.locations.clear();
+    index.spill = index_spill();
+
+    std::filesystem::path index_path = get_state_directory(root_path) / INDEX_FILE_NAME;
+
+    std::ifstream in(index_path);
+    if (!in.is_open())
+    {
+        return index_status::not_found;
+    }
+
+    std::string line;
+    if (!std::getline(in, line) || line != INDEX_HEADER)
+    {
+        return index_status::corrupt;
+    }
+
+    std::string extension;
+    std::string value;
+
+    while (std::getline(in, line))
+    {
+        if (line.empty())
+        {
+            continue;
+        }
+
+        char kind = parse_record(line, extension, value);
+        if (kind == 0)
+        {
+            index.rules.clear();
+            index.locations.clear();
+            return index_status::corrupt;
+        }
+
+        if (kind == 'R')
+        {
+            index.rules[extension] = value;
+        }
+        else if (extensions == nullptr || extensions->count(extension) != 0)
+        {
+            if (index.locations[extension].insert(value).second)
+            {
+                index.spill.memory_bytes += estimated_size(value);
+            }
+        }
+        else if (extensions->empty())
+        {
+            break;
+        }
+    }
+
+    if (extensions != nullptr)
+    {
+        index.spill.paged_from = index_path;
+    }
+    return index_status::ok;
+}
+
+index_status load_directory_index(const std::string& root_path, directory_index& index)
+{
+    return load_index_file(root_path, index, nullptr);
+}
+
+index_status load_directory_index(
+    const std::string& root_path,
+    directory_index& index,
+    const std::set<std::string>& extensions
+    )
+{
+    return load_index_file(root_path, index, &extensions);
+}
+
+/*
+    =========================================================
+        Merging for save
+    =========================================================
+
+    One sorted stream of locations per file on disk (the previous
+    index file, each run); the in-memory part is a third kind of
+    stream. All are in (extension, path) order, so a k-way merge
+    writes them sorted, dropping duplicates and forgotten entries.
+*/
+struct location_stream
+{
+    std::ifstream in;
+    std::string extension;
+    std::string path;
+    bool valid = false;
+
+    // Next F record; malformed lines and rules are skipped
+    void advance()
+    {
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (!line.empty() && parse_record(line, extension, path) == 'F')
+            {
+                valid = true;
+                return;
+            }
+        }
+        valid = false;
+    }
+};
+
+static bool location_less(
+    const std::string& a_extension, const std::string& a_path,
+    const std::string& b_extension, const std::string& b_path
+    )
+{
+    return a_extension != b_extension ? a_extension < b_extension : a_path < b_path;
+}
+
+static void write_merged_locations(std::ofstream& out, const directory_index& index)
+{
+    std::vector<std::unique_ptr<location_stream>> streams;
+
+    std::vector<std::filesystem::path> disk_files = index.spill.run_files;
+    if (!index.spill.paged_from.empty())
+    {
+        disk_files.push_back(index.spill.paged_from);
+    }
+
+    for (const std::filesystem::path& file : disk_files)
+    {
+        std::unique_ptr<location_stream> stream = std::make_unique<location_stream>();
+        stream->in.open(file);
+        stream->advance();
+        streams.push_back(std::move(stream));
+    }
+
+    std::map<std::string, std::set<std::string>>::const_iterator group = index.locations.begin();
+    std::set<std::string>::const_iterator member;
+    if (group != index.locations.end())
+    {
+        member = group->second.begin();
+    }
+
+    std::string last_extension;
+    std::string last_path;
+    bool wrote_any = false;
+
+    for (;;)
+    {
+        // Skip emptied groups of the in-memory part
+        while (group != index.locations.end() && member == group->second.end())
+        {
+            ++group;
+            if (group != index.locations.end())
+            {
+                member = group->second.begin();
+            }
+        }
+
+        // Smallest head: nullptr = the in-memory part
+        location_stream* smallest = nullptr;
+        bool any = (group != index.locations.end());
+        for (const std::unique_ptr<location_stream>& stream : streams)
+        {
+            if (!stream->valid)
+            {
+                continue;
+            }
+            if (!any || location_less(stream->extension, stream->path,
+                                      smallest != nullptr ? smallest->extension : group->first,
+                                      smallest != nullptr ? smallest->path : *member))
+            {
+                smallest = stream.get();
+                any = true;
+            }
+        }
+        if (!any)
+        {
+            break;
+        }
+
+        const std::string& extension = smallest != nullptr ? smallest->extension : group->first;
+        const std::string& path = smallest != nullptr ? smallest->path : *member;
+
+        bool duplicate = wrote_any && extension == last_extension && path == last_path;
+        if (!duplicate && index.spill.forgotten.count(std::make_pair(extension, path)) == 0)
+        {
+            out << "F\t" << extension << '\t' << path << '\n';
+            last_extension = extension;
+            last_path = path;
+            wrote_any = true;
+        }
+
+        if (smallest != nullptr)
+        {
+            smallest->advance();
+        }
+        else
+        {
+            ++member;
+        }
+    }
+}
+
+/*
+    =========================================================
+        save_directory_index
+    =========================================================
+*/
+index_status save_directory_index(const std::string& root_path, directory_index& index)
+{
+    std::filesystem::path state_directory = get_state_directory(root_path);
+    std::filesystem::path index_path = state_directory / INDEX_FILE_NAME;
+    std::filesystem::path temp_path = state_directory / (std::string(INDEX_FILE_NAME) + ".tmp");
+
+    std::error_code ec;
+    std::filesystem::create_directories(state_directory, ec);
+    if (ec)
+    {
+        return index_status::write_failed;
+    }
+
+    {
+        std::ofstream out(temp_path, std::ios::trunc);
+        if (!out.is_open())
+        {
+            return index_status::write_failed;
+        }
+
+        out << INDEX_HEADER << '\n';
+
+        for (const std::pair<const std::string, std::string>& rule : index.rules)
+        {
+            out << "R\t" << rule.first << '\t' << rule.second << '\n';
+        }
+
+        write_merged_locations(out, index);
+
+        out.flush();
+        if (!out)
+        {
+            return index_status::write_failed;
+        }
+    }
+
+    std::filesystem::rename(temp_path, index_path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(temp_path, ec);
+        return index_status::write_failed;
+    }
+
+    // Everything is in the new file now; memory keeps only what it held
+    index.spill.remove_runs();
+    index.spill.paged_from = index_path;
+    return index_status::ok;
+}
+
+/*
+    Writes the in-memory locations as one sorted run and drops them
+    from memory. On failure they simply stay in memory.
+*/
+static void spill_locations(directory_index& index, const std::string& root_path)
+{
+    std::filesystem::path state_directory = get_state_directory(root_path);
+    std::filesystem::path run_path =
+        state_directory / (std::string(INDEX_FILE_NAME) + ".run-" + std::to_string(index.spill.run_files.size()));
+
+    std::error_code ec;
+    std::filesystem::create_directories(state_directory, ec);
+
+    std::ofstream out(run_path, std::ios::trunc);
+    if (ec || !out.is_open())
+    {
+        index.spill.failed = true;
+        return;
+    }
+    index.spill.run_files.push_back(run_path);
+
+    for (const std::pair<const std::string, std::set<std::string>>& group : index.locations)
+    {
+        for (const std::string& relative_path : group.second)
+        {
+            out << "F\t" << group.first << '\t' << relative_path << '\n';
+        }
+    }
+
+    out.flush();
+    if (!out)
+    {
+        out.close();
+        std::filesystem::remove(run_path, ec);
+        index.spill.run_files.pop_back();
+        index.spill.failed = true;
+        return;
+    }
+
+    index.locations.clear();
+    index.spill.memory_bytes = 0;
+}
+
+/*
+    =========================================================
+        record_file_location / forget_file_location
+    =========================================================
+*/
+void record_file_location(
+    directory_index& index,
+    const std::string& root_path,
+    const std::filesystem::path& file_path
+    )
+{
+    std::string relative_path = file_path.lexically_relative(root_path).generic_string();
+
+    // Outside the root, or not representable in the line-based format
+    if (relative_path.empty() || relative_path.starts_with("..")
+        || relative_path.find('\n') != std::string::npos)
+    {
+        return;
+    }
+
+    std::string extension = normalize_extension(file_path.string());
+    if (!index.spill.forgotten.empty())
+    {
+        index.spill.forgotten.erase(std::make_pair(extension, relative_path));
+    }
+
+    if (index.locations[extension].insert(relative_path).second)
+    {
+        index.spill.memory_bytes += estimated_size(relative_path);
+    }
+
+    std::size_t bytes = index.spill.memory_bytes;
+    if (!index.spill.failed
+        && (bytes > INDEX_MEMORY_BUDGET
+            || (bytes >= MIN_PRESSURE_SPILL_BYTES && memory_governor::shared().over_target())))
+    {
+        spill_locations(index, root_path);
+    }
+}
+
+void forget_file_location(
+    directory_index& index,
+    const std::string& root_path,
+    const std::filesystem::path& file_path
+    )
+{
+    std::string relative_path = file_path.lexically_relative(root_path).generic_string();
+    std::string extension = normalize_extension(file_path.string());
+
+    // Also on disk, maybe: hide it there when merging
+    if (index.spill.has_disk_part())
+    {
+        index.spill.forgotten.insert(std::make_pair(extension, relative_path));
+    }
+
+    std::map<std::string, std::set<std::string>>::iterator it = index.locations.find(extension);
+    if (it == index.locations.end())
+    {
+        return;
+    }
+
+    if (it->second.erase(relative_path) != 0)
+    {
+        std::size_t size = estimated_size(relative_path);
+        index.spill.memory_bytes -= std::min(size, index.spill.memory_bytes);
+    }
+    if (it->second.empty())
+    {
+        index.locations.erase(it);
+    }
+}
+
+/*
+    =========================================================
+        diff_rule_tables
+    =========================================================
+
+    Single merge pass over two sorted maps.
+*/
+std::set<std::string> diff_rule_tables(
+    const std::map<std::string, std::string>& old_rules,
+    const std::map<std::string, std::string>& new_rules
+    )
+{
+    std::set<std::string> changed_extensions;
+
+    std::map<std::string, std::string>::const_iterator old_it = old_rules.begin();
+    std::map<std::string, std::string>::const_iterator new_it = new_rules.begin();
+
+    while (old_it != old_rules.end() || new_it != new_rules.end())
+    {
+        if (new_it == new_rules.end()
+            || (old_it != old_rules.end() && old_it->first < new_it->first))
+        {
+            // Extension removed: files fall back to "Others"
+            if (old_it->second != "Others")
+            {
+                changed_extensions.insert(old_it->first);
+            }
+            ++old_it;
+        }
+        else if (old_it == old_rules.end() || new_it->first < old_it->first)
+        {
+            // Extension added: files used to be "Others"
+            if (new_it->second != "Others")
+            {
+                changed_extensions.insert(new_it->first);
+            }
+            ++new_it;
+        }
+        else
+        {
+            if (old_it->second != new_it->second)
+            {
+                changed_extensions.insert(old_it->first);
+            }
+            ++old_it;
+            ++new_it;
+        }
+    }
+
+    return changed_extensions;
+}
@@ -93,7 +93,7 @@ const std::map<std::string, std::set<std::string>> CATEGORY_EXTENSION_MAP = {
     // ---------- ARCHIVES ----------
     { "Archive Files", {
                           "zip", "rar", "7z", "tar", "gz",
-                          "bz2", "xz", "tgz"
+                          "bz2", "xz", "tgz", "zst"
                       }},
 
     // ---------- EXECUTABLES ----------
@@ -178,19 +178,19 @@ const std::map<std::string, std::string> EXTENSION_LOOKUP = []()
 
 
 /*
-    classify_file_by_extension
-    --------------------------
-    Determines the category of a file using its extension.
+    normalize_extension
+    -------------------
+    Extracts the lookup key used by EXTENSION_LOOKUP from a path.
 */
-std::string classify_file_by_extension(const std::string& file_path)
+std::string normalize_extension(const std::string& file_path)
 {
     // Safely extract extension using filesystem
     std::filesystem::path path(file_path);
     std::string extension = path.extension().string();
 
-    // If no extension exists, treat as unknown
+    // If no extension exists, there is nothing to normalize
     if (extension.empty())
-        return "Others";
+        return extension;
 
     // Remove leading '.' from extension
     extension.erase(0, 1);
@@ -203,9 +203,62 @@ std::string classify_file_by_extension(const std::string& file_path)
         ::tolower
     );
 
+    return extension;
+}
+
+
+/*
+    classify_file_by_extension
+    --------------------------
+    Determines the category of a file using its extension.
+*/
+std::string classify_file_by_extension(const std::string& file_path)
+{
+    return classify_with_rules(builtin_rule_table(), file_path);
+}
+
+
+/*
+    builtin_rule_table / make_rule_table
+    ------------------------------------
+    The built-in table is a snapshot of EXTENSION_LOOKUP and
+    CANONICAL_NAMES, built on first use.
+*/
+const rule_table& builtin_rule_table()
+{
+    static const rule_table builtin = { EXTENSION_LOOKUP, CANONICAL_NAMES };
+    return builtin;
+}
+
+rule_table make_rule_table(const std::map<std::string, std::string>& extension_lookup)
+{
+    rule_table rules;
+    rules.extension_lookup = extension_lookup;
+
+    for (const std::pair<const std::string, std::string>& rule : extension_lookup)
+    {
+        rules.category_names.insert(rule.second);
+    }
+    return rules;
+}
+
+
+/*
+    classify_with_rules
+    -------------------
+    Determines the category of a file using its extension.
+*/
+std::string classify_with_rules(const rule_table& rules, const std::string& file_path)
+{
+    std::string extension = normalize_extension(file_path);
+
+    // If no extension exists, treat as unknown
+    if (extension.empty())
+        return "Others";
+
     // Perform fast lookup
-    std::map<std::string, std::string>::const_iterator it = EXTENSION_LOOKUP.find(extension);
-    if (it != EXTENSION_LOOKUP.end())
+    std::map<std::string, std::string>::const_iterator it = rules.extension_lookup.find(extension);
+    if (it != rules.extension_lookup.end())
         return it->second;
 
     // Fallback category
@@ -0,0 +1,420 @@
+#include "fanotify_watcher.hpp"
+
+#include <cstdint>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/fanotify.h>
+#include <unistd.h>
+#endif
+
+/*
+    Everything below needs fanotify with directory file handles
+    (Linux 5.9+ headers). Other builds get a stub that reports
+    watch_status::unsupported.
+*/
+#if defined(__linux__) && defined(FAN_REPORT_DFID_NAME)
+
+/*
+    Events we care about:
+    - FAN_CLOSE_WRITE: a file finished being written
+    - FAN_MOVED_TO:    a file was moved / renamed in
+    - FAN_MOVED_FROM + FAN_ONDIR: a directory was renamed,
+      cached paths below it may now be stale
+*/
+static const std::uint64_t WATCH_MASK = FAN_CLOSE_WRITE | FAN_MOVE | FAN_ONDIR;
+
+/*
+    =========================================================
+        make_handle_key
+    =========================================================
+
+    Cache key for a directory handle: fsid + handle type + handle bytes.
+    The fsid keeps handles of different filesystems apart.
+*/
+static std::string make_handle_key(const void* fsid, std::size_t fsid_size, const file_handle* handle)
+{
+    std::string key;
+    key.reserve(fsid_size + sizeof(handle->handle_type) + handle->handle_bytes);
+
+    key.append(static_cast<const char*>(fsid), fsid_size);
+    key.append(reinterpret_cast<const char*>(&handle->handle_type), sizeof(handle->handle_type));
+    key.append(reinterpret_cast<const char*>(handle->f_handle), handle->handle_bytes);
+
+    return key;
+}
+
+/*
+    =========================================================
+        find_directory_record
+    =========================================================
+
+    Finds the (directory handle, name) record of an event.
+    Returns false if the event carries none.
+*/
+static bool find_directory_record(
+    fanotify_event_metadata* metadata,
+    std::string& handle_key,
+    file_handle*& handle,
+    const char*& name
+    )
+{
+    // Info records follow the fixed metadata
+    char* record = reinterpret_cast<char*>(metadata) + metadata->metadata_len;
+    char* event_end = reinterpret_cast<char*>(metadata) + metadata->event_len;
+
+    while (record + sizeof(fanotify_event_info_header) <= event_end)
+    {
+        fanotify_event_info_header* header = reinterpret_cast<fanotify_event_info_header*>(record);
+        if (header->len == 0)
+        {
+            return false;
+        }
+
+        if (header->info_type == FAN_EVENT_INFO_TYPE_DFID_NAME)
+        {
+            fanotify_event_info_fid* fid = reinterpret_cast<fanotify_event_info_fid*>(record);
+            handle = reinterpret_cast<file_handle*>(fid->handle);
+            name = reinterpret_cast<const char*>(handle->f_handle + handle->handle_bytes);
+            handle_key = make_handle_key(&fid->fsid, sizeof(fid->fsid), handle);
+            return true;
+        }
+
+        record += header->len;
+    }
+    return false;
+}
+
+fanotify_watcher::~fanotify_watcher()
+{
+    if (fanotify_fd != -1)
+    {
+        close(fanotify_fd);
+    }
+    if (mount_fd != -1)
+    {
+        close(mount_fd);
+    }
+}
+
+watch_coverage fanotify_watcher::coverage() const
+{
+    return current_coverage;
+}
+
+/*
+    =========================================================
+        fanotify_watcher::start
+    =========================================================
+*/
+watch_status fanotify_watcher::start(const std::string& root_path)
+{
+    std::error_code ec;
+
+    // Resolved the same way /proc/self/fd links are, so prefixes compare
+    root = std::filesystem::canonical(root_path, ec);
+    if (ec)
+    {
+        return watch_status::failed;
+    }
+
+    fanotify_fd = fanotify_init(
+        FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_REPORT_DFID_NAME,
+        O_RDONLY | O_LARGEFILE
+        );
+
+    if (fanotify_fd == -1)
+    {
+        if (errno == EPERM)
+        {
+            return watch_status::permission_denied;
+        }
+        if (errno == EINVAL || errno == ENOSYS)
+        {
+            return watch_status::unsupported;
+        }
+        return watch_status::failed;
+    }
+
+    mount_fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (mount_fd == -1)
+    {
+        return watch_status::failed;
+    }
+
+    // Preferred: one mark for the whole filesystem
+    if (fanotify_mark(fanotify_fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, WATCH_MASK, AT_FDCWD, root.c_str()) == 0)
+    {
+        current_coverage = watch_coverage::filesystem;
+    }
+    // Fallback: only the root directory and its direct children
+    else if (fanotify_mark(fanotify_fd, FAN_MARK_ADD | FAN_MARK_ONLYDIR, WATCH_MASK | FAN_EVENT_ON_CHILD,
+                           AT_FDCWD, root.c_str()) == 0)
+    {
+        current_coverage = watch_coverage::root_only;
+    }
+    else
+    {
+        return (errno == EPERM || errno == EACCES) ? watch_status::permission_denied : watch_status::failed;
+    }
+
+    return watch_status::ok;
+}
+
+/*
+    =========================================================
+        fanotify_watcher::resolve_directory
+    =========================================================
+*/
+bool fanotify_watcher::resolve_directory(const std::string& handle_key, void* handle, std::filesystem::path& directory)
+{
+    std::unordered_map<std::string, std::filesystem::path>::const_iterator cached = handle_cache.find(handle_key);
+    if (cached != handle_cache.end())
+    {
+        directory = cached->second;
+        return !directory.empty();
+    }
+
+    // Only the root itself is marked: every event comes from it
+    if (current_coverage == watch_coverage::root_only)
+    {
+        directory = root;
+        return true;
+    }
+
+    if (handle_cache.size() >= HANDLE_CACHE_LIMIT)
+    {
+        handle_cache.clear();
+    }
+
+    // O_PATH: we only need the name, not access to the directory
+    int directory_fd = open_by_handle_at(mount_fd, static_cast<file_handle*>(handle), O_PATH | O_CLOEXEC);
+
+    if (directory_fd == -1)
+    {
+        // Deleted directory or other transient failure: do not cache
+        return false;
+    }
+
+    char link_target[PATH_MAX];
+    std::string proc_path = "/proc/self/fd/" + std::to_string(directory_fd);
+    ssize_t length = readlink(proc_path.c_str(), link_target, sizeof(link_target) - 1);
+    close(directory_fd);
+
+    if (length <= 0)
+    {
+        return false;
+    }
+
+    std::string resolved(link_target, static_cast<std::size_t>(length));
+    const std::string& root_string = root.native();
+
+    // Cheap prefix check; anything outside the root is remembered as empty
+    bool under_root = resolved == root_string
+        || (resolved.size() > root_string.size()
+            && resolved.compare(0, root_string.size(), root_string) == 0
+            && resolved[root_string.size()] == '/');
+
+    directory = under_root ? std::filesystem::path(resolved) : std::filesystem::path();
+    handle_cache.emplace(handle_key, directory);
+
+    return under_root;
+}
+
+/*
+    =========================================================
+        fanotify_watcher::forget_moved_directory
+    =========================================================
+*/
+void fanotify_watcher::forget_moved_directory(const std::string& handle_key, void* handle, const char* name, bool moved_in)
+{
+    if (handle_cache.empty())
+    {
+        return;
+    }
+
+    std::filesystem::path parent;
+    if (!resolve_directory(handle_key, handle, parent))
+    {
+        // Outside the root: nothing cached below the root changed
+        std::unordered_map<std::string, std::filesystem::path>::const_iterator cached = handle_cache.find(handle_key);
+        if (cached == handle_cache.end())
+        {
+            // Parent gone (or unresolvable): cannot tell what moved
+            handle_cache.clear();
+        }
+        return;
+    }
+
+    if (moved_in)
+    {
+        // Its directories were remembered as outside the root
+        std::erase_if(handle_cache, [](const std::pair<const std::string, std::filesystem::path>& entry)
+        {
+            return entry.second.empty();
+        });
+        return;
+    }
+
+    // Left the parent: the old paths of the subtree are stale
+    const std::string moved = (parent / name).native();
+    std::erase_if(handle_cache, [&moved](const std::pair<const std::string, std::filesystem::path>& entry)
+    {
+        const std::string& path = entry.second.native();
+        return path.size() >= moved.size()
+            && path.compare(0, moved.size(), moved) == 0
+            && (path.size() == moved.size() || path[moved.size()] == '/');
+    });
+}
+
+/*
+    =========================================================
+        fanotify_watcher::wait_for_changes
+    =========================================================
+*/
+watch_status fanotify_watcher::wait_for_changes(int timeout_ms, std::vector<std::filesystem::path>& changed_files)
+{
+    if (fanotify_fd == -1)
+    {
+        return watch_status::failed;
+    }
+
+    pollfd poll_descriptor = { fanotify_fd, POLLIN, 0 };
+    int ready = poll(&poll_descriptor, 1, timeout_ms);
+    if (ready == 0 || (ready == -1 && errno == EINTR))
+    {
+        return watch_status::ok;
+    }
+    if (ready == -1)
+    {
+        return watch_status::failed;
+    }
+
+    bool overflow = false;
+
+    // Drain everything that is queued right now
+    while (true)
+    {
+        alignas(fanotify_event_metadata) char buffer[64 * 1024];
+        ssize_t length = read(fanotify_fd, buffer, sizeof(buffer));
+
+        if (length == -1)
+        {
+            if (errno == EAGAIN || errno == EINTR)
+            {
+                break;
+            }
+            return watch_status::failed;
+        }
+
+        fanotify_event_metadata* metadata = reinterpret_cast<fanotify_event_metadata*>(buffer);
+
+        for (; FAN_EVENT_OK(metadata, length); metadata = FAN_EVENT_NEXT(metadata, length))
+        {
+            if (metadata->vers != FANOTIFY_METADATA_VERSION)
+            {
+                return watch_status::failed;
+            }
+
+            // FID reporting normally gives FAN_NOFD, but never leak one
+            if (metadata->fd >= 0)
+            {
+                close(metadata->fd);
+            }
+
+            if (metadata->mask & FAN_Q_OVERFLOW)
+            {
+                overflow = true;
+                continue;
+            }
+
+            std::string key;
+            file_handle* handle = nullptr;
+            const char* name = nullptr;
+
+            // A renamed directory can invalidate cached paths below it
+            if (metadata->mask & FAN_ONDIR)
+            {
+                if ((metadata->mask & FAN_MOVE) == 0)
+                {
+                    continue;
+                }
+                if (find_directory_record(metadata, key, handle, name))
+                {
+                    if (metadata->mask & FAN_MOVED_FROM)
+                    {
+                        forget_moved_directory(key, handle, name, false);
+                    }
+                    if (metadata->mask & FAN_MOVED_TO)
+                    {
+                        forget_moved_directory(key, handle, name, true);
+                    }
+                }
+                else
+                {
+                    handle_cache.clear();
+                }
+                continue;
+            }
+
+            if ((metadata->mask & (FAN_CLOSE_WRITE | FAN_MOVED_TO)) == 0)
+            {
+                continue;
+            }
+
+            std::filesystem::path directory;
+            if (find_directory_record(metadata, key, handle, name) && resolve_directory(key, handle, directory))
+            {
+                changed_files.push_back(directory / name);
+            }
+        }
+    }
+
+    return overflow ? watch_status::queue_overflow : watch_status::ok;
+}
+
+#else
+
+fanotify_watcher::~fanotify_watcher()
+{
+}
+
+watch_coverage fanotify_watcher::coverage() const
+{
+    return current_coverage;
+}
+
+watch_status fanotify_watcher::start(const std::string& root_path)
+{
+    (void)root_path;
+    return watch_status::unsupported;
+}
+
+watch_status fanotify_watcher::wait_for_changes(int timeout_ms, std::vector<std::filesystem::path>& changed_files)
+{
+    (void)timeout_ms;
+    (void)changed_files;
+    return watch_status::unsupported;
+}
+
+bool fanotify_watcher::resolve_directory(const std::string& handle_key, void* handle, std::filesystem::path& directory)
+{
+    (void)handle_key;
+    (void)handle;
+    (void)directory;
+    return false;
+}
+
+void fanotify_watcher::forget_moved_directory(const std::string& handle_key, void* handle, const char* name, bool moved_in)
+{
+    (void)handle_key;
+    (void)handle;
+    (void)name;
+    (void)moved_in;
+}
+
+#endif
@@ -0,0 +1,209 @@
+#include "filename_sanitizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <set>
+
+/*
+    =========================================================
+        CHARACTER_CLASS
+    =========================================================
+
+    One byte of flags per possible input byte.
+
+    A lookup table keeps the scan branch-light: the clean-name
+    fast path in needs_sanitizing is one load and one AND per byte.
+*/
+static constexpr unsigned char CONTROL_CHARACTER = 1;
+static constexpr unsigned char RESERVED_CHARACTER = 2;
+
+static constexpr std::array<unsigned char, 256> CHARACTER_CLASS = []
+{
+    std::array<unsigned char, 256> table{};
+
+    for (int c = 0x00; c <= 0x1F; c++)
+    {
+        table[c] = CONTROL_CHARACTER;
+    }
+    table[0x7F] = CONTROL_CHARACTER;
+
+    for (unsigned char c : { '<', '>', ':', '"', '/', '\\', '|', '?', '*' })
+    {
+        table[c] = RESERVED_CHARACTER;
+    }
+
+    return table;
+}();
+
+/*
+    Device names Windows refuses as file names,
+    with or without an extension ("CON", "con.txt", ...).
+*/
+static const std::set<std::string> RESERVED_DEVICE_NAMES = {
+    "CON", "PRN", "AUX", "NUL",
+    "COM1", "COM2", "COM3", "COM4", "COM5", "COM6", "COM7", "COM8", "COM9",
+    "LPT1", "LPT2", "LPT3", "LPT4", "LPT5", "LPT6", "LPT7", "LPT8", "LPT9"
+};
+
+static unsigned char character_mask(const sanitize_policy& policy)
+{
+    unsigned char mask = 0;
+    if (policy.replace_control_characters)
+    {
+        mask |= CONTROL_CHARACTER;
+    }
+    if (policy.replace_reserved_characters)
+    {
+        mask |= RESERVED_CHARACTER;
+    }
+    return mask;
+}
+
+static bool is_reserved_device_name(const std::string& filename)
+{
+    // Only the part before the FIRST dot matters: "nul.tar.gz" is reserved too
+    std::string base = filename.substr(0, filename.find('.'));
+    std::transform(base.begin(), base.end(), base.begin(), ::toupper);
+
+    return RESERVED_DEVICE_NAMES.find(base) != RESERVED_DEVICE_NAMES.end();
+}
+
+/*
+    Largest length <= limit that does not split a UTF-8 sequence.
+*/
+static std::size_t utf8_safe_length(const std::string& text, std::size_t limit)
+{
+    if (limit >= text.size())
+    {
+        return text.size();
+    }
+
+    // Continuation bytes look like 10xxxxxx
+    while (limit > 0 && (static_cast<unsigned char>(text[limit]) & 0xC0) == 0x80)
+    {
+        limit--;
+    }
+    return limit;
+}
+
+/*
+    =========================================================
+        needs_sanitizing
+    =========================================================
+*/
+bool needs_sanitizing(const std::string& filename, const sanitize_policy& policy)
+{
+    if (!policy.enabled)
+    {
+        return false;
+    }
+
+    if (filename.empty() || filename.size() > policy.max_name_bytes)
+    {
+        return true;
+    }
+
+    unsigned char mask = character_mask(policy);
+    unsigned char seen = 0;
+    for (unsigned char c : filename)
+    {
+        seen |= CHARACTER_CLASS[c];
+    }
+    if ((seen & mask) != 0)
+    {
+        return true;
+    }
+
+    if (policy.trim_spaces_and_dots
+        && (filename.front() == ' ' || filename.back() == ' ' || filename.back() == '.'))
+    {
+        return true;
+    }
+
+    return policy.rename_reserved_device_names && is_reserved_device_name(filename);
+}
+
+/*
+    =========================================================
+        sanitize_filename
+    =========================================================
+
+    Order of steps matters:
+    1. Replace bad characters (may not change length)
+    2. Trim spaces / dots
+    3. Escape reserved device names
+    4. Truncate, keeping the extension
+*/
+std::string sanitize_filename(const std::string& filename, const sanitize_policy& policy)
+{
+    if (!needs_sanitizing(filename, policy))
+    {
+        return filename;
+    }
+
+    std::string name = filename;
+
+    // STEP 1: replace control / reserved characters
+    unsigned char mask = character_mask(policy);
+    for (char& c : name)
+    {
+        if ((CHARACTER_CLASS[static_cast<unsigned char>(c)] & mask) != 0)
+        {
+            c = policy.replacement;
+        }
+    }
+
+    // STEP 2: trim leading spaces and trailing spaces / dots
+    if (policy.trim_spaces_and_dots)
+    {
+        std::string::size_type first = name.find_first_not_of(' ');
+        std::string::size_type last = name.find_last_not_of(" .");
+
+        if (first == std::string::npos || last == std::string::npos || last < first)
+        {
+            name.clear();
+        }
+        else
+        {
+            name = name.substr(first, last - first + 1);
+        }
+    }
+
+    // Split into stem and extension ("archive.tar" → "archive" + ".tar")
+    std::string::size_type dot = name.rfind('.');
+    std::string stem = (dot == std::string::npos || dot == 0) ? name : name.substr(0, dot);
+    std::string extension = (dot == std::string::npos || dot == 0) ? "" : name.substr(dot);
+
+    // STEP 3: "CON.txt" → "CON_.txt"
+    if (policy.rename_reserved_device_names && is_reserved_device_name(name))
+    {
+        std::string::size_type first_dot = stem.find('.');
+        stem.insert(first_dot == std::string::npos ? stem.size() : first_dot, 1, policy.replacement);
+    }
+
+    // STEP 4: enforce the byte limit, shortening the stem first
+    if (stem.size() + extension.size() > policy.max_name_bytes)
+    {
+        if (extension.size() < policy.max_name_bytes)
+        {
+            stem.resize(utf8_safe_length(stem, policy.max_name_bytes - extension.size()));
+        }
+        else
+        {
+            // Absurdly long extension: nothing sensible to keep
+            extension.clear();
+            stem.resize(utf8_safe_length(stem, policy.max_name_bytes));
+        }
+    }
+
+    name = stem + extension;
+
+    // Never produce an empty or special directory name
+    if (name.empty() || name == "." || name == "..")
+    {
+        name = std::string(1, policy.replacement);
+    }
+
+    return name;
+}
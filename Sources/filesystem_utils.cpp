@@ -1,9 +1,31 @@
 #include "filesystem_utils.hpp"
 #include "extensions.hpp"
+#include "resumable_copy.hpp"
 
 #include <algorithm>
 #include <filesystem>
 
+#if defined(__linux__)
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+// Attempts at a fresh unique name when one is taken between check and move
+static const int UNIQUE_NAME_ATTEMPTS = 16;
+
+const std::string PARTIAL_FOLDER_NAME = ".file_organizer-partial";
+
+bool is_partial_folder_name(const std::string& folder_name)
+{
+    return folder_name == PARTIAL_FOLDER_NAME;
+}
+
 /*
     =========================================================
         CATEGORY_ALIAS_MAP
@@ -365,33 +387,34 @@ void normalize_category_folder( const std::string& current_directory_level_path
         create_directory
     =========================================================
 
-    Safely creates a directory if it doesn't exist.
+    Safely creates a directory (and any missing parent) if it doesn't exist.
+
+    Several workers may create the same folder at once, e.g. a category
+    folder and one of its shards on two threads: a folder that appears
+    while we create it counts as already_exists, not as a failure.
 
     Does NOT throw.
     Returns explicit status instead.
 */
 create_directory_status create_directory ( const std::string& target_directory_path )
 {
-    if ( ! std::filesystem::exists(target_directory_path) )
+    std::error_code ec;
+    if (std::filesystem::create_directories(target_directory_path, ec))
     {
-        try
-        {
-            std::filesystem::create_directory(target_directory_path);
-            return create_directory_status::successful_creation;
-        }
-        catch (const std::filesystem::filesystem_error& e)
-        {
-            if (e.code() == std::errc::permission_denied)
-            {
-                return create_directory_status::permission_denied_failure;
-            }
-            else
-            {
-                return create_directory_status::unknown_failure;
-            }
-        }
+        return create_directory_status::successful_creation;
+    }
+
+    std::error_code exists_ec;
+    if (std::filesystem::is_directory(target_directory_path, exists_ec))
+    {
+        return create_directory_status::already_exists;
+    }
+
+    if (ec == std::errc::permission_denied)
+    {
+        return create_directory_status::permission_denied_failure;
     }
-    return create_directory_status::already_exists;
+    return create_directory_status::unknown_failure;
 }
 
 /*
@@ -439,28 +462,47 @@ std::filesystem::path get_unique_path(const std::filesystem::path& destination_d
 
 /*
     =========================================================
-        atomic_file_transfer
+        atomic_transfer_to_path
     =========================================================
 
-    Attempts to move a file using filesystem::rename.
-
-    Handles name collisions by appending:
-        filename(1).ext, filename(2).ext, ...
+    filesystem::rename to an exact, already collision-free path,
+    never over an existing file.
 */
-file_move_status atomic_file_transfer ( const std::string& source_path, const std::string& destination_dir_path )
+file_move_status atomic_transfer_to_path ( const std::filesystem::path& source_path, const std::filesystem::path& destination_path )
 {
-    try
+#if defined(__linux__) && defined(RENAME_NOREPLACE)
+    if (renameat2(AT_FDCWD, source_path.c_str(), AT_FDCWD, destination_path.c_str(), RENAME_NOREPLACE) == 0)
     {
-        std::filesystem::path old_source_path(source_path);
-
-        // making a path object of destination_dir_path
-        std::filesystem::path destination_dir(destination_dir_path);
+        return file_move_status::successful_transfer;
+    }
 
-        // Use our new helper to get a safe path
-        std::filesystem::path new_unique_destination = get_unique_path(destination_dir, old_source_path.filename().string());
+    switch (errno)
+    {
+    case EEXIST:
+        return file_move_status::destination_exists;
+    case EXDEV:
+        return file_move_status::cross_device_error;
+    case EACCES:
+    case EPERM:
+        return file_move_status::permission_denied;
+    case EINVAL:
+    case ENOSYS:
+        break;  // Filesystem without RENAME_NOREPLACE: checked rename below
+    default:
+        return file_move_status::unknown_failure;
+    }
+#endif
 
-        std::filesystem::rename(old_source_path, new_unique_destination);
+    // Small window between check and rename; only where the kernel cannot close it
+    std::error_code ec;
+    if (std::filesystem::exists(destination_path, ec))
+    {
+        return file_move_status::destination_exists;
+    }
 
+    try
+    {
+        std::filesystem::rename(source_path, destination_path);
         return file_move_status::successful_transfer;
     }
     catch (const std::filesystem::filesystem_error& e)
@@ -482,35 +524,26 @@ file_move_status atomic_file_transfer ( const std::string& source_path, const st
 
 /*
     =========================================================
-        fallback_transfer
+        fallback_transfer_to_path
     =========================================================
 
-    Used when atomic transfer is not possible.
+    Copy + delete to an exact, already collision-free path.
 
-    Strategy:
-    - Copy file
-    - Verify success
-    - Delete original
+    The copy goes through resumable_copy: it only appears under
+    destination_path once complete, and an interrupted copy of a
+    large file continues where it stopped on the next attempt.
 */
-file_move_status fallback_transfer ( const std::string& source_path, const std::string& destination_dir_path )
+file_move_status fallback_transfer_to_path ( const std::filesystem::path& source_path, const std::filesystem::path& destination_path )
 {
-    try
+    file_move_status copied = resumable_copy(source_path, destination_path);
+    if (copied != file_move_status::successful_transfer)
     {
-        std::filesystem::path old_source_path(source_path);
-
-        // making a path object of destination_dir_path
-        std::filesystem::path destination_dir(destination_dir_path);
-
-        // Use our new helper to get a safe path
-        std::filesystem::path new_unique_destination = get_unique_path(destination_dir, old_source_path.filename().string());
-
-        std::filesystem::copy_file(
-            old_source_path,
-            new_unique_destination,
-            std::filesystem::copy_options::overwrite_existing
-        );
+        return copied;
+    }
 
-        std::filesystem::remove(old_source_path);
+    try
+    {
+        std::filesystem::remove(source_path);
         return file_move_status::successful_transfer;
     }
     catch (const std::filesystem::filesystem_error& e)
@@ -525,3 +558,103 @@ file_move_status fallback_transfer ( const std::string& source_path, const std::
         }
     }
 }
+
+/*
+    =========================================================
+        write_all_bytes
+    =========================================================
+*/
+bool write_all_bytes(int fd, const char* data, std::size_t length)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    while (length > 0)
+    {
+        ssize_t n = write(fd, data, length);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        length -= static_cast<std::size_t>(n);
+    }
+    return true;
+#else
+    (void)fd;
+    return length == 0;
+#endif
+}
+
+/*
+    =========================================================
+        transfer_to_unique_path
+    =========================================================
+*/
+file_move_status transfer_to_unique_path ( const std::filesystem::path& source_path, const std::filesystem::path& destination_dir, const std::string& filename, const path_transfer& transfer, std::filesystem::path* final_destination )
+{
+    file_move_status result = file_move_status::destination_exists;
+    std::filesystem::path new_unique_destination;
+
+    // Another writer can take the free name before we get there
+    for (int attempt = 0; attempt < UNIQUE_NAME_ATTEMPTS && result == file_move_status::destination_exists; attempt++)
+    {
+        try
+        {
+            new_unique_destination = get_unique_path(destination_dir, filename);
+        }
+        catch (const std::filesystem::filesystem_error& e)
+        {
+            return (e.code() == std::errc::permission_denied) ? file_move_status::permission_denied
+                                                              : file_move_status::unknown_failure;
+        }
+
+        result = transfer(source_path, new_unique_destination);
+    }
+
+    if (result == file_move_status::successful_transfer && final_destination != nullptr)
+    {
+        *final_destination = new_unique_destination;
+    }
+    return result;
+}
+
+/*
+    =========================================================
+        atomic_file_transfer
+    =========================================================
+
+    Attempts to move a file using filesystem::rename.
+
+    Handles name collisions by appending:
+        filename(1).ext, filename(2).ext, ...
+*/
+file_move_status atomic_file_transfer ( const std::string& source_path, const std::string& destination_dir_path, std::filesystem::path* final_destination, const std::string& target_filename )
+{
+    // Keep the current name unless the caller picked a new one
+    std::string filename = target_filename.empty() ? std::filesystem::path(source_path).filename().string() : target_filename;
+
+    return transfer_to_unique_path(source_path, destination_dir_path, filename, atomic_transfer_to_path, final_destination);
+}
+
+/*
+    =========================================================
+        fallback_transfer
+    =========================================================
+
+    Used when atomic transfer is not possible.
+
+    Strategy:
+    - Copy file
+    - Verify success
+    - Delete original
+*/
+file_move_status fallback_transfer ( const std::string& source_path, const std::string& destination_dir_path, std::filesystem::path* final_destination, const std::string& target_filename )
+{
+    // Keep the current name unless the caller picked a new one
+    std::string filename = target_filename.empty() ? std::filesystem::path(source_path).filename().string() : target_filename;
+
+    return transfer_to_unique_path(source_path, destination_dir_path, filename, fallback_transfer_to_path, final_destination);
+}
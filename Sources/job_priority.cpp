@@ -0,0 +1,104 @@
+#include "job_priority.hpp"
+
+#include <algorithm>
+#include <thread>
+
+/*
+    =========================================================
+        priority_gate
+    =========================================================
+*/
+priority_gate::priority_gate(unsigned slots, unsigned reserved_interactive)
+    : slots(std::max(2u, slots))
+    , reserved_interactive(std::clamp(reserved_interactive, 1u, std::max(2u, slots) - 1))
+{
+}
+
+priority_gate& priority_gate::shared()
+{
+    static priority_gate gate(
+        std::max(2u, std::thread::hardware_concurrency()),
+        std::max(1u, std::thread::hardware_concurrency() / 4)
+        );
+    return gate;
+}
+
+bool priority_gate::can_start(job_priority priority) const
+{
+    unsigned running = running_interactive + running_bulk;
+
+    if (priority == job_priority::interactive)
+    {
+        return running < slots;
+    }
+
+    // Bulk: spare capacity only, and never ahead of waiting interactive work
+    return waiting_interactive == 0
+        && running < slots
+        && running_bulk < slots - reserved_interactive;
+}
+
+void priority_gate::acquire(job_priority priority)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (priority == job_priority::bulk)
+    {
+        slot_freed.wait(lock, [&]() { return can_start(priority); });
+        running_bulk++;
+        return;
+    }
+
+    waiting_interactive++;
+    slot_freed.wait(lock, [&]() { return can_start(priority); });
+    waiting_interactive--;
+    running_interactive++;
+
+    // Last interactive waiter gone: held-back bulk work may use spare slots
+    if (waiting_interactive == 0)
+    {
+        lock.unlock();
+        slot_freed.notify_all();
+    }
+}
+
+void priority_gate::release(job_priority priority)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (priority == job_priority::interactive)
+        {
+            running_interactive--;
+        }
+        else
+        {
+            running_bulk--;
+        }
+    }
+
+    slot_freed.notify_all();
+}
+
+/*
+    =========================================================
+        batch_slot
+    =========================================================
+*/
+batch_slot::batch_slot(job_priority priority)
+    : priority(priority)
+{
+    priority_gate::shared().acquire(priority);
+}
+
+batch_slot::~batch_slot()
+{
+    priority_gate::shared().release(priority);
+}
+
+void batch_slot::yield()
+{
+    priority_gate& gate = priority_gate::shared();
+    gate.release(priority);
+    gate.acquire(priority);
+}
@@ -0,0 +1,355 @@
+#include "layout_learner.hpp"
+#include "category_shards.hpp"
+#include "extensions.hpp"
+#include "filesystem_utils.hpp"
+#include "scan_batch.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+/*
+    Direct file counts of one scan:
+        relative folder → (extension → files directly inside)
+    The root itself is the empty string.
+*/
+using folder_histograms = std::map<std::string, std::unordered_map<std::string, std::size_t>>;
+
+/*
+    =========================================================
+        scan_frontier
+    =========================================================
+
+    Shared stack of folders still to read.
+
+    next() blocks while the stack is empty but other workers are
+    still reading (they may push subfolders); once nobody is busy and
+    nothing is pending, every worker gets false and exits.
+*/
+namespace
+{
+class scan_frontier
+{
+public:
+    explicit scan_frontier(std::string first_folder)
+    {
+        pending.push_back(std::move(first_folder));
+    }
+
+    bool next(std::string& folder)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [this]() { return !pending.empty() || busy == 0; });
+
+        if (pending.empty())
+        {
+            return false;
+        }
+
+        folder = std::move(pending.back());
+        pending.pop_back();
+        busy++;
+        return true;
+    }
+
+    void finish(std::vector<std::string>& subfolders)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (std::string& subfolder : subfolders)
+            {
+                pending.push_back(std::move(subfolder));
+            }
+            busy--;
+        }
+        subfolders.clear();
+        wake.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::string> pending;
+    unsigned busy = 0;
+};
+}
+
+/*
+    Category, alias and shard folders belong to the built-in rules;
+    a learned home must not be one of them or lie inside one
+    (normalize_category_folder may rename aliases under our feet).
+*/
+static bool is_user_folder(const std::string& relative_folder)
+{
+    std::size_t start = 0;
+
+    while (start <= relative_folder.size())
+    {
+        std::size_t end = relative_folder.find('/', start);
+        if (end == std::string::npos)
+        {
+            end = relative_folder.size();
+        }
+
+        std::string component = relative_folder.substr(start, end - start);
+
+        // Aliases are matched case-insensitively, like normalize_category_folder does
+        std::string lowercase_component = component;
+        std::transform(lowercase_component.begin(), lowercase_component.end(), lowercase_component.begin(), ::tolower);
+
+        if (CANONICAL_NAMES.find(component) != CANONICAL_NAMES.end()
+            || component == "Others"
+            || ALIAS_LOOKUP.find(lowercase_component) != ALIAS_LOOKUP.end()
+            || is_shard_folder_name(component))
+        {
+            return false;
+        }
+
+        start = end + 1;
+    }
+    return true;
+}
+
+static std::size_t folder_depth(const std::string& relative_folder)
+{
+    return std::count(relative_folder.begin(), relative_folder.end(), '/') + 1;
+}
+
+/*
+    =========================================================
+        learn_routing_rules
+    =========================================================
+*/
+learning_result learn_routing_rules(const std::string& root_path, const learning_policy& policy)
+{
+    learning_result result;
+
+    if (validate_path(root_path) != path_status::ok)
+    {
+        result.status = learning_status::path_not_found;
+        return result;
+    }
+
+    unsigned thread_count = policy.scan_threads == 0 ? 1 : policy.scan_threads;
+
+    /*
+        PHASE 1: parallel scan
+
+        Every worker counts into its own histograms;
+        they are merged once all folders have been read.
+    */
+    scan_frontier frontier("");
+    std::vector<folder_histograms> local_counts(thread_count);
+    std::vector<std::size_t> local_files(thread_count, 0);
+    std::vector<std::size_t> local_folders(thread_count, 0);
+    std::vector<char> local_incomplete(thread_count, 0);  // Not vector<bool>: written concurrently
+
+    auto worker = [&](unsigned worker_index)
+    {
+        folder_histograms& counts = local_counts[worker_index];
+        std::vector<std::string> subfolders;
+        std::string relative_folder;
+        scan_batch batch;
+
+        while (frontier.next(relative_folder))
+        {
+            directory_scanner scanner;
+            std::filesystem::path folder_path = relative_folder.empty()
+                ? std::filesystem::path(root_path)
+                : std::filesystem::path(root_path) / relative_folder;
+
+            if (scanner.open(folder_path.string()) != scan_status::ok)
+            {
+                local_incomplete[worker_index] = 1;
+                frontier.finish(subfolders);
+                continue;
+            }
+            local_folders[worker_index]++;
+
+            scan_status batch_state;
+            while ((batch_state = scanner.next_batch(batch)) == scan_status::ok)
+            {
+                for (std::size_t i = 0; i < batch.size(); i++)
+                {
+                    std::string_view name = batch.name(i);
+
+                    if (batch.types[i] == scan_entry_type::regular_file)
+                    {
+                        std::string extension = normalize_extension(std::string(name));
+                        if (!extension.empty())
+                        {
+                            counts[relative_folder][extension]++;
+                        }
+                        local_files[worker_index]++;
+                    }
+                    else if (batch.types[i] == scan_entry_type::directory
+                             && !name.empty() && name[0] != '.')
+                    {
+                        subfolders.push_back(relative_folder.empty()
+                            ? std::string(name)
+                            : relative_folder + "/" + std::string(name));
+                    }
+                }
+            }
+
+            if (batch_state == scan_status::failed)
+            {
+                local_incomplete[worker_index] = 1;
+            }
+
+            frontier.finish(subfolders);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back(worker, t);
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    /*
+        PHASE 2: roll-up
+
+        subtree_counts[extension][folder] = files of that extension
+        anywhere inside folder. The root level is left out: loose
+        files there are the strays the rules are for.
+    */
+    std::map<std::string, std::map<std::string, std::size_t>> subtree_counts;
+    std::unordered_map<std::string, std::size_t> placed_counts;
+
+    for (unsigned t = 0; t < thread_count; t++)
+    {
+        result.files_scanned += local_files[t];
+        result.folders_scanned += local_folders[t];
+        if (local_incomplete[t])
+        {
+            result.status = learning_status::incomplete;
+        }
+
+        for (const std::pair<const std::string, std::unordered_map<std::string, std::size_t>>& folder : local_counts[t])
+        {
+            if (folder.first.empty())
+            {
+                continue;
+            }
+
+            for (const std::pair<const std::string, std::size_t>& extension : folder.second)
+            {
+                placed_counts[extension.first] += extension.second;
+                std::map<std::string, std::size_t>& per_folder = subtree_counts[extension.first];
+
+                // Every ancestor: "a", "a/b", "a/b/c"
+                std::size_t slash = 0;
+                while ((slash = folder.first.find('/', slash)) != std::string::npos)
+                {
+                    per_folder[folder.first.substr(0, slash)] += extension.second;
+                    slash++;
+                }
+                per_folder[folder.first] += extension.second;
+            }
+        }
+    }
+
+    /*
+        PHASE 3: one rule per extension
+
+        The deepest qualifying folder wins, so "Work/Invoices" is
+        preferred over "Work" when both hold most of the PDFs.
+    */
+    for (const std::pair<const std::string, std::map<std::string, std::size_t>>& extension : subtree_counts)
+    {
+        std::size_t placed = placed_counts[extension.first];
+        const std::string* best_folder = nullptr;
+        std::size_t best_count = 0;
+
+        for (const std::pair<const std::string, std::size_t>& folder : extension.second)
+        {
+            if (folder.second < policy.min_files
+                || static_cast<double>(folder.second) < policy.min_share * static_cast<double>(placed)
+                || !is_user_folder(folder.first))
+            {
+                continue;
+            }
+
+            if (best_folder == nullptr
+                || folder_depth(folder.first) > folder_depth(*best_folder)
+                || (folder_depth(folder.first) == folder_depth(*best_folder) && folder.second > best_count))
+            {
+                best_folder = &folder.first;
+                best_count = folder.second;
+            }
+        }
+
+        if (best_folder != nullptr)
+        {
+            learned_rule rule;
+            rule.extension = extension.first;
+            rule.folder = *best_folder;
+            rule.files_in_folder = best_count;
+            rule.files_placed = placed;
+            result.rules.push_back(std::move(rule));
+        }
+    }
+
+    return result;
+}
+
+/*
+    =========================================================
+        learned_routing
+    =========================================================
+*/
+learned_routing::learned_routing(const std::string& root_path, const std::vector<learned_rule>& rules)
+    : root_path(root_path)
+{
+    destinations.reserve(rules.size());
+
+    for (const learned_rule& rule : rules)
+    {
+        // Built the same way the walk builds its paths
+        std::filesystem::path folder(rule.folder);
+        destinations[rule.extension] = (std::filesystem::path(root_path) / folder.make_preferred()).string();
+    }
+}
+
+const std::string& learned_routing::root() const
+{
+    return root_path;
+}
+
+std::size_t learned_routing::size() const
+{
+    return destinations.size();
+}
+
+const std::string* learned_routing::destination_for(const std::string& extension) const
+{
+    std::unordered_map<std::string, std::string>::const_iterator it = destinations.find(extension);
+    return it == destinations.end() ? nullptr : &it->second;
+}
+
+/*
+    =========================================================
+        is_within_folder
+    =========================================================
+*/
+bool is_within_folder(const std::string& directory_path, const std::string& folder_path)
+{
+    if (directory_path.size() < folder_path.size()
+        || directory_path.compare(0, folder_path.size(), folder_path) != 0)
+    {
+        return false;
+    }
+
+    return directory_path.size() == folder_path.size()
+        || directory_path[folder_path.size()] == std::filesystem::path::preferred_separator
+        || directory_path[folder_path.size()] == '/';
+}
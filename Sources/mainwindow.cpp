@@ -1,75 +1,1223 @@
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
 
+#include <QComboBox>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QGroupBox>
+#include <QLabel>
+#include <QListWidget>
+#include <QVBoxLayout>
+
+#include <algorithm>
+#include <thread>
+
+/*
+    Constructor of MainWindow.
+
+    Responsibilities here:
+    - Initialize base QMainWindow
+    - Allocate and setup UI
+    - Set window properties (icon, title)
+    - Connect background worker signals
+    - Apply default theme
+*/
+MainWindow::MainWindow(QWidget *parent)
+    : QMainWindow(parent)
+    , ui(new Ui::MainWindow)
+{
+    /*
+        Setup UI elements created in Qt Designer (.ui file).
+
+        This initializes:
+        - buttons
+        - labels
+        - input fields
+        - menus
+    */
+    ui->setupUi(this);
+
+    // Set application window icon from Qt resources
+    QIcon app_icon(":/resc/icon.ico");
+    this->setWindowIcon(app_icon);
+
+    // Set window title
+    this->setWindowTitle("File Organizer");
+
+    // Apply default (light) theme at startup
+    QString theme_path = ":/styles/light.qss";
+    apply_theme(theme_path);
+
+    /*
+        One content hash cache for every hashing feature. If another
+        instance already appends to it, this one only reads it.
+    */
+    content_hash_cache::shared().open(content_hash_cache::default_path());
+
+    /*
+        Connect the QFutureWatcher signal to our slot.
+
+        Meaning:
+        - When the background organizing task finishes
+        - Qt automatically calls on_organization_finished()
+
+        This is thread-safe and runs in the GUI thread.
+    */
+    connect(
+        &result_watcher,
+        &QFutureWatcher<organize_status>::finished,
+        this,
+        &MainWindow::on_organization_finished
+    );
+
+    connect(
+        &watch_watcher,
+        &QFutureWatcher<organize_status>::finished,
+        this,
+        &MainWindow::on_watch_finished
+    );
+
+    connect(
+        &thumbnail_watcher,
+        &QFutureWatcher<thumbnail_summary>::finished,
+        this,
+        &MainWindow::on_thumbnails_finished
+    );
+
+    connect(
+        &tiering_watcher,
+        &QFutureWatcher<tiering_summary>::finished,
+        this,
+        &MainWindow::on_tiering_finished
+    );
+
+    connect(
+        &learning_watcher,
+        &QFutureWatcher<learning_result>::finished,
+        this,
+        &MainWindow::on_learning_finished
+    );
+
+    connect(
+        &estimate_watcher,
+        &QFutureWatcher<run_estimate>::finished,
+        this,
+        &MainWindow::on_estimate_finished
+    );
+
+    connect(
+        &changes_watcher,
+        &QFutureWatcher<snapshot_status>::finished,
+        this,
+        &MainWindow::on_changes_finished
+    );
+
+    connect(
+        &simulation_watcher,
+        &QFutureWatcher<simulation_status>::finished,
+        this,
+        &MainWindow::on_simulation_finished
+    );
+
+    ui->progress_bar->setVisible(false);
+}
+
+/*
+    Destructor of MainWindow.
+
+    Cleans up UI resources to prevent memory leaks.
+*/
+MainWindow::~MainWindow()
+{
+    // The watch task reads watch_stop_requested: let it finish first
+    watch_stop_requested = true;
+    watch_watcher.waitForFinished();
+
+    thumbnail_stop_requested = true;
+    thumbnail_watcher.waitForFinished();
+
+    learning_watcher.waitForFinished();
+
+    estimate_watcher.waitForFinished();
+
+    changes_watcher.waitForFinished();
+
+    tiering_stop_requested = true;
+    tiering_watcher.waitForFinished();
+
+    simulation_watcher.waitForFinished();
+
+    delete ui;
+}
+
+/*
+    Slot triggered when the "Organize" button is clicked.
+*/
+void MainWindow::on_organize_button_clicked()
+{
+    current_job = organize_directory;
+    start_job();
+}
+
+/*
+    Triggered when user selects Apply Rule Changes from menu.
+*/
+void MainWindow::on_action_apply_rule_changes_triggered()
+{
+    current_job = reclassify_directory;
+    start_job();
+}
+
+/*
+    Triggered when user toggles Sanitize File Names in the menu.
+*/
+void MainWindow::on_action_sanitize_names_toggled(bool checked)
+{
+    current_options.sanitize.enabled = checked;
+}
+
+/*
+    Triggered when user toggles Record Performance Metrics in the menu.
+*/
+void MainWindow::on_action_record_metrics_toggled(bool checked)
+{
+    current_options.collect_metrics = checked;
+}
+
+/*
+    Triggered when user toggles Record Tree Snapshots in the menu.
+*/
+void MainWindow::on_action_record_snapshots_toggled(bool checked)
+{
+    current_options.record_snapshot = checked;
+}
+
+/*
+    Triggered when user toggles Explode Archives While Organizing in the menu.
+*/
+void MainWindow::on_action_explode_archives_toggled(bool checked)
+{
+    current_options.explode_archives = checked;
+}
+
+/*
+    Triggered when user toggles Shard Large Category Folders in the menu.
+*/
+void MainWindow::on_action_shard_folders_toggled(bool checked)
+{
+    current_options.shard.enabled = checked;
+}
+
+/*
+    Triggered when user toggles Group Moves by Destination in the menu.
+*/
+void MainWindow::on_action_group_by_destination_toggled(bool checked)
+{
+    current_options.order = checked ? execution_order::destination_order
+                                    : execution_order::scan_order;
+}
+
+/*
+    Triggered when user toggles Parallel Moves in the menu.
+*/
+void MainWindow::on_action_parallel_moves_toggled(bool checked)
+{
+    unsigned cores = std::thread::hardware_concurrency();
+    current_options.execution_threads = checked ? std::max(2u, cores) : 1;
+    current_options.deterministic_collisions = true;
+}
+
+/*
+    Triggered when user toggles Parallel Directory Reads in the menu.
+*/
+void MainWindow::on_action_parallel_directory_reads_toggled(bool checked)
+{
+    unsigned cores = std::thread::hardware_concurrency();
+    current_options.directory_read_threads = checked ? std::max(2u, cores) : 1;
+}
+
+/*
+    Triggered when user toggles Pre-generate Thumbnails in the menu.
+*/
+void MainWindow::on_action_generate_thumbnails_toggled(bool checked)
+{
+    current_thumbnails.enabled = checked;
+}
+
+/*
+    Triggered when user selects Learn Routing From Layout... from menu.
+*/
+void MainWindow::on_action_learn_layout_triggered()
+{
+    std::string root_path = ui->path_field->text().toStdString();
+
+    if (root_path.empty() || learning_watcher.isRunning())
+    {
+        return;
+    }
+
+    ui->action_learn_layout->setEnabled(false);
+    ui->result_field->setText("Learning folder layout...");
+
+    QFuture<learning_result> future_result =
+        QtConcurrent::run(learn_routing_rules, root_path, learning_policy());
+
+    learning_watcher.setFuture(future_result);
+}
+
+/*
+    Triggered when user selects Show Changes Since Last Run... from menu.
+*/
+void MainWindow::on_action_show_changes_triggered()
+{
+    std::string root_path = ui->path_field->text().toStdString();
+
+    if (root_path.empty() || changes_watcher.isRunning())
+    {
+        return;
+    }
+
+    std::shared_ptr<snapshot_diff_summary> summary = std::make_shared<snapshot_diff_summary>();
+    last_changes = summary;
+
+    ui->action_show_changes->setEnabled(false);
+    ui->result_field->setText("Comparing with the last run...");
+
+    std::string report_path = (get_state_directory(root_path) / "changes.ndjson").string();
+
+    QFuture<snapshot_status> future_result = QtConcurrent::run(
+        [summary, root_path, report_path]()
+        {
+            return diff_snapshot_against_tree(get_snapshot_path(root_path), root_path, report_path, *summary);
+        });
+
+    changes_watcher.setFuture(future_result);
+}
+
+/*
+    Slot executed when the diff against the last snapshot ends.
+*/
+void MainWindow::on_changes_finished()
+{
+    ui->action_show_changes->setEnabled(true);
+
+    switch (changes_watcher.result())
+    {
+    case snapshot_status::ok:
+        ui->result_field->setText(
+            QString("%1 added, %2 removed, %3 moved, %4 modified")
+                .arg(last_changes->added)
+                .arg(last_changes->removed)
+                .arg(last_changes->moved)
+                .arg(last_changes->modified)
+            );
+        QMessageBox::information(
+            this,
+            "Changes Since Last Run",
+            QString("Files at the last run: %1\n"
+                    "Files now: %2\n\n"
+                    "Added: %3\n"
+                    "Removed: %4\n"
+                    "Moved: %5\n"
+                    "Modified: %6\n\n"
+                    "Every change is listed in .file_organizer/changes.ndjson.")
+                .arg(last_changes->old_entries)
+                .arg(last_changes->new_entries)
+                .arg(last_changes->added)
+                .arg(last_changes->removed)
+                .arg(last_changes->moved)
+                .arg(last_changes->modified)
+            );
+        break;
+    case snapshot_status::snapshot_not_found:
+        QMessageBox::warning(this, "Error", "No snapshot yet. Enable Tools > Record Tree Snapshots and run once.");
+        ui->result_field->setText("Error! No snapshot of the last run.");
+        break;
+    case snapshot_status::snapshot_corrupt:
+        QMessageBox::warning(this, "Error", "The snapshot of the last run is damaged.");
+        ui->result_field->setText("Error! Invalid snapshot.");
+        break;
+    case snapshot_status::root_not_found:
+        QMessageBox::warning(this, "Error", "Invalid path.");
+        ui->result_field->setText("Error! Invalid path.");
+        break;
+    case snapshot_status::write_failed:
+        QMessageBox::warning(this, "Error", "The change list cannot be written.");
+        ui->result_field->setText("Error! Change list not written.");
+        break;
+    }
+}
+
+/*
+    Triggered when user selects Estimate Run... from menu.
+*/
+void MainWindow::on_action_estimate_run_triggered()
+{
+    std::string root_path = ui->path_field->text().toStdString();
+
+    if (root_path.empty() || estimate_watcher.isRunning())
+    {
+        return;
+    }
+
+    // Same stages as the next run would use
+    organize_options estimate_options = current_options;
+    estimate_options.learned = routes_for(root_path);
+
+    ui->action_estimate_run->setEnabled(false);
+    ui->result_field->setText("Estimating...");
+
+    QFuture<run_estimate> future_result =
+        QtConcurrent::run(estimate_run, root_path, estimate_options, estimate_policy());
+
+    estimate_watcher.setFuture(future_result);
+}
+
+/*
+    Slot executed when the run estimate is ready.
+*/
+void MainWindow::on_estimate_finished()
+{
+    ui->action_estimate_run->setEnabled(true);
+
+    run_estimate estimate = estimate_watcher.result();
+
+    switch (estimate.status)
+    {
+    case estimate_status::ok:
+        break;
+    case estimate_status::path_not_found:
+        QMessageBox::warning(this, "Error", "Invalid path! Please check the path.");
+        ui->result_field->setText("Error! Invalid path.");
+        return;
+    case estimate_status::permission_denied:
+        QMessageBox::warning(this, "Error", "Permission denied! Try running with appropriate privileges.");
+        ui->result_field->setText("Error! Permission denied.");
+        return;
+    }
+
+    auto count_range = [](const estimate_interval& interval)
+    {
+        return QString("%1 (%2 - %3)")
+            .arg(static_cast<qulonglong>(interval.value))
+            .arg(static_cast<qulonglong>(interval.low))
+            .arg(static_cast<qulonglong>(interval.high));
+    };
+
+    auto megabyte_range = [](const estimate_interval& interval)
+    {
+        constexpr double megabyte = 1024.0 * 1024.0;
+        return QString("%1 MB (%2 - %3 MB)")
+            .arg(interval.value / megabyte, 0, 'f', 0)
+            .arg(interval.low / megabyte, 0, 'f', 0)
+            .arg(interval.high / megabyte, 0, 'f', 0);
+    };
+
+    auto minute_range = [](const estimate_interval& interval)
+    {
+        return QString("%1 min (%2 - %3 min)")
+            .arg(interval.value / 60.0, 0, 'f', 1)
+            .arg(interval.low / 60.0, 0, 'f', 1)
+            .arg(interval.high / 60.0, 0, 'f', 1);
+    };
+
+    ui->result_field->setText(
+        QString("About %1 file(s) to move, %2")
+            .arg(static_cast<qulonglong>(estimate.files_to_move.value))
+            .arg(minute_range(estimate.seconds))
+        );
+
+    QMessageBox::information(
+        this,
+        "Run Estimate",
+        QString("%1\n\n"
+                "Files: %2\n"
+                "Files to move: %3\n"
+                "Data to move: %4\n"
+                "Copied across drives: %5\n"
+                "Expected duration: %6\n\n"
+                "Read %7 folder(s) with %8 entries in %9 s.")
+            .arg(estimate.exact ? QString("The whole folder was read: the numbers are exact.")
+                                : QString("Estimated from a random sample (95% intervals)."))
+            .arg(count_range(estimate.files))
+            .arg(count_range(estimate.files_to_move))
+            .arg(megabyte_range(estimate.bytes_to_move))
+            .arg(megabyte_range(estimate.cross_device_bytes))
+            .arg(minute_range(estimate.seconds))
+            .arg(estimate.directories_read)
+            .arg(estimate.entries_read)
+            .arg(estimate.sampling_seconds, 0, 'f', 2)
+        );
+}
+
+/*
+    Triggered when user selects Move Cold Files to Archive... from menu.
+*/
+void MainWindow::on_action_tier_cold_files_triggered()
+{
+    std::string root_path = ui->path_field->text().toStdString();
+
+    if (root_path.empty() || tiering_watcher.isRunning())
+    {
+        return;
+    }
+
+    QString cold_root = QFileDialog::getExistingDirectory(
+        this,
+        "Archive Folder (outside the organized folder)",
+        QString::fromStdString(current_tiering.cold_root),
+        QFileDialog::ShowDirsOnly
+        );
+
+    if (cold_root.isEmpty())
+    {
+        return;
+    }
+
+    bool accepted = false;
+    int age_days = QInputDialog::getInt(
+        this,
+        "Move Cold Files",
+        "Move files not opened for at least this many days:",
+        static_cast<int>(current_tiering.default_age_days),
+        1,
+        36500,
+        1,
+        &accepted
+        );
+
+    if (!accepted)
+    {
+        return;
+    }
+
+    QMessageBox::StandardButton leave_links = QMessageBox::question(
+        this,
+        "Move Cold Files",
+        "Leave a link behind at the old location of every moved file?"
+        );
+
+    current_tiering.cold_root = cold_root.toStdString();
+    current_tiering.default_age_days = static_cast<unsigned>(age_days);
+    current_tiering.leave_symlink = (leave_links == QMessageBox::Yes);
+
+    tiering_stop_requested = false;
+    ui->action_tier_cold_files->setEnabled(false);
+    ui->action_recall_cold_files->setEnabled(false);
+    ui->result_field->setText("Moving cold files...");
+
+    QFuture<tiering_summary> future_result =
+        QtConcurrent::run(tier_cold_files, root_path, current_tiering, &tiering_stop_requested);
+
+    tiering_watcher.setFuture(future_result);
+}
+
+/*
+    Triggered when user selects Recall Files from Archive... from menu.
+*/
+void MainWindow::on_action_recall_cold_files_triggered()
+{
+    std::string root_path = ui->path_field->text().toStdString();
+
+    if (root_path.empty() || tiering_watcher.isRunning())
+    {
+        return;
+    }
+
+    if (current_tiering.cold_root.empty())
+    {
+        QMessageBox::information(this, "Recall", "Move cold files to an archive first.");
+        return;
+    }
+
+    QString chosen = QFileDialog::getExistingDirectory(
+        this,
+        "Archive Folder to Recall",
+        QString::fromStdString(current_tiering.cold_root),
+        QFileDialog::ShowDirsOnly
+        );
+
+    if (chosen.isEmpty())
+    {
+        return;
+    }
+
+    std::filesystem::path relative =
+        std::filesystem::path(chosen.toStdString()).lexically_relative(current_tiering.cold_root);
+
+    if (relative.empty() || *relative.begin() == "..")
+    {
+        QMessageBox::warning(this, "Recall", "Please choose a folder inside the archive.");
+        return;
+    }
+
+    std::string relative_path = (relative == ".") ? std::string() : relative.generic_string();
+
+    ui->action_tier_cold_files->setEnabled(false);
+    ui->action_recall_cold_files->setEnabled(false);
+    ui->result_field->setText("Recalling files...");
+
+    QFuture<tiering_summary> future_result =
+        QtConcurrent::run(recall_cold_files, root_path, current_tiering, relative_path);
+
+    tiering_watcher.setFuture(future_result);
+}
+
+/*
+    Slot executed when a tiering or recall pass ends.
+*/
+void MainWindow::on_tiering_finished()
+{
+    ui->action_tier_cold_files->setEnabled(true);
+    ui->action_recall_cold_files->setEnabled(true);
+
+    tiering_summary summary = tiering_watcher.result();
+
+    switch (summary.status)
+    {
+    case tiering_status::success:
+    case tiering_status::partial:
+        ui->result_field->setText(
+            QString("%1 file(s) moved (%2 MB), %3 failed")
+                .arg(summary.files_moved)
+                .arg(summary.bytes_moved / (1024 * 1024))
+                .arg(summary.files_failed)
+            );
+        break;
+    case tiering_status::path_not_found:
+        QMessageBox::warning(this, "Error", "Invalid path! Please check the path.");
+        ui->result_field->setText("Error! Invalid path.");
+        break;
+    case tiering_status::cold_root_unavailable:
+        QMessageBox::warning(this, "Error", "The archive folder cannot be created.");
+        ui->result_field->setText("Error! Archive unavailable.");
+        break;
+    case tiering_status::cold_root_overlaps_tree:
+        QMessageBox::warning(this, "Error", "The archive folder must be outside the organized folder.");
+        ui->result_field->setText("Error! Archive inside the folder.");
+        break;
+    }
+}
+
+/*
+    Triggered when user selects Capture Tree Manifest... from menu.
+*/
+void MainWindow::on_action_capture_manifest_triggered()
+{
+    std::string root_path = ui->path_field->text().toStdString();
+
+    if (root_path.empty() || simulation_watcher.isRunning())
+    {
+        return;
+    }
+
+    QString manifest_path = QFileDialog::getSaveFileName(
+        this,
+        "Save Tree Manifest",
+        "manifest.txt",
+        "Manifest (*.txt)"
+        );
+
+    if (manifest_path.isEmpty())
+    {
+        return;
+    }
+
+    last_simulation = nullptr;
+    ui->action_capture_manifest->setEnabled(false);
+    ui->action_simulate_rules->setEnabled(false);
+    ui->result_field->setText("Capturing manifest...");
+
+    QFuture<simulation_status> future_result =
+        QtConcurrent::run(capture_tree_manifest, root_path, manifest_path.toStdString());
+
+    simulation_watcher.setFuture(future_result);
+}
+
+/*
+    Triggered when user selects Export Current Rules... from menu.
+*/
+void MainWindow::on_action_export_rules_triggered()
+{
+    QString rules_path = QFileDialog::getSaveFileName(
+        this,
+        "Export Current Rules",
+        "rules.tsv",
+        "Rules (*.tsv *.txt)"
+        );
+
+    if (rules_path.isEmpty())
+    {
+        return;
+    }
+
+    if (save_rule_file(rules_path.toStdString(), builtin_rule_table().extension_lookup) != simulation_status::ok)
+    {
+        QMessageBox::warning(this, "Error", "The rules file cannot be written.");
+        return;
+    }
+
+    ui->result_field->setText("Rules exported. Edit a copy and simulate it.");
+}
+
+/*
+    Triggered when user selects Simulate Rule Changes... from menu.
+*/
+void MainWindow::on_action_simulate_rules_triggered()
+{
+    if (simulation_watcher.isRunning())
+    {
+        return;
+    }
+
+    QString manifest_path = QFileDialog::getOpenFileName(this, "Tree Manifest", QString(), "Manifest (*.txt)");
+    if (manifest_path.isEmpty())
+    {
+        return;
+    }
+
+    QString rules_path = QFileDialog::getOpenFileName(this, "Candidate Rules", QString(), "Rules (*.tsv *.txt)");
+    if (rules_path.isEmpty())
+    {
+        return;
+    }
+
+    std::shared_ptr<simulation_report> report = std::make_shared<simulation_report>();
+    last_simulation = report;
+
+    ui->action_capture_manifest->setEnabled(false);
+    ui->action_simulate_rules->setEnabled(false);
+    ui->result_field->setText("Simulating rule changes...");
+
+    // Copy of the options: later menu changes do not affect the replay
+    organize_options simulated_options = current_options;
+    std::string manifest = manifest_path.toStdString();
+    std::string rules_file = rules_path.toStdString();
+
+    QFuture<simulation_status> future_result = QtConcurrent::run(
+        [report, simulated_options, manifest, rules_file]()
+        {
+            std::map<std::string, std::string> extension_lookup;
+            simulation_status status = load_rule_file(rules_file, extension_lookup);
+
+            if (status != simulation_status::ok)
+            {
+                return status;
+            }
+
+            status = simulate_rules(manifest, make_rule_table(extension_lookup), simulated_options, *report);
+
+            if (status != simulation_status::ok)
+            {
+                return status;
+            }
+
+            return write_simulation_report(*report, rules_file + ".diff.ndjson");
+        });
+
+    simulation_watcher.setFuture(future_result);
+}
+
+/*
+    Slot executed when a manifest capture or rule simulation ends.
+*/
+void MainWindow::on_simulation_finished()
+{
+    ui->action_capture_manifest->setEnabled(true);
+    ui->action_simulate_rules->setEnabled(true);
+
+    switch (simulation_watcher.result())
+    {
+    case simulation_status::ok:
+        if (!last_simulation)
+        {
+            ui->result_field->setText("Manifest captured.");
+            break;
+        }
+        ui->result_field->setText(
+            QString("%1 file(s) change destination, %2 new collision(s), %3 new folder(s)")
+                .arg(last_simulation->destination_changes)
+                .arg(last_simulation->new_collisions)
+                .arg(last_simulation->new_folders)
+            );
+        QMessageBox::information(
+            this,
+            "Rule Simulation",
+            QString("Files: %1\n"
+                    "Moves with current rules: %2\n"
+                    "Moves with candidate rules: %3\n"
+                    "Destination changes: %4 (%5 MB)\n"
+                    "New collisions: %6\n"
+                    "New folders: %7\n\n"
+                    "Every change is listed in the .diff.ndjson file next to the rules file.")
+                .arg(last_simulation->files)
+                .arg(last_simulation->moves_current)
+                .arg(last_simulation->moves_candidate)
+                .arg(last_simulation->destination_changes)
+                .arg(last_simulation->bytes_changing_place / (1024 * 1024))
+                .arg(last_simulation->new_collisions)
+                .arg(last_simulation->new_folders)
+            );
+        break;
+    case simulation_status::manifest_not_found:
+    case simulation_status::manifest_corrupt:
+        QMessageBox::warning(this, "Error", "The manifest cannot be read.");
+        ui->result_field->setText("Error! Invalid manifest.");
+        break;
+    case simulation_status::rules_not_found:
+    case simulation_status::rules_corrupt:
+        QMessageBox::warning(this, "Error", "The rules file cannot be read. Expected lines: extension<TAB>category");
+        ui->result_field->setText("Error! Invalid rules file.");
+        break;
+    case simulation_status::capture_failed:
+        QMessageBox::warning(this, "Error", "Invalid path, or the manifest cannot be written.");
+        ui->result_field->setText("Error! Capture failed.");
+        break;
+    case simulation_status::write_failed:
+        QMessageBox::warning(this, "Error", "The report cannot be written next to the rules file.");
+        ui->result_field->setText("Error! Report not written.");
+        break;
+    }
+}
+
 /*
-    Constructor of MainWindow.
+    Triggered when user toggles Ask on Name Collisions in the menu.
+*/
+void MainWindow::on_action_ask_on_collision_toggled(bool checked)
+{
+    current_options.on_collision = checked ? collision_policy::ask
+                                           : collision_policy::keep_both;
+}
 
-    Responsibilities here:
-    - Initialize base QMainWindow
-    - Allocate and setup UI
-    - Set window properties (icon, title)
-    - Connect background worker signals
-    - Apply default theme
+/*
+    Triggered when user toggles Run as Background Job in the menu.
 */
-MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent)
-    , ui(new Ui::MainWindow)
+void MainWindow::on_action_background_priority_toggled(bool checked)
 {
-    /*
-        Setup UI elements created in Qt Designer (.ui file).
+    current_options.priority = checked ? job_priority::bulk : job_priority::interactive;
+}
 
-        This initializes:
-        - buttons
-        - labels
-        - input fields
-        - menus
-    */
-    ui->setupUi(this);
+/*
+    Triggered when user selects Post-Move Hook... from menu.
+*/
+void MainWindow::on_action_move_hook_triggered()
+{
+    bool accepted = false;
+    QString command = QInputDialog::getText(
+        this,
+        "Post-Move Hook",
+        "Command run for each batch of moves (NDJSON on stdin).\nLeave empty to disable:",
+        QLineEdit::Normal,
+        QString::fromStdString(current_options.hook.command),
+        &accepted
+        );
 
-    // Set application window icon from Qt resources
-    QIcon app_icon(":/resc/icon.ico");
-    this->setWindowIcon(app_icon);
+    if (!accepted)
+    {
+        return;
+    }
 
-    // Set window title
-    this->setWindowTitle("File Organizer");
+    current_options.hook.target = hook_target::command;
+    current_options.hook.command = command.trimmed().toStdString();
+    current_options.hook.enabled = !current_options.hook.command.empty();
+}
 
-    // Apply default (light) theme at startup
-    QString theme_path = ":/styles/light.qss";
-    apply_theme(theme_path);
+/*
+    Triggered when user selects Heap Target... from menu.
+*/
+void MainWindow::on_action_heap_target_triggered()
+{
+    const std::size_t mebibyte = 1024 * 1024;
 
-    /*
-        Connect the QFutureWatcher signal to our slot.
+    bool accepted = false;
+    int target = QInputDialog::getInt(
+        this,
+        "Heap Target",
+        "Heap size the organizer's buffers adapt to, in MiB (0 = none).\n"
+        "Not a hard limit: the folder index and fixed costs come on top.",
+        static_cast<int>(current_options.heap_target / mebibyte),
+        0,
+        1024 * 1024,
+        64,
+        &accepted
+        );
 
-        Meaning:
-        - When the background organizing task finishes
-        - Qt automatically calls on_organization_finished()
+    if (!accepted)
+    {
+        return;
+    }
 
-        This is thread-safe and runs in the GUI thread.
-    */
-    connect(
-        &result_watcher,
-        &QFutureWatcher<organize_status>::finished,
-        this,
-        &MainWindow::on_organization_finished
-    );
+    current_options.heap_target = static_cast<std::size_t>(target) * mebibyte;
+}
 
-    ui->progress_bar->setVisible(false);
+/*
+    Triggered when user toggles Watch Folder in the menu.
+*/
+void MainWindow::on_action_watch_folder_toggled(bool checked)
+{
+    if (!checked)
+    {
+        // on_watch_finished() runs once the task notices the flag
+        watch_stop_requested = true;
+        return;
+    }
+
+    std::string root_path = ui->path_field->text().toStdString();
+
+    if (root_path.empty() || watch_watcher.isRunning())
+    {
+        ui->action_watch_folder->setChecked(false);
+        return;
+    }
+
+    watch_stop_requested = false;
+    ui->result_field->setText("Watching folder...");
+
+    // Nothing would ever drain the thumbnail collector in watch mode
+    organize_options watch_options = current_options;
+    watch_options.on_file_moved = nullptr;
+
+    // Nobody is there to answer parked decisions while watching
+    watch_options.deferred = nullptr;
+
+    watch_options.learned = routes_for(root_path);
+
+    // Catch-up passes must not slow down runs the user is waiting for
+    watch_options.priority = job_priority::bulk;
+
+    // Called on the watch thread: the warning is shown on the GUI thread
+    std::function<void(watch_coverage)> on_started = [this](watch_coverage coverage)
+    {
+        if (coverage != watch_coverage::root_only)
+        {
+            return;
+        }
+        QMetaObject::invokeMethod(this, [this]()
+        {
+            ui->result_field->setText("Watching folder (top level only)...");
+            QMessageBox::warning(
+                this,
+                "Watch Folder",
+                "Only files placed directly in the selected folder are watched.\n\n"
+                "Watching subfolders too needs the CAP_SYS_ADMIN capability\n"
+                "(for example: sudo setcap cap_sys_admin+ep <program>)."
+                );
+        }, Qt::QueuedConnection);
+    };
+
+    QFuture<organize_status> future_result =
+        QtConcurrent::run(
+            watch_directory,
+            root_path,
+            transfer_mode::atomic_transfer_mode,
+            watch_options,
+            &watch_stop_requested,
+            on_started
+            );
+
+    watch_watcher.setFuture(future_result);
 }
 
 /*
-    Destructor of MainWindow.
+    Slot executed automatically when the watch task ends.
+*/
+void MainWindow::on_watch_finished()
+{
+    organize_status result = watch_watcher.result();
 
-    Cleans up UI resources to prevent memory leaks.
+    ui->action_watch_folder->setChecked(false);
+
+    if (result == organize_status::success)
+    {
+        ui->result_field->setText("Stopped watching folder");
+    }
+    else if (result == organize_status::watch_unavailable)
+    {
+        QMessageBox::information(
+            this,
+            "Watch Folder",
+            "Folder watching is not available on this system.\n\n"
+            "It needs Linux with fanotify support."
+            );
+        ui->result_field->setText("Error! Watching unavailable.");
+    }
+    else
+    {
+        QMessageBox::information(
+            this,
+            "Watch Folder",
+            "Watching stopped because a file could not be organized."
+            );
+        ui->result_field->setText("Error! Watching stopped.");
+    }
+}
+
+/*
+    Starts the thumbnail pass in a background thread.
 */
-MainWindow::~MainWindow()
+void MainWindow::start_thumbnails()
 {
-    delete ui;
+    if (!current_thumbnails.enabled || !placed_images || thumbnail_watcher.isRunning())
+    {
+        return;
+    }
+
+    std::vector<std::filesystem::path> images = placed_images->take();
+    if (images.empty())
+    {
+        return;
+    }
+
+    thumbnail_stop_requested = false;
+
+    QFuture<thumbnail_summary> future_result =
+        QtConcurrent::run(
+            pregenerate_thumbnails,
+            images,
+            current_thumbnails,
+            &thumbnail_stop_requested
+            );
+
+    thumbnail_watcher.setFuture(future_result);
 }
 
 /*
-    Slot triggered when the "Organize" button is clicked.
+    Slot executed automatically when the thumbnail pass ends.
 */
-void MainWindow::on_organize_button_clicked()
+void MainWindow::on_thumbnails_finished()
+{
+    thumbnail_summary summary = thumbnail_watcher.result();
+
+    // Only report if no newer job has taken over the status field
+    if (!result_watcher.isRunning())
+    {
+        ui->result_field->setText(
+            QString("Files are organized successfully (%1 thumbnails created)")
+                .arg(summary.created)
+            );
+    }
+}
+
+/*
+    Learned routing: review and activation.
+*/
+void MainWindow::on_learning_finished()
+{
+    ui->action_learn_layout->setEnabled(true);
+
+    learning_result result = learning_watcher.result();
+    std::string root_path = ui->path_field->text().toStdString();
+
+    if (result.status == learning_status::path_not_found)
+    {
+        QMessageBox::warning(this, "Error", "Invalid path! Please check the path.");
+        ui->result_field->setText("Error! Invalid path.");
+        return;
+    }
+
+    if (result.rules.empty())
+    {
+        QMessageBox::information(
+            this,
+            "Learn Routing",
+            "No folder clearly collects one kind of file yet.\n"
+            "The built-in categories stay in use."
+            );
+        ui->result_field->setText("No routing rules learned");
+        return;
+    }
+
+    if (!choose_learned_rules(result.rules))
+    {
+        ui->result_field->setText("Learned routing discarded");
+        return;
+    }
+
+    // Running jobs keep their own copy; this one applies from the next run
+    learned_routes = result.rules.empty()
+        ? nullptr
+        : std::make_shared<const learned_routing>(root_path, result.rules);
+
+    ui->result_field->setText(
+        QString("%1 learned routing rule(s) active").arg(result.rules.size())
+        );
+}
+
+bool MainWindow::choose_learned_rules(std::vector<learned_rule>& rules)
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle("Learned Routing");
+    QVBoxLayout* layout = new QVBoxLayout(&dialog);
+
+    layout->addWidget(new QLabel(
+        "These folders already hold most files of one kind.\n"
+        "Checked rules send stray files of that kind there:"
+        ));
+
+    QListWidget* list = new QListWidget();
+    for (const learned_rule& rule : rules)
+    {
+        QListWidgetItem* item = new QListWidgetItem(
+            QString(".%1  →  %2   (%3 of %4 files)")
+                .arg(QString::fromStdString(rule.extension))
+                .arg(QString::fromStdString(rule.folder))
+                .arg(rule.files_in_folder)
+                .arg(rule.files_placed),
+            list
+            );
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Checked);
+    }
+    layout->addWidget(list);
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout->addWidget(buttons);
+
+    if (dialog.exec() != QDialog::Accepted)
+    {
+        return false;
+    }
+
+    std::vector<learned_rule> accepted;
+    for (int row = 0; row < list->count(); row++)
+    {
+        if (list->item(row)->checkState() == Qt::Checked)
+        {
+            accepted.push_back(rules[row]);
+        }
+    }
+    rules.swap(accepted);
+    return true;
+}
+
+std::shared_ptr<const learned_routing> MainWindow::routes_for(const std::string& root_path) const
+{
+    if (learned_routes && learned_routes->root() == root_path)
+    {
+        return learned_routes;
+    }
+    return nullptr;
+}
+
+/*
+    Grouped resolution of parked moves.
+*/
+void MainWindow::resolve_pending_decisions()
+{
+    std::vector<deferred_decision> decisions = pending_decisions->take_all();
+
+    if (decisions.empty() || !ask_for_decisions(decisions))
+    {
+        ui->result_field->setText("Files are organized, conflicting files were left in place");
+        return;
+    }
+
+    std::string root_path = ui->path_field->text().toStdString();
+
+    ui->progress_bar->setVisible(true);
+    ui->result_field->setText("Applying decisions...");
+
+    QFuture<organize_status> future_result =
+        QtConcurrent::run(apply_decisions, root_path, decisions, current_options);
+
+    result_watcher.setFuture(future_result);
+}
+
+/*
+    Builds the grouped dialog: one box per kind of conflict, each with
+    the affected files and a single choice applied to all of them.
+*/
+bool MainWindow::ask_for_decisions(std::vector<deferred_decision>& decisions)
+{
+    // Long lists are cut; the choice still applies to every item
+    const int MAX_LISTED_FILES = 200;
+
+    struct decision_group
+    {
+        decision_kind kind;
+        QString title;
+        QStringList choice_labels;
+        std::vector<decision_choice> choices;
+        QComboBox* selector = nullptr;
+    };
+
+    std::vector<decision_group> groups = {
+        { decision_kind::cross_device_move,
+          "%1 file(s) are on a different drive and cannot be moved atomically",
+          { "Copy + Delete", "Skip" },
+          { decision_choice::copy_and_delete, decision_choice::skip } },
+        { decision_kind::name_collision,
+          "%1 file(s) have the same name as a file already in the destination",
+          { "Keep both (numbered name)", "Skip" },
+          { decision_choice::keep_both, decision_choice::skip } }
+    };
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Files Need Your Decision");
+    QVBoxLayout* layout = new QVBoxLayout(&dialog);
+
+    for (decision_group& group : groups)
+    {
+        QListWidget* files = new QListWidget();
+        int count = 0;
+
+        for (const deferred_decision& decision : decisions)
+        {
+            if (decision.kind != group.kind)
+            {
+                continue;
+            }
+            if (count < MAX_LISTED_FILES)
+            {
+                files->addItem(QString::fromStdString(decision.move.source_path));
+            }
+            count++;
+        }
+
+        if (count == 0)
+        {
+            delete files;
+            continue;
+        }
+
+        QGroupBox* box = new QGroupBox(QString(group.title).arg(count));
+        QVBoxLayout* box_layout = new QVBoxLayout(box);
+
+        group.selector = new QComboBox();
+        group.selector->addItems(group.choice_labels);
+
+        box_layout->addWidget(files);
+        box_layout->addWidget(new QLabel("Apply to all of them:"));
+        box_layout->addWidget(group.selector);
+        layout->addWidget(box);
+    }
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout->addWidget(buttons);
+
+    if (dialog.exec() != QDialog::Accepted)
+    {
+        return false;
+    }
+
+    for (const decision_group& group : groups)
+    {
+        if (group.selector != nullptr)
+        {
+            decide_all(decisions, group.kind, group.choices[group.selector->currentIndex()]);
+        }
+    }
+    return true;
+}
+
+/*
+    Starts current_job in a background thread.
+*/
+void MainWindow::start_job()
 {
     // Default transfer mode is atomic (rename-based move)
     current_mode = transfer_mode::atomic_transfer_mode;
@@ -92,6 +1240,7 @@ void MainWindow::on_organize_button_clicked()
         - Avoid running multiple jobs at once
     */
     ui->organize_button->setEnabled(false);
+    ui->action_apply_rule_changes->setEnabled(false);
 
     ui->progress_bar->setVisible(true); // Show the bar
     ui->progress_bar->setRange(0, 0);
@@ -99,15 +1248,39 @@ void MainWindow::on_organize_button_clicked()
     // Show progress message
     ui->result_field->setText("Organizing...");
 
+    // Conflicts are parked here instead of stopping the run
+    pending_decisions = std::make_shared<decision_queue>();
+    current_options.deferred = pending_decisions.get();
+
+    current_options.learned = routes_for(root_path);
+
+    // Collect moved images for the thumbnail stage
+    if (current_thumbnails.enabled)
+    {
+        placed_images = std::make_shared<placed_image_collector>();
+        std::shared_ptr<placed_image_collector> collector = placed_images;
+
+        current_options.on_file_moved =
+            [collector](const std::filesystem::path&, const std::filesystem::path& destination)
+            {
+                collector->add(destination);
+            };
+    }
+    else
+    {
+        placed_images.reset();
+        current_options.on_file_moved = nullptr;
+    }
+
     /*
-        Run the organize_directory function in a background thread.
+        Run the organizer in a background thread.
 
         QtConcurrent::run():
         - Executes function asynchronously
         - Returns a QFuture object to track the result
     */
     QFuture<organize_status> future_result =
-        QtConcurrent::run(organize_directory, root_path, current_mode);
+        QtConcurrent::run(current_job, root_path, current_mode, current_options);
 
     // Attach the future to the watcher
     result_watcher.setFuture(future_result);
@@ -149,6 +1322,9 @@ void MainWindow::on_organization_finished()
         // Update status field
         ui->result_field->setText("Files are organized successfully");
 
+        // Runs while the dialog is open; never delays the organize itself
+        start_thumbnails();
+
         // Add custom "Open Folder" button
         QPushButton *openButton =
             msgBox.addButton("Open Folder", QMessageBox::ActionRole);
@@ -244,9 +1420,10 @@ void MainWindow::on_organization_finished()
             // Re-run organizer in fallback mode
             QFuture<organize_status> future_result =
                 QtConcurrent::run(
-                    organize_directory,
+                    current_job,
                     root_path,
-                    transfer_mode::fallback_transfer_mode
+                    transfer_mode::fallback_transfer_mode,
+                    current_options
                     );
 
             result_watcher.setFuture(future_result);
@@ -275,6 +1452,33 @@ void MainWindow::on_organization_finished()
         break;
     }
 
+    case organize_status::watch_unavailable:
+    {
+        QMessageBox::information(
+            this,
+            "Error",
+            "Folder watching is not available on this system."
+            );
+        ui->result_field->setText("Error! Watching unavailable.");
+        break;
+    }
+
+    case organize_status::decisions_pending:
+    {
+        /*
+            The run is complete except for parked moves.
+            Ask once, then execute the answers as a batch.
+        */
+        ui->progress_bar->setVisible(false);
+        resolve_pending_decisions();
+
+        if (result_watcher.isRunning())
+        {
+            return; // Batch is running, buttons stay disabled
+        }
+        break;
+    }
+
     case organize_status::unknown_error:
     {
         QMessageBox::information(
@@ -292,6 +1496,7 @@ void MainWindow::on_organization_finished()
         (success or failure).
     */
     ui->organize_button->setEnabled(true);
+    ui->action_apply_rule_changes->setEnabled(true);
 
     ui->progress_bar->setVisible(false);
 
@@ -0,0 +1,151 @@
+#include "memory_governor.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
+/*
+    Reading the statistics walks the allocator's arenas and free lists
+    (a few hundred microseconds on a fragmented heap), so a question
+    reuses the last reading if it is younger than this.
+*/
+static const std::int64_t REFRESH_INTERVAL_NS = 20 * 1000 * 1000;
+
+/*
+    Bytes in use according to the allocator, 0 if it cannot tell.
+*/
+static std::size_t read_allocator_statistics()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;     // Arena chunks in use + mmap'ed blocks
+#elif defined(__GLIBC__)
+    struct mallinfo info = mallinfo();      // int fields: wrong above 2 GiB, fine for small boxes
+    return static_cast<std::size_t>(static_cast<unsigned>(info.uordblks))
+         + static_cast<std::size_t>(static_cast<unsigned>(info.hblkhd));
+#elif defined(__APPLE__)
+    malloc_statistics_t statistics;
+    malloc_zone_statistics(nullptr, &statistics);
+    return statistics.size_in_use;
+#else
+    return 0;
+#endif
+}
+
+/*
+    =========================================================
+        memory_governor
+    =========================================================
+*/
+memory_governor& memory_governor::shared()
+{
+    static memory_governor governor;
+    return governor;
+}
+
+void memory_governor::hold_target(std::size_t bytes)
+{
+    if (bytes == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(holds_mutex);
+    held_targets[bytes]++;
+    target_bytes = held_targets.rbegin()->first;
+    last_refresh_ns = 0;    // Next question reads fresh statistics
+}
+
+void memory_governor::release_target(std::size_t bytes)
+{
+    if (bytes == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(holds_mutex);
+    std::map<std::size_t, unsigned>::iterator held = held_targets.find(bytes);
+    if (held == held_targets.end())
+    {
+        return;
+    }
+
+    if (--held->second == 0)
+    {
+        held_targets.erase(held);
+    }
+    target_bytes = held_targets.empty() ? 0 : held_targets.rbegin()->first;
+    last_refresh_ns = 0;
+}
+
+std::size_t memory_governor::target() const
+{
+    return target_bytes.load();
+}
+
+std::size_t memory_governor::allocated_bytes()
+{
+    std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    std::int64_t last = last_refresh_ns.load();
+
+    // One thread refreshes; the others keep using the previous reading
+    if (now - last >= REFRESH_INTERVAL_NS && last_refresh_ns.compare_exchange_strong(last, now))
+    {
+        last_allocated = read_allocator_statistics();
+    }
+    return last_allocated.load();
+}
+
+bool memory_governor::over_target()
+{
+    std::size_t target = target_bytes.load();
+    return target != 0 && allocated_bytes() >= target;
+}
+
+std::size_t memory_governor::scaled(std::size_t full_size, std::size_t minimum)
+{
+    std::size_t target = target_bytes.load();
+    if (target == 0 || full_size <= minimum)
+    {
+        return full_size;
+    }
+
+    std::size_t allocated = allocated_bytes();
+    std::size_t half = target / 2;
+
+    if (allocated <= half)
+    {
+        return full_size;
+    }
+    if (allocated >= target)
+    {
+        return minimum;
+    }
+
+    // Linear from full_size at half the target down to minimum at the target
+    double room = static_cast<double>(target - allocated) / static_cast<double>(target - half);
+    std::size_t size = minimum + static_cast<std::size_t>(room * static_cast<double>(full_size - minimum));
+    return std::clamp(size, minimum, full_size);
+}
+
+/*
+    =========================================================
+        heap_target_hold
+    =========================================================
+*/
+heap_target_hold::heap_target_hold(std::size_t bytes)
+    : bytes(bytes)
+{
+    memory_governor::shared().hold_target(bytes);
+}
+
+heap_target_hold::~heap_target_hold()
+{
+    memory_governor::shared().release_target(bytes);
+}
@@ -0,0 +1,513 @@
+#include "move_hook.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+/*
+    =========================================================
+        append_json_string
+    =========================================================
+
+    Minimal JSON string escaping. Paths are passed through byte for
+    byte; only quotes, backslashes and control characters need care.
+*/
+void append_json_string(std::string& out, const std::string& text)
+{
+    out += '"';
+    for (unsigned char c : text)
+    {
+        switch (c)
+        {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            if (c < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            }
+            else
+            {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    out += '"';
+}
+
+/*
+    =========================================================
+        moves_to_ndjson
+    =========================================================
+*/
+std::string moves_to_ndjson(const std::vector<completed_move>& moves)
+{
+    std::string out;
+    for (const completed_move& move : moves)
+    {
+        out += "{\"source\":";
+        append_json_string(out, move.source);
+        out += ",\"destination\":";
+        append_json_string(out, move.destination);
+        out += "}\n";
+    }
+    return out;
+}
+
+
+#if defined(__linux__)
+/*
+    End of a hook invocation's time budget. timeout_ms == 0 means
+    no budget: the deadline lies beyond any real wait.
+*/
+using hook_clock = std::chrono::steady_clock;
+
+static hook_clock::time_point hook_deadline(unsigned timeout_ms)
+{
+    if (timeout_ms == 0)
+    {
+        return hook_clock::time_point::max();
+    }
+    return hook_clock::now() + std::chrono::milliseconds(timeout_ms);
+}
+
+// Milliseconds left until deadline, as a poll() timeout (-1 = forever)
+static int poll_timeout(hook_clock::time_point deadline)
+{
+    if (deadline == hook_clock::time_point::max())
+    {
+        return -1;
+    }
+
+    std::chrono::milliseconds left = std::chrono::ceil<std::chrono::milliseconds>(deadline - hook_clock::now());
+    if (left.count() <= 0)
+    {
+        return 0;
+    }
+    return left.count() > 60000 ? 60000 : static_cast<int>(left.count());
+}
+
+/*
+    Waits until fd is ready for events, or the deadline passed.
+    Returns false on timeout (or a poll error).
+*/
+static bool wait_ready(int fd, short events, hook_clock::time_point deadline)
+{
+    for (;;)
+    {
+        pollfd entry{ fd, events, 0 };
+        int timeout = poll_timeout(deadline);
+        int ready = poll(&entry, 1, timeout);
+
+        if (ready > 0)
+        {
+            return true;
+        }
+        if (ready == -1 && errno != EINTR)
+        {
+            return false;
+        }
+        if (ready == 0 && timeout == 0)
+        {
+            return false;
+        }
+    }
+}
+
+/*
+    Writes the whole buffer to a non-blocking fd, retrying short
+    writes, until the deadline.
+    SIGPIPE is blocked in the sender threads, so a reader that went
+    away shows up as EPIPE here instead of killing the process.
+*/
+static hook_status write_all(int fd, const std::string& payload, bool is_socket, hook_clock::time_point deadline)
+{
+    std::size_t written = 0;
+    while (written < payload.size())
+    {
+        ssize_t n = is_socket
+            ? send(fd, payload.data() + written, payload.size() - written, MSG_NOSIGNAL)
+            : write(fd, payload.data() + written, payload.size() - written);
+
+        if (n == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                if (!wait_ready(fd, POLLOUT, deadline))
+                {
+                    return hook_status::timed_out;
+                }
+                continue;
+            }
+            return hook_status::write_failed;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+    return hook_status::ok;
+}
+
+/*
+    Reaps the child, waiting until the deadline at most. Polls with a
+    growing sleep (1 ms up to 50 ms): hooks are batched, so a few
+    milliseconds of latency per batch do not matter.
+*/
+static bool wait_for_child(pid_t child, int& wait_status, hook_clock::time_point deadline)
+{
+    std::chrono::milliseconds nap(1);
+    for (;;)
+    {
+        pid_t reaped = waitpid(child, &wait_status, WNOHANG);
+        if (reaped == child)
+        {
+            return true;
+        }
+        if (reaped == -1 && errno != EINTR)
+        {
+            wait_status = -1;
+            return true;
+        }
+        if (hook_clock::now() >= deadline)
+        {
+            return false;
+        }
+
+        std::this_thread::sleep_for(nap);
+        nap = std::min(nap * 2, std::chrono::milliseconds(50));
+    }
+}
+
+/*
+    =========================================================
+        invoke_command
+    =========================================================
+
+    posix_spawn instead of fork: no page tables are copied, which
+    matters when the organizer itself holds a large plan in memory.
+
+    The shell runs in a process group of its own, so on timeout the
+    whole group is killed, including whatever the command started.
+*/
+static hook_status invoke_command(const std::string& command, const std::string& payload, unsigned timeout_ms)
+{
+    hook_clock::time_point deadline = hook_deadline(timeout_ms);
+
+    int pipe_fds[2];
+    if (pipe2(pipe_fds, O_CLOEXEC) == -1)
+    {
+        return hook_status::spawn_failed;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, pipe_fds[0], STDIN_FILENO);
+
+    // The child starts with default signal handling and an empty mask
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t empty_mask;
+    sigset_t default_signals;
+    sigemptyset(&empty_mask);
+    sigemptyset(&default_signals);
+    sigaddset(&default_signals, SIGPIPE);
+    posix_spawnattr_setsigmask(&attributes, &empty_mask);
+    posix_spawnattr_setsigdefault(&attributes, &default_signals);
+    posix_spawnattr_setpgroup(&attributes, 0);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+
+    const char* argv[] = { "/bin/sh", "-c", command.c_str(), nullptr };
+
+    pid_t child = -1;
+    int spawn_result = posix_spawn(&child, "/bin/sh", &actions, &attributes,
+                                   const_cast<char* const*>(argv), environ);
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+    close(pipe_fds[0]);
+
+    if (spawn_result != 0)
+    {
+        close(pipe_fds[1]);
+        return hook_status::spawn_failed;
+    }
+
+    // Non-blocking: a command that never reads stdin must not hang us
+    fcntl(pipe_fds[1], F_SETFL, fcntl(pipe_fds[1], F_GETFL) | O_NONBLOCK);
+    hook_status delivered = write_all(pipe_fds[1], payload, false, deadline);
+    close(pipe_fds[1]);
+
+    int wait_status = 0;
+    if (delivered == hook_status::timed_out || !wait_for_child(child, wait_status, deadline))
+    {
+        kill(-child, SIGKILL);
+        while (waitpid(child, &wait_status, 0) == -1 && errno == EINTR)
+        {
+        }
+        return hook_status::timed_out;
+    }
+
+    if (wait_status == -1 || !WIFEXITED(wait_status) || WEXITSTATUS(wait_status) != 0)
+    {
+        return hook_status::command_failed;
+    }
+    return delivered;
+}
+
+/*
+    =========================================================
+        invoke_socket
+    =========================================================
+*/
+static hook_status invoke_socket(const std::string& socket_path, const std::string& payload, unsigned timeout_ms)
+{
+    hook_clock::time_point deadline = hook_deadline(timeout_ms);
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path))
+    {
+        return hook_status::connect_failed;
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+    {
+        return hook_status::connect_failed;
+    }
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1)
+    {
+        close(fd);
+        return hook_status::connect_failed;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    hook_status delivered = write_all(fd, payload, true, deadline);
+    if (delivered != hook_status::ok)
+    {
+        close(fd);
+        return delivered;
+    }
+
+    // End of batch; the endpoint closes its side once it is done
+    shutdown(fd, SHUT_WR);
+
+    char discard[256];
+    ssize_t n;
+    while ((n = read(fd, discard, sizeof(discard))) != 0)
+    {
+        if (n != -1 || errno == EINTR)
+        {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            break;
+        }
+        if (!wait_ready(fd, POLLIN, deadline))
+        {
+            close(fd);
+            return hook_status::timed_out;
+        }
+    }
+
+    close(fd);
+    return hook_status::ok;
+}
+
+hook_status invoke_hook(const hook_policy& policy, const std::string& payload)
+{
+    if (policy.target == hook_target::unix_socket)
+    {
+        return invoke_socket(policy.socket_path, payload, policy.timeout_ms);
+    }
+    return invoke_command(policy.command, payload, policy.timeout_ms);
+}
+
+#else
+
+hook_status invoke_hook(const hook_policy& policy, const std::string& payload)
+{
+    (void)policy;
+    (void)payload;
+    return hook_status::unsupported;
+}
+
+#endif
+
+
+/*
+    =========================================================
+        move_hook
+    =========================================================
+*/
+move_hook::move_hook(const hook_policy& policy, run_metrics* metrics)
+    : policy(policy)
+    , metrics(metrics)
+    , batches(policy.max_concurrent == 0 ? 1 : policy.max_concurrent)
+{
+    if (this->policy.batch_files == 0)
+    {
+        this->policy.batch_files = 1;
+    }
+    if (this->policy.max_concurrent == 0)
+    {
+        this->policy.max_concurrent = 1;
+    }
+
+    timer = std::thread(&move_hook::timer_loop, this);
+    for (unsigned i = 0; i < this->policy.max_concurrent; i++)
+    {
+        senders.emplace_back(&move_hook::sender_loop, this);
+    }
+}
+
+move_hook::~move_hook()
+{
+    finish();
+}
+
+std::vector<completed_move> move_hook::take_pending()
+{
+    std::vector<completed_move> batch;
+    batch.swap(pending);
+    return batch;
+}
+
+/*
+    Blocks while every sender is busy (backpressure). Called without
+    the mutex, so other workers keep collecting moves meanwhile and
+    the timer keeps running.
+*/
+void move_hook::send(std::vector<completed_move>& batch)
+{
+    if (!batch.empty())
+    {
+        batches.push(std::move(batch));
+    }
+}
+
+void move_hook::record(const std::filesystem::path& source, const std::filesystem::path& destination)
+{
+    std::vector<completed_move> full_batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (pending.empty())
+        {
+            batch_started = std::chrono::steady_clock::now();
+            wake_timer.notify_one();
+        }
+
+        pending.push_back(completed_move{ source.string(), destination.string() });
+
+        if (pending.size() >= policy.batch_files)
+        {
+            full_batch = take_pending();
+        }
+    }
+    send(full_batch);
+}
+
+/*
+    Sends a batch that has been waiting for batch_interval_ms,
+    so slow trickles of moves (e.g. watch mode) are still reported.
+*/
+void move_hook::timer_loop()
+{
+    std::chrono::milliseconds interval(policy.batch_interval_ms);
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (!stopping)
+    {
+        if (pending.empty())
+        {
+            wake_timer.wait(lock, [this] { return stopping || !pending.empty(); });
+            continue;
+        }
+
+        std::chrono::steady_clock::time_point deadline = batch_started + interval;
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            std::vector<completed_move> batch = take_pending();
+            lock.unlock();
+            send(batch);
+            lock.lock();
+            continue;
+        }
+
+        wake_timer.wait_until(lock, deadline);
+    }
+}
+
+void move_hook::sender_loop()
+{
+#if defined(__linux__)
+    // Only this thread: a hook that exits early must not kill us
+    sigset_t pipe_signal;
+    sigemptyset(&pipe_signal);
+    sigaddset(&pipe_signal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe_signal, nullptr);
+#endif
+
+    std::vector<completed_move> batch;
+    while (batches.pop(batch))
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        hook_status status = invoke_hook(policy, moves_to_ndjson(batch));
+        std::chrono::steady_clock::duration latency = std::chrono::steady_clock::now() - start;
+
+        if (metrics != nullptr)
+        {
+            metrics->record_hook_call(std::chrono::duration_cast<std::chrono::nanoseconds>(latency),
+                                      batch.size(), status == hook_status::ok);
+        }
+    }
+}
+
+void move_hook::finish()
+{
+    std::vector<completed_move> last_batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (finished)
+        {
+            return;
+        }
+        finished = true;
+        stopping = true;
+        last_batch = take_pending();
+        wake_timer.notify_one();
+    }
+
+    timer.join();
+    send(last_batch);
+    batches.close();
+    for (std::thread& sender : senders)
+    {
+        sender.join();
+    }
+}
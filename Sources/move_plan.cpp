@@ -0,0 +1,374 @@
+#include "move_plan.hpp"
+#include "memory_governor.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <queue>
+
+/*
+    =========================================================
+        Ordering
+    =========================================================
+*/
+static bool move_order(const planned_move& a, const planned_move& b)
+{
+    if (a.destination_directory != b.destination_directory)
+    {
+        return a.destination_directory < b.destination_directory;
+    }
+    if (a.target_filename != b.target_filename)
+    {
+        return a.target_filename < b.target_filename;
+    }
+    return a.source_path < b.source_path;
+}
+
+/*
+    Rough heap footprint of one planned move,
+    used to decide when to spill.
+*/
+static std::size_t estimated_size(const planned_move& move)
+{
+    return sizeof(planned_move)
+         + move.destination_directory.capacity()
+         + move.target_filename.capacity()
+         + move.source_path.capacity();
+}
+
+// Below this, spilling early saves too little to be worth another run file
+static const std::size_t MIN_PRESSURE_SPILL_BYTES = 1024 * 1024;
+
+/*
+    =========================================================
+        Run file format
+    =========================================================
+
+    A run is a sequence of records:
+
+        u32 length, destination_directory bytes
+        u32 length, target_filename bytes
+        u32 length, source_path bytes
+
+    in host byte order; runs never leave the machine that wrote them.
+*/
+static void write_field(std::ofstream& out, const std::string& field)
+{
+    std::uint32_t length = static_cast<std::uint32_t>(field.size());
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(field.data(), static_cast<std::streamsize>(field.size()));
+}
+
+static bool read_field(std::ifstream& in, std::string& field)
+{
+    std::uint32_t length = 0;
+    if (!in.read(reinterpret_cast<char*>(&length), sizeof(length)))
+    {
+        return false;
+    }
+    field.resize(length);
+    return static_cast<bool>(in.read(field.data(), static_cast<std::streamsize>(length)));
+}
+
+static bool read_move(std::ifstream& in, planned_move& move)
+{
+    return read_field(in, move.destination_directory)
+        && read_field(in, move.target_filename)
+        && read_field(in, move.source_path);
+}
+
+/*
+    =========================================================
+        move_plan
+    =========================================================
+*/
+move_plan::move_plan(const std::filesystem::path& spill_directory, std::size_t memory_budget_bytes)
+    : spill_directory(spill_directory)
+    , memory_budget_bytes(memory_budget_bytes)
+{
+}
+
+move_plan::~move_plan()
+{
+    remove_runs();
+}
+
+std::size_t move_plan::spilled_runs() const
+{
+    return run_files.size();
+}
+
+void move_plan::remove_runs()
+{
+    std::error_code ec;
+    for (const std::filesystem::path& run : run_files)
+    {
+        std::filesystem::remove(run, ec);
+    }
+    run_files.clear();
+}
+
+plan_status move_plan::add(planned_move move)
+{
+    pending_bytes += estimated_size(move);
+    pending.push_back(std::move(move));
+
+    if (pending_bytes > memory_budget_bytes
+        || (pending_bytes >= MIN_PRESSURE_SPILL_BYTES && memory_governor::shared().over_target()))
+    {
+        return spill();
+    }
+    return plan_status::ok;
+}
+
+/*
+    Sorts the in-memory part and writes it as one run.
+*/
+plan_status move_plan::spill()
+{
+    std::sort(pending.begin(), pending.end(), move_order);
+
+    std::error_code ec;
+    std::filesystem::create_directories(spill_directory, ec);
+    if (ec)
+    {
+        return plan_status::spill_failed;
+    }
+
+    std::filesystem::path run_path = spill_directory / ("plan-run-" + std::to_string(run_files.size()));
+    std::ofstream out(run_path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        return plan_status::spill_failed;
+    }
+    run_files.push_back(run_path);
+
+    for (const planned_move& move : pending)
+    {
+        write_field(out, move.destination_directory);
+        write_field(out, move.target_filename);
+        write_field(out, move.source_path);
+    }
+
+    out.flush();
+    if (!out)
+    {
+        return plan_status::spill_failed;
+    }
+
+    pending.clear();
+    pending.shrink_to_fit();
+    pending_bytes = 0;
+
+    return plan_status::ok;
+}
+
+/*
+    =========================================================
+        move_plan::drain
+    =========================================================
+
+    Without runs: sort in memory and stream.
+    With runs:    spill the rest too, then k-way merge the runs
+                  with a min-heap holding one record per run.
+*/
+plan_status move_plan::drain(const std::function<bool(const planned_move&)>& consumer)
+{
+    if (run_files.empty())
+    {
+        std::sort(pending.begin(), pending.end(), move_order);
+
+        for (const planned_move& move : pending)
+        {
+            if (!consumer(move))
+            {
+                pending.clear();
+                pending_bytes = 0;
+                return plan_status::stopped;
+            }
+        }
+
+        pending.clear();
+        pending_bytes = 0;
+        return plan_status::ok;
+    }
+
+    if (!pending.empty() && spill() != plan_status::ok)
+    {
+        remove_runs();
+        return plan_status::spill_failed;
+    }
+
+    std::vector<std::ifstream> readers;
+    std::vector<planned_move> heads(run_files.size());
+
+    readers.reserve(run_files.size());
+    for (const std::filesystem::path& run : run_files)
+    {
+        readers.emplace_back(run, std::ios::binary);
+        if (!readers.back().is_open())
+        {
+            remove_runs();
+            return plan_status::spill_failed;
+        }
+    }
+
+    // Min-heap of run indices, ordered by each run's current head
+    std::function<bool(std::size_t, std::size_t)> heap_order =
+        [&heads](std::size_t a, std::size_t b) { return move_order(heads[b], heads[a]); };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(heap_order)> heap(heap_order);
+
+    for (std::size_t i = 0; i < readers.size(); i++)
+    {
+        if (read_move(readers[i], heads[i]))
+        {
+            heap.push(i);
+        }
+    }
+
+    plan_status result = plan_status::ok;
+
+    while (!heap.empty())
+    {
+        std::size_t run = heap.top();
+        heap.pop();
+
+        if (!consumer(heads[run]))
+        {
+            result = plan_status::stopped;
+            break;
+        }
+
+        if (read_move(readers[run], heads[run]))
+        {
+            heap.push(run);
+        }
+        else if (!readers[run].eof())
+        {
+            result = plan_status::spill_failed;
+            break;
+        }
+    }
+
+    readers.clear();
+    remove_runs();
+    return result;
+}
+
+/*
+    Shared by both registries: first free name of the
+    "stem(n)ext" sequence, reserved in taken_names.
+*/
+static std::string claim_free_name(std::unordered_set<std::string>& taken_names, const std::string& filename)
+{
+    if (taken_names.insert(filename).second)
+    {
+        return filename;
+    }
+
+    // Same split as get_unique_path: "document.pdf" → "document" + ".pdf"
+    std::filesystem::path temp_path(filename);
+    std::string stem = temp_path.stem().string();
+    std::string extension = temp_path.extension().string();
+
+    for (int counter = 1;; counter++)
+    {
+        std::string new_filename = stem + "(" + std::to_string(counter) + ")" + extension;
+        if (taken_names.insert(new_filename).second)
+        {
+            return new_filename;
+        }
+    }
+}
+
+static void list_directory_names(const std::filesystem::path& directory, std::unordered_set<std::string>& names)
+{
+    std::error_code ec;
+    for (std::filesystem::directory_iterator entry(directory, ec), end; !ec && entry != end; entry.increment(ec))
+    {
+        names.insert(entry->path().filename().string());
+    }
+}
+
+/*
+    =========================================================
+        destination_name_registry
+    =========================================================
+*/
+void destination_name_registry::open(const std::filesystem::path& directory)
+{
+    if (is_open && directory == current_directory)
+    {
+        return;
+    }
+
+    current_directory = directory;
+    is_open = true;
+
+    if (memory_governor::shared().over_target())
+    {
+        taken_names = std::unordered_set<std::string>();    // Frees the buckets, not just the names
+    }
+    else
+    {
+        taken_names.clear();
+    }
+
+    list_directory_names(directory, taken_names);
+}
+
+const std::filesystem::path& destination_name_registry::directory() const
+{
+    return current_directory;
+}
+
+std::string destination_name_registry::claim(const std::string& filename)
+{
+    return claim_free_name(taken_names, filename);
+}
+
+std::string destination_name_registry::claim(const std::filesystem::path& directory, const std::string& filename)
+{
+    open(directory);
+    return claim_free_name(taken_names, filename);
+}
+
+/*
+    =========================================================
+        shared_name_registry
+    =========================================================
+*/
+std::string shared_name_registry::claim(const std::filesystem::path& directory, const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::unordered_map<std::string, folder_names>::iterator it = taken_names.find(directory.string());
+    if (it == taken_names.end())
+    {
+        // About to list another folder: make room first when over the heap target
+        if (memory_governor::shared().over_target())
+        {
+            for (it = taken_names.begin(); it != taken_names.end(); )
+            {
+                it = (it->second.in_flight == 0) ? taken_names.erase(it) : std::next(it);
+            }
+        }
+
+        it = taken_names.emplace(directory.string(), folder_names()).first;
+        list_directory_names(directory, it->second.names);
+    }
+
+    it->second.in_flight++;
+    return claim_free_name(it->second.names, filename);
+}
+
+void shared_name_registry::release(const std::filesystem::path& directory)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::unordered_map<std::string, folder_names>::iterator it = taken_names.find(directory.string());
+    if (it != taken_names.end() && it->second.in_flight > 0)
+    {
+        it->second.in_flight--;
+    }
+}
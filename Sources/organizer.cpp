@@ -1,8 +1,24 @@
 #include "organizer.hpp"
+#include "archive_explode.hpp"
 #include "filesystem_utils.hpp"
 #include "extensions.hpp"
+#include "directory_index.hpp"
+#include "fanotify_watcher.hpp"
+#include "memory_governor.hpp"
+#include "move_hook.hpp"
+#include "move_plan.hpp"
+#include "partitioned_scan.hpp"
+#include "resumable_copy.hpp"
+#include "scan_batch.hpp"
+#include "tree_snapshot.hpp"
+#include "work_queue.hpp"
 
+#include <algorithm>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 /*
@@ -50,45 +66,280 @@ organize_status process_path_validation (const std::string& root_path)
 
 /*
     =========================================================
-        handle_file
+        Metrics helpers
+    =========================================================
+
+    Thin wrappers so the hot paths stay readable
+    and cost a single branch when metrics are off.
+*/
+static void enter_phase(const organize_options& options, run_phase phase)
+{
+    if (options.metrics != nullptr)
+    {
+        options.metrics->enter_phase(phase);
+    }
+}
+
+// Once per batch: reading the counter group is a syscall
+static void sample_counters(const organize_options& options)
+{
+    if (options.metrics != nullptr)
+    {
+        options.metrics->sample_counters();
+    }
+}
+
+/*
+    Creates the run's metrics object (on the calling worker thread)
+    and points run_options at it.
+*/
+static std::unique_ptr<run_metrics> start_metrics(organize_options& run_options)
+{
+    std::unique_ptr<run_metrics> metrics;
+    if (run_options.collect_metrics)
+    {
+        metrics = std::make_unique<run_metrics>(true);
+        run_options.metrics = metrics.get();
+    }
+    return metrics;
+}
+
+/*
+    Holds the run's heap target on the process-wide governor until
+    the returned object goes away (end of the run). Concurrent runs
+    steer toward the largest target held.
+*/
+static std::unique_ptr<heap_target_hold> start_memory_governor(const organize_options& run_options)
+{
+    return std::make_unique<heap_target_hold>(run_options.heap_target);
+}
+
+/*
+    Creates the run's shard registry when sharding is enabled
+    and points run_options at it.
+*/
+static std::unique_ptr<shard_registry> start_sharding(organize_options& run_options)
+{
+    std::unique_ptr<shard_registry> shards;
+    if (run_options.shard.enabled)
+    {
+        shards = std::make_unique<shard_registry>(run_options.shard);
+        run_options.shards = shards.get();
+    }
+    return shards;
+}
+
+/*
+    Creates the run's hook dispatcher when a hook is configured
+    and points run_options at it. Call after start_metrics, so hook
+    latency ends up in the same metrics.
+*/
+static std::unique_ptr<move_hook> start_hooks(organize_options& run_options)
+{
+    std::unique_ptr<move_hook> hooks;
+    if (run_options.hook.enabled)
+    {
+        hooks = std::make_unique<move_hook>(run_options.hook, run_options.metrics);
+        run_options.hooks = hooks.get();
+    }
+    return hooks;
+}
+
+/*
+    Tells the hook stage and the on_file_moved observer
+    about one completed move.
+*/
+static void report_move(
+    const organize_options& options,
+    const std::filesystem::path& source,
+    const std::filesystem::path& destination
+    )
+{
+    if (options.hooks != nullptr)
+    {
+        options.hooks->record(source, destination);
+    }
+    if (options.on_file_moved)
+    {
+        options.on_file_moved(source, destination);
+    }
+}
+
+/*
+    Applies files moved by a shard split to the directory index.
+*/
+static void apply_shard_relocations(
+    directory_index& index,
+    const std::string& root_path,
+    const organize_options& run_options
+    )
+{
+    if (run_options.shards == nullptr)
+    {
+        return;
+    }
+
+    for (const std::pair<std::filesystem::path, std::filesystem::path>& moved : run_options.shards->take_relocations())
+    {
+        forget_file_location(index, root_path, moved.first);
+        record_file_location(index, root_path, moved.second);
+        report_move(run_options, moved.first, moved.second);
+    }
+}
+
+/*
+    Sends the last hook batch, closes the last phase and writes
+    metrics.json. A failed write never changes the outcome of the run.
+*/
+static void finish_run(const std::string& root_path, const organize_options& run_options)
+{
+    if (run_options.hooks != nullptr)
+    {
+        run_options.hooks->finish();
+    }
+
+    if (run_options.metrics != nullptr)
+    {
+        run_options.metrics->enter_phase(run_phase::none);
+        write_metrics_file(root_path, *run_options.metrics);
+    }
+}
+
+/*
+    Result of a run that got to the end: success, unless moves
+    were parked for the user along the way.
+*/
+static organize_status finished_result(const organize_options& run_options)
+{
+    if (run_options.deferred != nullptr && run_options.deferred->size() > 0)
+    {
+        return organize_status::decisions_pending;
+    }
+    return organize_status::success;
+}
+
+/*
+    =========================================================
+        plan_placement
     =========================================================
 
     Core decision-making unit of the project.
 
+    Split in two halves so moves can either run immediately
+    (scan order) or be collected and sorted first (destination order):
+
+    plan_placement → decides where the file SHOULD live
+    execute_move   → moves it there
+
     GIVEN:
     - current_directory_level_path → where we are scanning
-    - entry_path → full path of the file
-    - transfer_mode → how to move files
+    - current_filename → name of the file inside it
+    - options → optional stages (e.g. sanitize)
+    - rules → classification rules (builtin_rule_table() for real runs)
+
+    Pure string logic, EXCEPT the shard stage (options.shards): route()
+    reads each category folder once and creates shard folders, and a
+    folder that would overflow is split on the spot (its loose files
+    are moved into their shards) before the answer is given. The rule
+    simulator turns that stage off, so its replays never touch the disk.
+
+    The full source path is only built once a move is needed,
+    so files that already sit in the right place cost no allocation.
 
     GOAL:
     -----
     - Decide where the file SHOULD live
     - Avoid creating nested category folders
-    - Move file safely and predictably
+
+    Returns already_in_correct_location, or success with move filled in.
 */
-organize_status handle_file(
+organize_status plan_placement(
     const std::string& current_directory_level_path,
-    const std::string& entry_path,
-    transfer_mode t_mode
+    const std::string& current_filename,
+    const organize_options& options,
+    const rule_table& rules,
+    planned_move& move
     )
 {
-    // Determine category purely from file extension
-    std::string category_name = classify_file_by_extension(entry_path);
+    /*
+        SANITIZE STAGE
+
+        Decide the target name now; it is applied by the same rename
+        (or copy) that moves the file into its category folder.
+    */
+    std::string target_filename = sanitize_filename(current_filename, options.sanitize);
+    bool rename_needed = (target_filename != current_filename);
+
+    /*
+        Determine category purely from file extension.
+
+        The TARGET name is classified, so "photo.jpg " (trailing space)
+        lands in "Image Files" once the space is trimmed.
+    */
+    std::string category_name = classify_with_rules(rules, target_filename);
+
+    /*
+        LEARNED ROUTING
+
+        The user's own layout wins over the built-in categories.
+        Subfolders of the learned home are user structure too,
+        so files anywhere inside it stay where they are.
+    */
+    const std::string* learned_folder = nullptr;
+    if (options.learned != nullptr)
+    {
+        learned_folder = options.learned->destination_for(normalize_extension(target_filename));
+    }
+
+    if (learned_folder != nullptr)
+    {
+        bool inside_learned_folder = is_within_folder(current_directory_level_path, *learned_folder);
+
+        if (inside_learned_folder && !rename_needed)
+        {
+            return organize_status::already_in_correct_location;
+        }
+
+        move.destination_directory = inside_learned_folder ? current_directory_level_path : *learned_folder;
+        move.target_filename = target_filename;
+        move.source_path = (std::filesystem::path(current_directory_level_path) / current_filename).string();
+
+        return organize_status::success;
+    }
 
     // Name of the directory we are currently inside
     std::string parent_folder_name = get_parent_folder_name(current_directory_level_path);
 
     /*
-        If file is already inside its correct category folder,
-        do absolutely nothing.
+        Folder that plays the "category folder" role for this file.
 
-        This is what makes the program idempotent.
+        Normally the current directory. Inside a shard folder
+        ("Image Files/shard-3f") it is the category folder above it,
+        so sharded files are judged exactly like loose ones.
     */
-    if (category_name == parent_folder_name)
+    std::filesystem::path category_level_path = current_directory_level_path;
+
+    if (is_shard_folder_name(parent_folder_name))
     {
-        return organize_status::already_in_correct_location;
+        std::filesystem::path shard_parent = category_level_path.parent_path();
+        std::string shard_parent_name = shard_parent.filename().string();
+
+        if (rules.category_names.find(shard_parent_name) != rules.category_names.end()
+            || shard_parent_name == "Others")
+        {
+            category_level_path = shard_parent;
+            parent_folder_name = shard_parent_name;
+        }
     }
 
+    /*
+        If file is already inside its correct category folder,
+        do absolutely nothing (unless its name needs sanitizing).
+
+        This is what makes the program idempotent.
+    */
+    bool in_correct_location = (category_name == parent_folder_name);
+
     /*
         If file is already inside its correct category's alias folder,
         again do absolutely nothing.
@@ -107,6 +358,26 @@ organize_status handle_file(
 
     if ( ( ALIAS_LOOKUP.find(parent_folder_name) != ALIAS_LOOKUP.end() )
         && ( ALIAS_LOOKUP.at(parent_folder_name) == category_name ) )
+    {
+        in_correct_location = true;
+    }
+
+    /*
+        With sharding on, a file in its own category folder may still
+        belong in a different shard (or in a shard instead of loose).
+        Alias folders are user structure and are never sharded.
+    */
+    std::filesystem::path placement_directory = current_directory_level_path;
+
+    if (options.shards != nullptr && category_name == parent_folder_name)
+    {
+        placement_directory = options.shards->route(category_level_path, target_filename, true);
+    }
+
+    bool relocation_needed = (placement_directory != std::filesystem::path(current_directory_level_path));
+
+    // Right folder and clean name: nothing to do at all
+    if (in_correct_location && !rename_needed && !relocation_needed)
     {
         return organize_status::already_in_correct_location;
     }
@@ -122,20 +393,30 @@ organize_status handle_file(
         This prevents:
             Image Files/
                 PDF Files/ (nested category mess)
+
+        "Others" is the fallback category folder and follows the same rule,
+        so files of a newly supported extension leave it instead of nesting.
     */
     std::filesystem::path base_location;
+    std::filesystem::path destination_directory;
 
-    if ( (CANONICAL_NAMES.find(parent_folder_name) != CANONICAL_NAMES.end())
+    if (in_correct_location)
+    {
+        // Right folder, but bad name or wrong shard: move within the category
+        destination_directory = placement_directory;
+    }
+    else if ( (rules.category_names.find(parent_folder_name) != rules.category_names.end()
+          || parent_folder_name == "Others")
         && (category_name != parent_folder_name) )
     {
         // Move out of the wrong category folder
-        base_location = std::filesystem::path(current_directory_level_path).parent_path();
+        base_location = category_level_path.parent_path();
     }
     else if ( ( ALIAS_LOOKUP.find(parent_folder_name) != ALIAS_LOOKUP.end() )
         && ( ALIAS_LOOKUP.at(parent_folder_name) != category_name ) )
     {
         // Move out of the wrong category folder
-        base_location = std::filesystem::path(current_directory_level_path).parent_path();
+        base_location = category_level_path.parent_path();
     }
     else
     {
@@ -144,109 +425,673 @@ organize_status handle_file(
     }
 
     // Final destination directory for this file
-    std::filesystem::path destination_directory = base_location / category_name;
-    std::string destination_dir_path = destination_directory.string();
+    if (!in_correct_location)
+    {
+        destination_directory = base_location / category_name;
+
+        if (options.shards != nullptr)
+        {
+            destination_directory = options.shards->route(destination_directory, target_filename, false);
+        }
+    }
+    move.destination_directory = destination_directory.string();
+    move.target_filename = target_filename;
+    move.source_path = (std::filesystem::path(current_directory_level_path) / current_filename).string();
+
+    return organize_status::success;
+}
 
+/*
+    plan_placement with the built-in rules, as used by every real run.
+*/
+static organize_status plan_file(
+    const std::string& current_directory_level_path,
+    const std::string& current_filename,
+    const organize_options& options,
+    planned_move& move
+    )
+{
+    enter_phase(options, run_phase::classify);
+    return plan_placement(current_directory_level_path, current_filename, options, builtin_rule_table(), move);
+}
+
+
+/*
+    =========================================================
+        execute_move
+    =========================================================
+
+    Performs one planned move.
+
+    registry:
+        null → collisions are resolved with get_unique_path (stat calls)
+        set  → collisions are resolved in memory by the registry
+               (destination order, possibly shared between workers)
+
+    In fallback mode a plain rename is still tried first; copy + delete
+    is only used for files that really are on another device.
+
+    With a decision queue in options, conflicts that need the user
+    are parked there and decisions_pending is returned for the file.
+*/
+static organize_status execute_move(
+    const planned_move& move,
+    transfer_mode t_mode,
+    name_registry* registry,
+    const organize_options& options,
+    std::filesystem::path* final_path
+    )
+{
     // Ensure category directory exists
-    create_directory_status creation_result = create_directory(destination_dir_path);
+    create_directory_status creation_result = create_directory(move.destination_directory);
+
+    if (creation_result == create_directory_status::permission_denied_failure)
+    {
+        return organize_status::permission_denied;
+    }
+    else if (creation_result == create_directory_status::unknown_failure)
+    {
+        return organize_status::directory_creation_failed;
+    }
 
     /*
         =====================================================
             FILE TRANSFER
         =====================================================
     */
-    if (t_mode == transfer_mode::atomic_transfer_mode)
+    std::filesystem::path destination_path;
+    file_move_status transfer_result;
+
+    std::filesystem::path desired_path = std::filesystem::path(move.destination_directory) / move.target_filename;
+    bool ask_on_collision = (options.deferred != nullptr && options.on_collision == collision_policy::ask);
+
+    if (registry != nullptr)
+    {
+        destination_path = std::filesystem::path(move.destination_directory)
+                         / registry->claim(move.destination_directory, move.target_filename);
+    }
+
+    // The claimed name is in flight until this move is over, whatever its outcome
+    struct claim_release
     {
-        file_move_status atomic_transfer_result =
-            atomic_file_transfer(entry_path, destination_dir_path);
+        name_registry* registry;
+        const std::string& directory;
 
-        if ((creation_result == create_directory_status::successful_creation ||
-             creation_result == create_directory_status::already_exists)
-            && atomic_transfer_result == file_move_status::successful_transfer)
-        {
-            return organize_status::success;
-        }
-        else if (creation_result == create_directory_status::permission_denied_failure ||
-                 atomic_transfer_result == file_move_status::permission_denied)
+        ~claim_release()
         {
-            return organize_status::permission_denied;
+            if (registry != nullptr)
+            {
+                registry->release(directory);
+            }
         }
-        else if (atomic_transfer_result == file_move_status::cross_device_error)
+    } release_claim{registry, move.destination_directory};
+
+    auto park_collision = [&]()
+    {
+        deferred_decision decision;
+        decision.kind = decision_kind::name_collision;
+        decision.move = move;
+        decision.conflicting_path = desired_path.string();
+        options.deferred->park(std::move(decision));
+        return organize_status::decisions_pending;
+    };
+
+    // Taken name: the registry handed out another one, or the file exists
+    if (ask_on_collision
+        && (registry != nullptr ? destination_path != desired_path : std::filesystem::exists(desired_path)))
+    {
+        return park_collision();
+    }
+
+    /*
+        The registry lists each folder once, so its view goes stale when
+        another run (watch mode, a second Organize) writes there. The
+        *_to_path transfers never replace a file; they report it, and
+        the move takes the registry's next name instead.
+    */
+    auto claim_next_name = [&]()
+    {
+        destination_path = std::filesystem::path(move.destination_directory)
+                         / registry->claim(move.destination_directory, move.target_filename);
+
+        // Still one claim in flight for this move (released by release_claim)
+        registry->release(move.destination_directory);
+    };
+
+    if (registry != nullptr)
+    {
+        transfer_result = atomic_transfer_to_path(move.source_path, destination_path);
+
+        while (transfer_result == file_move_status::destination_exists)
         {
-            return organize_status::atomic_transfer_failed;
+            if (ask_on_collision)
+            {
+                return park_collision();
+            }
+            claim_next_name();
+            transfer_result = atomic_transfer_to_path(move.source_path, destination_path);
         }
-        else if (creation_result == create_directory_status::unknown_failure)
+    }
+    else
+    {
+        transfer_result = atomic_file_transfer(move.source_path, move.destination_directory,
+                                               &destination_path, move.target_filename);
+    }
+
+    if (t_mode == transfer_mode::atomic_transfer_mode)
+    {
+        if (transfer_result == file_move_status::cross_device_error && options.deferred != nullptr)
         {
-            return organize_status::directory_creation_failed;
+            // Park it; the user decides about copy + delete after the run
+            deferred_decision decision;
+            decision.kind = decision_kind::cross_device_move;
+            decision.move = move;
+            options.deferred->park(std::move(decision));
+            return organize_status::decisions_pending;
         }
-        else
+        if (transfer_result == file_move_status::cross_device_error)
         {
-            return organize_status::unknown_error;
+            return organize_status::atomic_transfer_failed;
         }
     }
-    else
+    else if (transfer_result == file_move_status::cross_device_error)
     {
         /*
             Fallback mode: copy + delete
             Used when atomic rename is not possible
         */
-        file_move_status fallback_transfer_result =
-            fallback_transfer(entry_path, destination_dir_path);
-
-        if ((creation_result == create_directory_status::successful_creation ||
-             creation_result == create_directory_status::already_exists)
-            && fallback_transfer_result == file_move_status::successful_transfer)
+        if (registry != nullptr)
         {
-            return organize_status::success;
+            transfer_result = fallback_transfer_to_path(move.source_path, destination_path);
+
+            while (transfer_result == file_move_status::destination_exists)
+            {
+                if (ask_on_collision)
+                {
+                    return park_collision();
+                }
+                claim_next_name();
+                transfer_result = fallback_transfer_to_path(move.source_path, destination_path);
+            }
         }
-        else if (creation_result == create_directory_status::permission_denied_failure ||
-                 fallback_transfer_result == file_move_status::permission_denied)
+        else
         {
-            return organize_status::permission_denied;
+            transfer_result = fallback_transfer(move.source_path, move.destination_directory,
+                                                &destination_path, move.target_filename);
         }
-        else if (creation_result == create_directory_status::unknown_failure)
+
+        if (transfer_result == file_move_status::unknown_failure)
         {
-            return organize_status::directory_creation_failed;
+            return organize_status::fallback_transfer_failed;
         }
-        else
+    }
+
+    if (transfer_result == file_move_status::successful_transfer)
+    {
+        if (final_path != nullptr)
         {
-            return organize_status::fallback_transfer_failed;
+            *final_path = destination_path;
         }
+        return organize_status::success;
+    }
+    else if (transfer_result == file_move_status::permission_denied)
+    {
+        return organize_status::permission_denied;
+    }
+    else
+    {
+        return organize_status::unknown_error;
     }
 }
 
 
 /*
     =========================================================
-        organize_directory
+        handle_file
     =========================================================
 
-    High-level orchestrator.
-
-    KEY DESIGN CHOICES:
-    -------------------
-    - Uses explicit stack (vector) instead of recursion
-    - Safe for deeply nested directories
-    - Processes folders level by level
+    Plans and immediately executes the move of a single file.
 */
-organize_status organize_directory(const std::string& root_path, transfer_mode t_mode)
+organize_status handle_file(
+    const std::string& current_directory_level_path,
+    const std::string& entry_path,
+    transfer_mode t_mode,
+    const organize_options& options,
+    std::filesystem::path* final_path
+    )
 {
-    // Validate root path before doing anything destructive
-    organize_status root_path_state = process_path_validation(root_path);
-    if (root_path_state != organize_status::success)
+    planned_move move;
+    std::string current_filename = std::filesystem::path(entry_path).filename().string();
+    organize_status s = plan_file(current_directory_level_path, current_filename, options, move);
+    if (s != organize_status::success)
     {
-        return root_path_state;
+        return s;
     }
 
-    // Manual stack of directories to process
-    std::vector<std::string> directories;
-    directories.push_back(root_path);
+    enter_phase(options, run_phase::transfer);
 
-    while (!directories.empty())
+    std::filesystem::path destination_path;
+    s = execute_move(move, t_mode, nullptr, options, &destination_path);
+
+    if (s == organize_status::success)
     {
-        // Pop one directory from stack
-        std::string current_directory_level_path = directories.back();
-        directories.pop_back();
+        report_move(options, move.source_path, destination_path);
+        if (final_path != nullptr)
+        {
+            *final_path = destination_path;
+        }
+    }
+    return s;
+}
+
+
+/*
+    The move itself, or (copied into settled) the same move sent to
+    its shard when its category folder was split after the move was
+    planned (see shard_registry::settled_directory).
+*/
+static const planned_move& settle_in_shard(const planned_move& move, const organize_options& options, planned_move& settled)
+{
+    if (options.shards == nullptr)
+    {
+        return move;
+    }
+
+    std::filesystem::path directory = options.shards->settled_directory(move.destination_directory, move.target_filename);
+    if (directory == std::filesystem::path(move.destination_directory))
+    {
+        return move;
+    }
+
+    settled = move;
+    settled.destination_directory = directory.string();
+    return settled;
+}
+
+
+/*
+    =========================================================
+        execute_plan
+    =========================================================
+
+    Executes a destination-ordered plan and records every
+    final location in the index.
+
+    ONE THREAD:
+    -----------
+    The plan is streamed straight into execute_move. The registry only
+    re-lists a folder when the stream moves on to the next one.
+
+    SEVERAL THREADS:
+    ----------------
+    The calling thread keeps draining (merging) the plan and hands
+    batches of moves to per-worker queues:
+
+    deterministic_collisions = true
+        A destination folder always goes to the same worker (hash of
+        its path), and queues are FIFO, so each folder sees its moves
+        in plan order = (name, source path) order. Collision numbering
+        is therefore the same as the single-threaded run.
+
+    deterministic_collisions = false
+        Batches go round-robin to whichever worker is next, all workers
+        share one locked registry, and collisions are numbered in
+        whatever order the workers reach them.
+
+    Moves whose source vanished since planning, and moves parked in the
+    decision queue, are skipped; the first real failure stops the run.
+*/
+static organize_status execute_plan(
+    move_plan& plan,
+    transfer_mode t_mode,
+    const organize_options& options,
+    directory_index& index,
+    const std::string& root_path
+    )
+{
+    organize_status execution_result = organize_status::success;
+
+    /*
+        Not failures: parked for the user, or removed by the user
+        while the walk was still running.
+    */
+    auto skipped = [](organize_status s, const planned_move& move)
+    {
+        return s == organize_status::decisions_pending
+            || (s == organize_status::unknown_error && !std::filesystem::exists(move.source_path));
+    };
+
+    /*
+        Small batches keep queue locking cheap without hurting balance.
+        Near the heap target, batches and queues shrink further.
+    */
+    memory_governor& governor = memory_governor::shared();
+    const std::size_t BATCH_SIZE = 64;
+    const std::size_t QUEUE_CAPACITY = governor.scaled(4, 1);
+
+    if (options.execution_threads <= 1)
+    {
+        destination_name_registry registry;
+        batch_slot slot(options.priority);
+        std::size_t moves_in_batch = 0;
+
+        plan_status ps = plan.drain([&](const planned_move& planned)
+        {
+            planned_move settled;
+            const planned_move& move = settle_in_shard(planned, options, settled);
+
+            if (++moves_in_batch == BATCH_SIZE)
+            {
+                slot.yield();
+                sample_counters(options);
+                moves_in_batch = 0;
+            }
+
+            std::filesystem::path final_path;
+            execution_result = execute_move(move, t_mode, &registry, options, &final_path);
+
+            if (skipped(execution_result, move))
+            {
+                execution_result = organize_status::success;
+                return true;
+            }
+
+            if (execution_result != organize_status::success)
+            {
+                return false;
+            }
+
+            record_file_location(index, root_path, final_path);
+            report_move(options, move.source_path, final_path);
+            return true;
+        });
+
+        if (ps == plan_status::spill_failed)
+        {
+            execution_result = organize_status::unknown_error;
+        }
+        return execution_result;
+    }
+
+    typedef std::vector<planned_move> move_batch;
+
+    std::size_t thread_count = options.execution_threads;
+    bool deterministic = options.deterministic_collisions;
+
+    // The counter group belongs to this thread; the workers run unmeasured
+    if (options.metrics != nullptr)
+    {
+        options.metrics->set_unmeasured_worker_threads(static_cast<unsigned>(thread_count));
+    }
+
+    std::vector<std::unique_ptr<work_queue<move_batch>>> queues;
+    for (std::size_t i = 0; i < thread_count; i++)
+    {
+        queues.push_back(std::make_unique<work_queue<move_batch>>(QUEUE_CAPACITY));
+    }
+
+    shared_name_registry shared_registry;
+    std::mutex result_mutex;                // Guards index and execution_result
+    std::atomic<bool> failed{false};
+
+    auto worker = [&](std::size_t worker_id)
+    {
+        destination_name_registry own_registry;
+        name_registry* registry = deterministic ? static_cast<name_registry*>(&own_registry)
+                                                : static_cast<name_registry*>(&shared_registry);
+
+        move_batch batch;
+        std::vector<std::filesystem::path> moved;
+
+        // Keeps popping after a failure so the producer never blocks
+        while (queues[worker_id]->pop(batch))
+        {
+            // Held for one batch: the boundary where bulk work yields
+            batch_slot slot(options.priority);
+
+            for (const planned_move& move : batch)
+            {
+                if (failed.load())
+                {
+                    break;
+                }
+
+                std::filesystem::path final_path;
+                organize_status s = execute_move(move, t_mode, registry, options, &final_path);
+
+                if (skipped(s, move))
+                {
+                    continue;
+                }
+
+                if (s != organize_status::success)
+                {
+                    std::lock_guard<std::mutex> lock(result_mutex);
+                    if (execution_result == organize_status::success)
+                    {
+                        execution_result = s;
+                    }
+                    failed = true;
+                    break;
+                }
+
+                report_move(options, move.source_path, final_path);
+                moved.push_back(final_path);
+            }
+
+            std::lock_guard<std::mutex> lock(result_mutex);
+            for (const std::filesystem::path& final_path : moved)
+            {
+                record_file_location(index, root_path, final_path);
+            }
+            moved.clear();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < thread_count; i++)
+    {
+        workers.emplace_back(worker, i);
+    }
+
+    std::vector<move_batch> batches(thread_count);
+    std::string current_destination;
+    std::size_t target = 0;
+
+    plan_status ps = plan.drain([&](const planned_move& planned)
+    {
+        if (failed.load())
+        {
+            return false;
+        }
+
+        planned_move settled;
+        const planned_move& move = settle_in_shard(planned, options, settled);
+
+        if (deterministic && move.destination_directory != current_destination)
+        {
+            // Same folder → same worker, for the whole run
+            current_destination = move.destination_directory;
+            target = std::hash<std::string>()(current_destination) % thread_count;
+        }
+
+        batches[target].push_back(move);
+
+        if (batches[target].size() >= governor.scaled(BATCH_SIZE, 8))
+        {
+            queues[target]->push(std::move(batches[target]));
+            batches[target].clear();
+
+            if (!deterministic)
+            {
+                target = (target + 1) % thread_count;
+            }
+        }
+        return true;
+    });
+
+    for (std::size_t i = 0; i < thread_count; i++)
+    {
+        if (!batches[i].empty())
+        {
+            queues[i]->push(std::move(batches[i]));
+        }
+        queues[i]->close();
+    }
+
+    for (std::thread& t : workers)
+    {
+        t.join();
+    }
+
+    if (ps == plan_status::spill_failed && execution_result == organize_status::success)
+    {
+        execution_result = organize_status::unknown_error;
+    }
+    return execution_result;
+}
+
+
+/*
+    =========================================================
+        explode_found_archive
+    =========================================================
+
+    options.explode_archives: unpacks an archive met by the walk into
+    the category folders of its own level. Archives already filed
+    under "Archive Files" (or a shard of it) are left alone.
+
+    Returns true if every member was placed and the archive removed.
+    Otherwise the members already placed are deleted again (the
+    archive still holds them) and false leaves the archive to be
+    organized as a normal file. Nothing reaches the index or the hook
+    before the whole archive is through.
+*/
+static bool explode_found_archive(
+    const std::string& current_directory_level_path,
+    const std::string& filename,
+    const organize_options& run_options,
+    directory_index& index,
+    const std::string& root_path
+    )
+{
+    if (classify_file_by_extension(filename) != "Archive Files")
+    {
+        return false;
+    }
+
+    std::filesystem::path relative = std::filesystem::path(current_directory_level_path).lexically_relative(root_path);
+    for (const std::filesystem::path& component : relative)
+    {
+        if (component == "Archive Files")
+        {
+            return false;
+        }
+    }
+
+    std::filesystem::path archive_path = std::filesystem::path(current_directory_level_path) / filename;
+    if (detect_archive_format(archive_path) == archive_format::none)
+    {
+        return false;
+    }
+
+    enter_phase(run_options, run_phase::transfer);
+
+    explode_policy policy;
+    policy.remove_archive = true;
+
+    std::vector<std::pair<std::string, std::filesystem::path>> placed;
+
+    explode_summary summary = explode_archive(
+        archive_path,
+        current_directory_level_path,
+        run_options,
+        policy,
+        [&](const std::string& member_path, const std::filesystem::path& final_path)
+        {
+            placed.emplace_back(member_path, final_path);
+        });
+
+    if (summary.status != explode_status::ok || summary.skipped != 0)
+    {
+        // The archive stays: placed members would be duplicates of its content
+        for (const std::pair<std::string, std::filesystem::path>& member : placed)
+        {
+            std::error_code ec;
+            std::filesystem::remove(member.second, ec);
+        }
+        return false;
+    }
+
+    for (const std::pair<std::string, std::filesystem::path>& member : placed)
+    {
+        record_file_location(index, root_path, member.second);
+        report_move(run_options, archive_path / member.first, member.second);
+    }
+    return true;
+}
+
+
+/*
+    =========================================================
+        organize_directory
+    =========================================================
+
+    High-level orchestrator.
+
+    KEY DESIGN CHOICES:
+    -------------------
+    - Uses explicit stack (vector) instead of recursion
+    - Safe for deeply nested directories
+    - Processes folders level by level
+    - Reads each folder in struct-of-arrays batches (scan_batch.hpp)
+    - Records every file location in the directory index,
+      so later rule changes can be applied incrementally
+*/
+organize_status organize_directory(const std::string& root_path, transfer_mode t_mode, const organize_options& options)
+{
+    // Validate root path before doing anything destructive
+    organize_status root_path_state = process_path_validation(root_path);
+    if (root_path_state != organize_status::success)
+    {
+        return root_path_state;
+    }
+
+    organize_options run_options = options;
+    std::unique_ptr<heap_target_hold> target_hold = start_memory_governor(run_options);
+    std::unique_ptr<run_metrics> metrics = start_metrics(run_options);
+    std::unique_ptr<shard_registry> shards = start_sharding(run_options);
+    std::unique_ptr<move_hook> hooks = start_hooks(run_options);
+
+    // Rebuilt from scratch: a full walk sees every file
+    directory_index index;
+    index.rules = EXTENSION_LOOKUP;
+
+    // Destination order: moves are collected here and executed after the walk
+    std::unique_ptr<move_plan> plan;
+    if (options.order == execution_order::destination_order || options.execution_threads > 1)
+    {
+        // A quarter of the heap target at most; the governor may spill it earlier
+        std::size_t plan_budget = options.plan_memory_budget;
+        if (options.heap_target != 0)
+        {
+            plan_budget = std::min(plan_budget, options.heap_target / 4);
+        }
+        plan = std::make_unique<move_plan>(get_state_directory(root_path), plan_budget);
+    }
+
+    // Manual stack of directories to process
+    std::vector<std::string> directories;
+    directories.push_back(root_path);
+
+    // Reused for every directory, so scanning does not allocate per entry
+    scan_batch batch;
+
+    while (!directories.empty())
+    {
+        // Pop one directory from stack
+        std::string current_directory_level_path = directories.back();
+        directories.pop_back();
 
         /*
             Normalize folder names at this level first.
@@ -255,39 +1100,494 @@ organize_status organize_directory(const std::string& root_path, transfer_mode t
             - "images", "pics", etc → "Image Files"
             - No duplicate category folders are created
         */
+        enter_phase(run_options, run_phase::normalize);
         normalize_category_folder(current_directory_level_path);
 
-        // Iterate through current directory contents
-        for (const std::filesystem::directory_entry& entry_in_directory :
-             std::filesystem::directory_iterator(current_directory_level_path))
+        enter_phase(run_options, run_phase::scan);
+
+        partitioned_directory_scanner scanner(run_options.directory_read_threads);
+        scan_status opened = scanner.open(current_directory_level_path);
+        if (opened != scan_status::ok)
+        {
+            finish_run(root_path, run_options);
+            return opened == scan_status::permission_denied ? organize_status::permission_denied
+                                                            : organize_status::unknown_error;
+        }
+
+        // Iterate through current directory contents, one dense batch at a time
+        scan_status batch_state;
+        while ((batch_state = scanner.next_batch(batch, memory_governor::shared().scaled(1024, 64))) == scan_status::ok)
         {
-            std::string entry_path = entry_in_directory.path().string();
+            batch_slot slot(run_options.priority);
 
-            if (std::filesystem::is_regular_file(entry_path))
+            if (run_options.metrics != nullptr)
             {
-                organize_status s =
-                    handle_file(current_directory_level_path, entry_path, t_mode);
+                run_options.metrics->sample_counters();
+                run_options.metrics->add_scanned_entries(batch.size());
+            }
 
-                // Already correct = silently skip
-                if (s == organize_status::already_in_correct_location)
+            for (std::size_t i = 0; i < batch.size(); i++)
+            {
+                if (batch.types[i] == scan_entry_type::regular_file)
                 {
-                    continue;
+                    std::string filename(batch.name(i));
+                    std::filesystem::path final_path;
+                    organize_status s;
+                    bool planned = false;
+
+                    // Unpacked into the category folders: nothing left to move
+                    if (run_options.explode_archives
+                        && explode_found_archive(current_directory_level_path, filename, run_options, index, root_path))
+                    {
+                        enter_phase(run_options, run_phase::scan);
+                        continue;
+                    }
+
+                    if (plan)
+                    {
+                        planned_move move;
+                        s = plan_file(current_directory_level_path, filename, run_options, move);
+
+                        if (s == organize_status::success)
+                        {
+                            planned = true;
+                            if (plan->add(std::move(move)) != plan_status::ok)
+                            {
+                                s = organize_status::unknown_error;
+                            }
+                        }
+                    }
+                    else
+                    {
+                        std::string entry_path = (std::filesystem::path(current_directory_level_path) / filename).string();
+                        s = handle_file(current_directory_level_path, entry_path, t_mode, run_options, &final_path);
+                    }
+
+                    // Back to reading entries
+                    enter_phase(run_options, run_phase::scan);
+                    apply_shard_relocations(index, root_path, run_options);
+
+                    // Already correct = silently skip
+                    if (s == organize_status::already_in_correct_location)
+                    {
+                        record_file_location(index, root_path, std::filesystem::path(current_directory_level_path) / filename);
+                        continue;
+                    }
+                    // Planned moves are recorded once the plan is executed
+                    else if (s == organize_status::success && planned)
+                    {
+                        continue;
+                    }
+                    // Parked for the user: recorded by apply_decisions()
+                    else if (s == organize_status::decisions_pending)
+                    {
+                        continue;
+                    }
+                    else if (s == organize_status::success)
+                    {
+                        record_file_location(index, root_path, final_path);
+                    }
+                    // Any real failure stops the operation
+                    else if (s != organize_status::success)
+                    {
+                        finish_run(root_path, run_options);
+                        return s;
+                    }
                 }
-                // Any real failure stops the operation
-                else if (s != organize_status::success)
+                else if (batch.types[i] == scan_entry_type::directory)
                 {
-                    return s;
+                    // Skip hidden/system directories
+                    std::string_view name = batch.name(i);
+                    if (!name.empty() && name[0] != '.')
+                    {
+                        directories.push_back((std::filesystem::path(current_directory_level_path) / name).string());
+                    }
+                    // Leftovers of interrupted copies: cleaned, never organized
+                    else if (is_partial_folder_name(std::string(name)))
+                    {
+                        sweep_partial_folder(current_directory_level_path);
+                    }
                 }
             }
-            else if (std::filesystem::is_directory(entry_path))
+        }
+
+        if (batch_state == scan_status::failed)
+        {
+            finish_run(root_path, run_options);
+            return organize_status::unknown_error;
+        }
+    }
+
+    // Destination order: execute the sorted plan
+    if (plan)
+    {
+        enter_phase(run_options, run_phase::transfer);
+
+        organize_status execution_result = execute_plan(*plan, t_mode, run_options, index, root_path);
+        if (execution_result != organize_status::success)
+        {
+            finish_run(root_path, run_options);
+            return execution_result;
+        }
+    }
+
+    /*
+        A failed save only costs the next rule change a full walk,
+        so it does not turn a successful organize into an error.
+    */
+    enter_phase(run_options, run_phase::index);
+    save_directory_index(root_path, index);
+
+    // Like the index, a missing snapshot only costs the next diff its baseline
+    if (run_options.record_snapshot)
+    {
+        record_tree_snapshot(root_path);
+    }
+
+    finish_run(root_path, run_options);
+
+    return finished_result(run_options);
+}
+
+
+/*
+    =========================================================
+        reclassify_directory
+    =========================================================
+
+    Applies changes of CATEGORY_EXTENSION_MAP incrementally.
+
+    STRATEGY:
+    ---------
+    1. Load the directory index written by the last run
+    2. Diff its rule table against the current EXTENSION_LOOKUP
+    3. Re-handle ONLY the indexed files whose extension changed category
+
+    Files whose extension kept its category are never touched,
+    not even stat()-ed.
+
+    Falls back to organize_directory() when no usable index exists.
+*/
+organize_status reclassify_directory(const std::string& root_path, transfer_mode t_mode, const organize_options& options)
+{
+    organize_status root_path_state = process_path_validation(root_path);
+    if (root_path_state != organize_status::success)
+    {
+        return root_path_state;
+    }
+
+    // The rules first, then only the groups whose category changed
+    directory_index index;
+    if (load_directory_index(root_path, index, std::set<std::string>()) != index_status::ok)
+    {
+        return organize_directory(root_path, t_mode, options);
+    }
+
+    std::set<std::string> changed_extensions = diff_rule_tables(index.rules, EXTENSION_LOOKUP);
+    if (load_directory_index(root_path, index, changed_extensions) != index_status::ok)
+    {
+        return organize_directory(root_path, t_mode, options);
+    }
+
+    organize_options run_options = options;
+    std::unique_ptr<heap_target_hold> target_hold = start_memory_governor(run_options);
+    std::unique_ptr<run_metrics> metrics = start_metrics(run_options);
+    std::unique_ptr<shard_registry> shards = start_sharding(run_options);
+    std::unique_ptr<move_hook> hooks = start_hooks(run_options);
+
+    enter_phase(run_options, run_phase::index);
+
+    /*
+        The work list. Taken out of the index, so recording the new
+        locations may spill the index without spilling the work; the
+        old locations are still in the index file until forgotten.
+    */
+    std::map<std::string, std::set<std::string>> changed_groups;
+    changed_groups.swap(index.locations);
+    index.spill.memory_bytes = 0;
+
+    // Same batch boundaries as a plan execution
+    const std::size_t BATCH_SIZE = 64;
+    batch_slot slot(run_options.priority);
+    std::size_t files_in_batch = 0;
+
+    for (const std::string& extension : changed_extensions)
+    {
+        std::map<std::string, std::set<std::string>>::iterator group = changed_groups.find(extension);
+        if (group == changed_groups.end())
+        {
+            continue;
+        }
+
+        for (const std::string& relative_path : group->second)
+        {
+            if (++files_in_batch == BATCH_SIZE)
+            {
+                slot.yield();
+                sample_counters(run_options);
+                files_in_batch = 0;
+            }
+
+            std::filesystem::path file_path = std::filesystem::path(root_path) / relative_path;
+
+            // Removed or replaced by the user since the last run
+            enter_phase(run_options, run_phase::scan);
+            if (!std::filesystem::is_regular_file(file_path))
+            {
+                forget_file_location(index, root_path, file_path);
+                continue;
+            }
+
+            std::filesystem::path final_path;
+            organize_status s = handle_file(
+                file_path.parent_path().string(),
+                file_path.string(),
+                t_mode,
+                run_options,
+                &final_path
+                );
+
+            enter_phase(run_options, run_phase::index);
+            apply_shard_relocations(index, root_path, run_options);
+            if (s == organize_status::success)
             {
-                // Skip hidden/system directories
-                std::string name = entry_in_directory.path().filename().string();
-                if (!name.empty() && name[0] != '.')
+                forget_file_location(index, root_path, file_path);
+                record_file_location(index, root_path, final_path);
+            }
+            else if (s != organize_status::already_in_correct_location
+                     && s != organize_status::decisions_pending)
+            {
+                /*
+                    Keep the OLD rule table so the next attempt
+                    retries everything that has not been moved yet.
+                */
+                save_directory_index(root_path, index);
+                finish_run(root_path, run_options);
+                return s;
+            }
+        }
+    }
+
+    enter_phase(run_options, run_phase::index);
+    index.rules = EXTENSION_LOOKUP;
+    save_directory_index(root_path, index);
+
+    if (run_options.record_snapshot)
+    {
+        record_tree_snapshot(root_path);
+    }
+
+    finish_run(root_path, run_options);
+
+    return finished_result(run_options);
+}
+
+
+/*
+    =========================================================
+        apply_decisions
+    =========================================================
+
+    Executes the parked moves the user decided on.
+
+    copy_and_delete → fallback mode (rename first, copy if needed)
+    keep_both       → numbered name next to the existing file
+    skip / undecided → left where they are
+
+    The decision is final, so these moves never park again.
+*/
+organize_status apply_decisions(
+    const std::string& root_path,
+    const std::vector<deferred_decision>& decisions,
+    const organize_options& options
+    )
+{
+    organize_status root_path_state = process_path_validation(root_path);
+    if (root_path_state != organize_status::success)
+    {
+        return root_path_state;
+    }
+
+    organize_options run_options = options;
+    run_options.deferred = nullptr;
+    run_options.on_collision = collision_policy::keep_both;
+    std::unique_ptr<move_hook> hooks = start_hooks(run_options);
+
+    /*
+        Rules only: the decided moves are recorded on top of the
+        locations left in the index file.
+        A missing index simply starts empty; the next full run rebuilds it.
+    */
+    directory_index index;
+    if (load_directory_index(root_path, index, std::set<std::string>()) != index_status::ok)
+    {
+        index = directory_index();
+        index.rules = EXTENSION_LOOKUP;
+    }
+
+    organize_status result = organize_status::success;
+
+    for (const deferred_decision& decision : decisions)
+    {
+        transfer_mode t_mode;
+        if (decision.choice == decision_choice::copy_and_delete)
+        {
+            t_mode = transfer_mode::fallback_transfer_mode;
+        }
+        else if (decision.choice == decision_choice::keep_both)
+        {
+            t_mode = transfer_mode::atomic_transfer_mode;
+        }
+        else
+        {
+            continue;
+        }
+
+        // Changed by the user since it was parked
+        if (!std::filesystem::is_regular_file(decision.move.source_path))
+        {
+            continue;
+        }
+
+        std::filesystem::path final_path;
+        organize_status s = execute_move(decision.move, t_mode, nullptr, run_options, &final_path);
+
+        if (s != organize_status::success)
+        {
+            result = s;
+            break;
+        }
+
+        forget_file_location(index, root_path, decision.move.source_path);
+        record_file_location(index, root_path, final_path);
+        report_move(run_options, decision.move.source_path, final_path);
+    }
+
+    save_directory_index(root_path, index);
+    finish_run(root_path, run_options);
+
+    return result;
+}
+
+
+/*
+    Outcomes of a watch-mode pass that leave watching running: parked
+    decisions wait for the user, they do not end the watch.
+    Used for single files and overflow rescans alike.
+*/
+static bool keeps_watching(organize_status status)
+{
+    return status == organize_status::success
+        || status == organize_status::already_in_correct_location
+        || status == organize_status::decisions_pending;
+}
+
+
+/*
+    =========================================================
+        watch_directory
+    =========================================================
+
+    Event-driven counterpart of organize_directory.
+
+    Only the files named by events are examined; the tree is never
+    walked again unless the kernel reports lost events.
+*/
+organize_status watch_directory(
+    const std::string& root_path,
+    transfer_mode t_mode,
+    const organize_options& options,
+    const std::atomic<bool>* stop_requested,
+    const std::function<void(watch_coverage)>& on_started
+    )
+{
+    organize_status root_path_state = process_path_validation(root_path);
+    if (root_path_state != organize_status::success)
+    {
+        return root_path_state;
+    }
+
+    fanotify_watcher watcher;
+    if (watcher.start(root_path) != watch_status::ok)
+    {
+        return organize_status::watch_unavailable;
+    }
+
+    // Without CAP_SYS_ADMIN subfolders go unwatched: the caller must know
+    if (on_started)
+    {
+        on_started(watcher.coverage());
+    }
+
+    // Compare against the same canonical form the watcher reports
+    std::filesystem::path canonical_root = std::filesystem::canonical(root_path);
+
+    organize_options run_options = options;
+    std::unique_ptr<heap_target_hold> target_hold = start_memory_governor(run_options);
+    std::unique_ptr<shard_registry> shards = start_sharding(run_options);
+    std::unique_ptr<move_hook> hooks = start_hooks(run_options);
+
+    // Cheap enough to poll the stop flag twice a second
+    const int POLL_TIMEOUT_MS = 500;
+
+    while (!stop_requested->load())
+    {
+        std::vector<std::filesystem::path> changed_files;
+        watch_status ws = watcher.wait_for_changes(POLL_TIMEOUT_MS, changed_files);
+
+        if (ws == watch_status::queue_overflow)
+        {
+            // Events were lost: one full pass restores a clean state
+            organize_status s = organize_directory(root_path, t_mode, options);
+            if (!keeps_watching(s))
+            {
+                return s;
+            }
+            continue;
+        }
+        else if (ws != watch_status::ok)
+        {
+            return organize_status::watch_unavailable;
+        }
+
+        // One batch per wakeup; never held while waiting for events
+        batch_slot slot(run_options.priority);
+
+        for (const std::filesystem::path& file_path : changed_files)
+        {
+            /*
+                Same visibility rules as the walk:
+                nothing inside hidden directories (this also skips our
+                own state in .file_organizer).
+            */
+            bool hidden = false;
+            for (const std::filesystem::path& part : file_path.parent_path().lexically_relative(canonical_root))
+            {
+                std::string name = part.string();
+                if (!name.empty() && name[0] == '.' && name != ".")
                 {
-                    directories.push_back(entry_path);
+                    hidden = true;
+                    break;
                 }
             }
+
+            // Gone again, or not a plain file
+            if (hidden || !std::filesystem::is_regular_file(file_path))
+            {
+                continue;
+            }
+
+            organize_status s = handle_file(
+                file_path.parent_path().string(),
+                file_path.string(),
+                t_mode,
+                run_options
+                );
+
+            if (!keeps_watching(s))
+            {
+                return s;
+            }
         }
     }
 
@@ -0,0 +1,243 @@
+#include "partitioned_scan.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+#if defined(__linux__)
+#define PARTITIONED_SCAN_LINUX 1
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#endif
+
+// Entries per batch handed from a reader to the consumer
+static const std::size_t READER_BATCH_ENTRIES = 256;
+
+// Smaller directories are read serially (roughly 30k entries)
+static const std::uint64_t MINIMUM_DIRECTORY_BYTES = 1024 * 1024;
+
+// Positions looked at to decide whether the directory is hash-ordered
+static const int PROBE_ENTRIES = 8;
+
+// Positions are hashes below 2^63 (the top value marks the end)
+static const std::uint64_t HASH_SPACE = 1ULL << 63;
+
+/*
+    True if the positions of path are ordered hash values that
+    seekdir() accepts anywhere (see the header).
+*/
+static bool has_hash_ordered_positions(const std::string& path)
+{
+#if defined(PARTITIONED_SCAN_LINUX)
+    const long EXT_SUPER_MAGIC = 0xEF53;    // ext2, ext3 and ext4 share it
+
+    struct statfs fs;
+    if (statfs(path.c_str(), &fs) != 0 || static_cast<long>(fs.f_type) != EXT_SUPER_MAGIC)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || static_cast<std::uint64_t>(st.st_size) < MINIMUM_DIRECTORY_BYTES)
+    {
+        return false;
+    }
+
+    DIR* stream = opendir(path.c_str());
+    if (stream == nullptr)
+    {
+        return false;
+    }
+
+    /*
+        Hashed positions use the upper 32 bits and grow strictly.
+        Linear (non-indexed) ext directories hand out small block
+        offsets instead.
+    */
+    bool hashed = true;
+    std::uint64_t previous = 0;
+    int seen = 0;
+
+    while (seen < PROBE_ENTRIES && readdir(stream) != nullptr)
+    {
+        std::uint64_t position = static_cast<std::uint64_t>(telldir(stream));
+        if (position >= HASH_SPACE)
+        {
+            break;      // End of directory
+        }
+        if (position <= previous || position < (1ULL << 32))
+        {
+            hashed = false;
+            break;
+        }
+        previous = position;
+        seen++;
+    }
+
+    closedir(stream);
+    return hashed && seen > 0;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+/*
+    =========================================================
+        partitioned_directory_scanner
+    =========================================================
+*/
+partitioned_directory_scanner::partitioned_directory_scanner(unsigned threads)
+    : threads(threads == 0 ? 1 : threads)
+{
+}
+
+partitioned_directory_scanner::~partitioned_directory_scanner()
+{
+    stop_readers();
+}
+
+bool partitioned_directory_scanner::is_partitioned() const
+{
+    return partitioned;
+}
+
+void partitioned_directory_scanner::stop_readers()
+{
+    if (ready)
+    {
+        ready->close();     // Blocked readers give up their batch
+    }
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+    readers.clear();
+    ready.reset();
+}
+
+scan_status partitioned_directory_scanner::open(const std::string& path)
+{
+    stop_readers();
+    partitioned = false;
+    directory_path = path;
+
+    // Also reports a missing or forbidden directory, in both modes
+    scan_status opened = serial.open(path);
+    if (opened != scan_status::ok || threads < 2 || !has_hash_ordered_positions(path))
+    {
+        return opened;
+    }
+
+    partitioned = true;
+    failed = false;
+    first_entries.assign(threads, scan_batch());
+    running_readers = threads;
+    ready = std::make_unique<work_queue<scan_batch>>(4 * static_cast<std::size_t>(threads));
+
+    std::uint64_t width = HASH_SPACE / threads;
+    for (unsigned k = 0; k < threads; k++)
+    {
+        std::uint64_t start = k * width;
+        std::uint64_t end = (k + 1 == threads) ? UINT64_MAX : (k + 1) * width;
+        readers.emplace_back(&partitioned_directory_scanner::read_range, this, k, start, end);
+    }
+    return scan_status::ok;
+}
+
+/*
+    =========================================================
+        partitioned_directory_scanner::read_range
+    =========================================================
+
+    Runs on reader thread `range`.
+*/
+void partitioned_directory_scanner::read_range(std::size_t range, std::uint64_t start, std::uint64_t end)
+{
+    directory_scanner scanner;
+    scan_status status = scanner.open_range(directory_path, start, end);
+
+    // The first entry is held back: it may belong to a later range
+    if (status == scan_status::ok)
+    {
+        status = scanner.next_batch(first_entries[range], 1);
+    }
+
+    scan_batch batch;
+    while (status == scan_status::ok)
+    {
+        status = scanner.next_batch(batch, READER_BATCH_ENTRIES);
+        if (status == scan_status::ok && !ready->push(std::move(batch)))
+        {
+            return;     // Consumer gave up, nobody waits for the rest
+        }
+        batch = scan_batch();
+    }
+
+    if (status != scan_status::end_of_directory)
+    {
+        failed = true;
+    }
+    finish_range();
+}
+
+/*
+    The last reader to finish reports the held-back first entries.
+
+    An empty range reads the first entry of the next non-empty range
+    as its own first entry, so every duplicate is a first entry too,
+    and names are unique within a directory.
+*/
+void partitioned_directory_scanner::finish_range()
+{
+    if (running_readers.fetch_sub(1) != 1)
+    {
+        return;
+    }
+
+    scan_batch firsts;
+    firsts.name_offsets.push_back(0);
+    std::unordered_set<std::string_view> reported;
+
+    for (const scan_batch& first : first_entries)
+    {
+        if (first.size() == 0 || !reported.insert(first.name(0)).second)
+        {
+            continue;
+        }
+        firsts.name_blob.append(first.name(0));
+        firsts.name_offsets.push_back(static_cast<std::uint32_t>(firsts.name_blob.size()));
+        firsts.types.push_back(first.types[0]);
+        firsts.sizes.push_back(first.sizes[0]);
+        firsts.mtimes_ns.push_back(first.mtimes_ns[0]);
+        firsts.inodes.push_back(first.inodes[0]);
+    }
+
+    if (firsts.size() != 0)
+    {
+        ready->push(std::move(firsts));
+    }
+    ready->close();
+}
+
+/*
+    =========================================================
+        partitioned_directory_scanner::next_batch
+    =========================================================
+*/
+scan_status partitioned_directory_scanner::next_batch(scan_batch& batch, std::size_t max_entries)
+{
+    if (!partitioned)
+    {
+        return serial.next_batch(batch, max_entries);
+    }
+
+    batch.clear();
+    if (ready->pop(batch))
+    {
+        return scan_status::ok;
+    }
+
+    batch.name_offsets.push_back(0);
+    return failed ? scan_status::failed : scan_status::end_of_directory;
+}
@@ -0,0 +1,695 @@
+#include "resumable_copy.hpp"
+#include "memory_governor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RESUMABLE_COPY_POSIX 1
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char* JOURNAL_HEADER = "file_organizer_copy 1";
+
+static const std::uint64_t HASH_SEED = 14695981039346656037ULL;
+
+// Temporary files without a journal older than this belong to no running copy
+static const std::chrono::hours STALE_TEMPORARY_AGE(24);
+
+// Full and smallest copy buffer (the governor picks in between)
+static const std::size_t COPY_BUFFER = 1024 * 1024;
+static const std::size_t MIN_COPY_BUFFER = 64 * 1024;
+
+// FNV-1a, 64 bit: cheap and good enough to catch corrupted chunks
+static void hash_block(std::uint64_t& hash, const unsigned char* data, std::size_t length)
+{
+    for (std::size_t i = 0; i < length; i++)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+static std::string to_hex(std::uint64_t value)
+{
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+
+/*
+    Temporary name of the copy: a hash of the absolute source path,
+    so an interrupted copy is found again whatever name the
+    destination gets on the next run.
+*/
+static std::string source_id(const std::filesystem::path& source_path)
+{
+    std::error_code ec;
+    std::string absolute = std::filesystem::absolute(source_path, ec).string();
+
+    std::uint64_t hash = HASH_SEED;
+    hash_block(hash, reinterpret_cast<const unsigned char*>(absolute.data()), absolute.size());
+    return to_hex(hash);
+}
+
+static file_move_status status_from(const std::error_code& ec)
+{
+    return ec == std::errc::permission_denied ? file_move_status::permission_denied
+                                              : file_move_status::unknown_failure;
+}
+
+#if defined(RESUMABLE_COPY_POSIX)
+
+static file_move_status status_from_errno(int error)
+{
+    if (error == EEXIST)
+    {
+        return file_move_status::destination_exists;
+    }
+    return (error == EACCES || error == EPERM) ? file_move_status::permission_denied
+                                               : file_move_status::unknown_failure;
+}
+
+/*
+    =========================================================
+        Copy journal
+    =========================================================
+
+    Text file next to the temporary copy:
+
+        file_organizer_copy 1
+        source  <absolute source path>
+        size    <bytes>
+        mtime   <nanoseconds>
+        chunk   <chunk size>
+        C       <chunk index>   <hash>      (one line per finished chunk)
+
+    Records are appended and flushed after the chunk's data, so every
+    record describes data that reached the disk. A torn last line
+    (crash while appending) is ignored.
+*/
+static std::string journal_header(
+    const std::filesystem::path& source_path,
+    std::uint64_t size,
+    std::int64_t mtime_ns,
+    std::uint64_t chunk_size
+    )
+{
+    std::error_code ec;
+    return std::string(JOURNAL_HEADER) + "\n"
+        + "source\t" + std::filesystem::absolute(source_path, ec).string() + "\n"
+        + "size\t" + std::to_string(size) + "\n"
+        + "mtime\t" + std::to_string(mtime_ns) + "\n"
+        + "chunk\t" + std::to_string(chunk_size) + "\n";
+}
+
+/*
+    Fills done / hashes from an existing journal, and last_recorded
+    with the chunk of the last complete record (chunk_count if none).
+    Returns false (and leaves them cleared) if there is no journal or
+    it belongs to another version of the source.
+*/
+static bool read_journal(
+    const std::filesystem::path& journal_path,
+    const std::string& expected_header,
+    std::vector<char>& done,
+    std::vector<std::uint64_t>& hashes,
+    std::size_t& last_recorded
+    )
+{
+    last_recorded = done.size();
+
+    std::FILE* file = std::fopen(journal_path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    std::string content;
+    char buffer[65536];
+    std::size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        content.append(buffer, n);
+    }
+    std::fclose(file);
+
+    if (content.compare(0, expected_header.size(), expected_header) != 0)
+    {
+        return false;
+    }
+
+    std::size_t position = expected_header.size();
+    while (position < content.size())
+    {
+        std::size_t end = content.find('\n', position);
+        if (end == std::string::npos)
+        {
+            break;  // Torn record
+        }
+
+        unsigned long long index = 0;
+        unsigned long long hash = 0;
+        std::string line = content.substr(position, end - position);
+
+        if (std::sscanf(line.c_str(), "C\t%llu\t%llx", &index, &hash) == 2 && index < done.size())
+        {
+            done[index] = 1;
+            hashes[index] = hash;
+            last_recorded = static_cast<std::size_t>(index);
+        }
+        position = end + 1;
+    }
+    return true;
+}
+
+/*
+    Copies (or, with verify_only, hashes the destination of) the byte
+    range [offset, offset + length) and returns its hash.
+*/
+static bool process_chunk(
+    int in,
+    int out,
+    std::uint64_t offset,
+    std::uint64_t length,
+    std::vector<unsigned char>& buffer,
+    bool verify_only,
+    std::uint64_t& hash
+    )
+{
+    hash = HASH_SEED;
+    int read_fd = verify_only ? out : in;
+
+    while (length > 0)
+    {
+        std::size_t wanted = static_cast<std::size_t>(std::min<std::uint64_t>(length, buffer.size()));
+        ssize_t n = pread(read_fd, buffer.data(), wanted, static_cast<off_t>(offset));
+
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;   // Error, or the file is shorter than expected
+        }
+
+        hash_block(hash, buffer.data(), static_cast<std::size_t>(n));
+
+        if (!verify_only)
+        {
+            for (ssize_t written = 0; written < n; )
+            {
+                ssize_t w = pwrite(out, buffer.data() + written, static_cast<std::size_t>(n - written),
+                                   static_cast<off_t>(offset) + written);
+                if (w < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return false;
+                }
+                written += w;
+            }
+        }
+
+        offset += static_cast<std::uint64_t>(n);
+        length -= static_cast<std::uint64_t>(n);
+    }
+    return true;
+}
+
+/*
+    =========================================================
+        chunked_copy
+    =========================================================
+
+    Copies every chunk the journal does not list as done (or, for
+    the last recorded chunk, whose hash no longer matches the
+    temporary file).
+
+    On failure the temporary file and the journal are kept for the
+    next attempt, unless source_gone is set: the source vanished or
+    changed, and what was copied so far is worthless.
+*/
+static file_move_status chunked_copy(
+    const std::filesystem::path& source_path,
+    const std::filesystem::path& temp_path,
+    const std::filesystem::path& journal_path,
+    const resumable_copy_policy& policy,
+    bool& source_gone
+    )
+{
+    source_gone = false;
+
+    int in = open(source_path.c_str(), O_RDONLY);
+    if (in < 0)
+    {
+        source_gone = (errno == ENOENT);
+        return status_from_errno(errno);
+    }
+
+    struct stat source_stat;
+    if (fstat(in, &source_stat) != 0)
+    {
+        int error = errno;
+        close(in);
+        return status_from_errno(error);
+    }
+
+#if defined(__APPLE__)
+    std::int64_t mtime_ns = static_cast<std::int64_t>(source_stat.st_mtimespec.tv_sec) * 1000000000LL
+        + source_stat.st_mtimespec.tv_nsec;
+#else
+    std::int64_t mtime_ns = static_cast<std::int64_t>(source_stat.st_mtim.tv_sec) * 1000000000LL
+        + source_stat.st_mtim.tv_nsec;
+#endif
+
+    std::uint64_t size = static_cast<std::uint64_t>(source_stat.st_size);
+    std::uint64_t chunk_size = std::max<std::uint64_t>(policy.chunk_size, 1024 * 1024);
+    std::size_t chunk_count = static_cast<std::size_t>((size + chunk_size - 1) / chunk_size);
+
+    std::string header = journal_header(source_path, size, mtime_ns, chunk_size);
+    std::vector<char> done(chunk_count, 0);
+    std::vector<std::uint64_t> hashes(chunk_count, 0);
+
+    std::size_t last_recorded = chunk_count;
+    bool resuming = read_journal(journal_path, header, done, hashes, last_recorded);
+
+    int out = open(temp_path.c_str(), O_RDWR | O_CREAT | (resuming ? 0 : O_TRUNC), 0600);
+    if (out < 0)
+    {
+        int error = errno;
+        close(in);
+        return status_from_errno(error);
+    }
+
+    int journal = open(journal_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | (resuming ? 0 : O_TRUNC), 0600);
+    if (journal < 0)
+    {
+        int error = errno;
+        close(out);
+        close(in);
+        return status_from_errno(error);
+    }
+
+    std::vector<unsigned char> buffer(memory_governor::shared().scaled(COPY_BUFFER, MIN_COPY_BUFFER));
+    bool copied = ftruncate(out, static_cast<off_t>(size)) == 0;
+
+    if (copied && !resuming)
+    {
+        copied = write_all_bytes(journal, header.data(), header.size()) && fsync(journal) == 0;
+    }
+
+    /*
+        Resume: records were written after fsync() of their chunk and
+        fsync'd themselves, so they are trusted without reading the
+        data back. Only the last one is checked, in case the crash hit
+        while it was being made durable.
+    */
+    if (copied && last_recorded < chunk_count)
+    {
+        std::uint64_t offset = last_recorded * chunk_size;
+        std::uint64_t hash = 0;
+
+        if (!process_chunk(in, out, offset, std::min(chunk_size, size - offset), buffer, true, hash)
+            || hash != hashes[last_recorded])
+        {
+            done[last_recorded] = 0;
+        }
+    }
+
+    for (std::size_t i = 0; copied && i < chunk_count; i++)
+    {
+        if (done[i])
+        {
+            continue;
+        }
+
+        std::uint64_t offset = i * chunk_size;
+        std::uint64_t hash = 0;
+
+        copied = process_chunk(in, out, offset, std::min(chunk_size, size - offset), buffer, false, hash)
+            && fsync(out) == 0;
+
+        if (copied)
+        {
+            std::string record = "C\t" + std::to_string(i) + "\t" + to_hex(hash) + "\n";
+            copied = write_all_bytes(journal, record.data(), record.size()) && fsync(journal) == 0;
+        }
+    }
+
+    // The source must not have changed while it was copied
+    struct stat after;
+    bool unchanged = fstat(in, &after) == 0
+        && after.st_size == source_stat.st_size
+        && after.st_mtime == source_stat.st_mtime;
+
+    source_gone = !unchanged;
+    copied = copied && unchanged;
+
+    close(journal);
+    close(out);
+    close(in);
+
+    return copied ? file_move_status::successful_transfer : file_move_status::unknown_failure;
+}
+
+/*
+    read() until block is full or the file ends; -1 on error.
+*/
+static ssize_t read_block(int fd, unsigned char* block, std::size_t size)
+{
+    std::size_t filled = 0;
+    while (filled < size)
+    {
+        ssize_t n = read(fd, block + filled, size - filled);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0)
+        {
+            return -1;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        filled += static_cast<std::size_t>(n);
+    }
+    return static_cast<ssize_t>(filled);
+}
+
+/*
+    Reads the finished copy back next to its source and compares
+    them byte for byte; hash receives the hash of the content.
+*/
+static bool same_contents(const std::filesystem::path& source_path, const std::filesystem::path& copy_path,
+                          std::uint64_t& hash)
+{
+    int source = open(source_path.c_str(), O_RDONLY | O_CLOEXEC);
+    int copy = open(copy_path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    std::size_t block = memory_governor::shared().scaled(COPY_BUFFER, MIN_COPY_BUFFER);
+    std::vector<unsigned char> source_block(block);
+    std::vector<unsigned char> copy_block(block);
+
+    bool same = source >= 0 && copy >= 0;
+    hash = HASH_SEED;
+
+    while (same)
+    {
+        ssize_t source_bytes = read_block(source, source_block.data(), block);
+        ssize_t copy_bytes = read_block(copy, copy_block.data(), block);
+
+        same = source_bytes >= 0
+            && source_bytes == copy_bytes
+            && std::memcmp(source_block.data(), copy_block.data(), static_cast<std::size_t>(source_bytes)) == 0;
+
+        if (!same || source_bytes == 0)
+        {
+            break;  // Mismatch, or both ended together
+        }
+        hash_block(hash, source_block.data(), static_cast<std::size_t>(source_bytes));
+    }
+
+    if (source >= 0)
+    {
+        close(source);
+    }
+    if (copy >= 0)
+    {
+        close(copy);
+    }
+    return same;
+}
+
+#else
+
+static bool same_contents(const std::filesystem::path& source_path, const std::filesystem::path& copy_path,
+                          std::uint64_t& hash)
+{
+    hash = 0;   // Nothing hashed without POSIX reads
+    std::error_code ec;
+    return std::filesystem::file_size(source_path, ec) == std::filesystem::file_size(copy_path, ec) && !ec;
+}
+
+#endif
+
+
+/*
+    =========================================================
+        resumable_copy
+    =========================================================
+*/
+file_move_status resumable_copy(
+    const std::filesystem::path& source_path,
+    const std::filesystem::path& destination_path,
+    const resumable_copy_policy& policy,
+    std::uint64_t* content_hash
+    )
+{
+    std::error_code ec;
+
+    if (std::filesystem::exists(destination_path, ec))
+    {
+        return file_move_status::destination_exists;    // Never copy over an existing file
+    }
+
+    std::filesystem::path partial_folder = destination_path.parent_path() / PARTIAL_FOLDER_NAME;
+    std::filesystem::path temp_path = partial_folder / source_id(source_path);
+    std::filesystem::path journal_path = temp_path;
+    journal_path += ".journal";
+
+    // Drops this source's temporary copy; the folder goes once it is empty
+    auto discard_temporary = [&]()
+    {
+        std::filesystem::remove(temp_path, ec);
+        std::filesystem::remove(journal_path, ec);
+        std::filesystem::remove(partial_folder, ec);
+    };
+
+    std::uintmax_t size = std::filesystem::file_size(source_path, ec);
+    if (ec)
+    {
+        file_move_status failed = status_from(ec);
+        if (ec == std::errc::no_such_file_or_directory)
+        {
+            discard_temporary();    // Source gone: an earlier partial copy is worthless
+        }
+        return failed;
+    }
+
+    std::filesystem::create_directories(partial_folder, ec);
+    if (ec)
+    {
+        return status_from(ec);
+    }
+
+    file_move_status result;
+
+#if defined(RESUMABLE_COPY_POSIX)
+    if (size >= policy.chunked_threshold)
+    {
+        bool source_gone = false;
+        result = chunked_copy(source_path, temp_path, journal_path, policy, source_gone);
+
+        if (result != file_move_status::successful_transfer && source_gone)
+        {
+            discard_temporary();
+        }
+    }
+    else
+#endif
+    {
+        // Small file: one plain copy, still published under its final name only when complete
+        std::filesystem::remove(journal_path, ec);
+        std::filesystem::copy_file(source_path, temp_path, std::filesystem::copy_options::overwrite_existing, ec);
+        result = ec ? status_from(ec) : file_move_status::successful_transfer;
+
+        if (result != file_move_status::successful_transfer)
+        {
+            std::filesystem::remove(temp_path, ec);
+        }
+    }
+
+    if (result != file_move_status::successful_transfer)
+    {
+        return result;  // Otherwise a chunked copy stays in the partial folder for the next attempt
+    }
+
+    if (policy.verify)
+    {
+        std::uint64_t verified_hash = 0;
+        if (!same_contents(source_path, temp_path, verified_hash))
+        {
+            discard_temporary();    // A bad copy must not be resumed either
+            return file_move_status::unknown_failure;
+        }
+        if (content_hash != nullptr)
+        {
+            *content_hash = verified_hash;
+        }
+    }
+
+    std::filesystem::last_write_time(temp_path, std::filesystem::last_write_time(source_path, ec), ec);
+    std::filesystem::permissions(temp_path, std::filesystem::status(source_path, ec).permissions(), ec);
+
+    result = atomic_transfer_to_path(temp_path, destination_path);
+
+    if (result == file_move_status::successful_transfer)
+    {
+        std::filesystem::remove(journal_path, ec);
+        std::filesystem::remove(partial_folder, ec);    // Only succeeds once it is empty
+    }
+    // Taken name: the caller retries under the next one and reuses the finished copy
+    else if (result != file_move_status::destination_exists)
+    {
+        discard_temporary();
+    }
+    return result;
+}
+
+/*
+    =========================================================
+        sweep_partial_folder
+    =========================================================
+*/
+/*
+    Source, size and modification time recorded in a journal header.
+    False if the journal cannot be read or parsed.
+*/
+static bool read_journal_source(
+    const std::filesystem::path& journal_path,
+    std::filesystem::path& source_path,
+    std::uint64_t& size,
+    std::int64_t& mtime_ns
+    )
+{
+    std::FILE* file = std::fopen(journal_path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    char line[8192];
+    bool has_version = false;
+    bool has_source = false;
+    bool has_size = false;
+    bool has_mtime = false;
+
+    for (int i = 0; i < 5 && std::fgets(line, sizeof(line), file) != nullptr; i++)
+    {
+        std::string text(line);
+        if (!text.empty() && text.back() == '\n')
+        {
+            text.pop_back();
+        }
+
+        if (i == 0)
+        {
+            has_version = (text == JOURNAL_HEADER);
+        }
+        else if (text.compare(0, 7, "source\t") == 0)
+        {
+            source_path = text.substr(7);
+            has_source = true;
+        }
+        else if (text.compare(0, 5, "size\t") == 0)
+        {
+            size = std::strtoull(text.c_str() + 5, nullptr, 10);
+            has_size = true;
+        }
+        else if (text.compare(0, 6, "mtime\t") == 0)
+        {
+            mtime_ns = std::strtoll(text.c_str() + 6, nullptr, 10);
+            has_mtime = true;
+        }
+    }
+    std::fclose(file);
+
+    return has_version && has_source && has_size && has_mtime;
+}
+
+void sweep_partial_folder(const std::filesystem::path& directory)
+{
+    std::error_code ec;
+    std::filesystem::path partial_folder = directory / PARTIAL_FOLDER_NAME;
+
+    std::filesystem::directory_iterator it(partial_folder, ec);
+    if (ec)
+    {
+        return;
+    }
+
+    std::filesystem::file_time_type now = std::filesystem::file_time_type::clock::now();
+    std::vector<std::filesystem::path> stale;
+
+    for (; it != std::filesystem::directory_iterator(); it.increment(ec))
+    {
+        if (ec)
+        {
+            return;
+        }
+
+        const std::filesystem::path& entry = it->path();
+
+        if (entry.extension() == ".journal")
+        {
+            std::filesystem::path source_path;
+            std::uint64_t size = 0;
+            std::int64_t mtime_ns = 0;
+            bool current = false;
+
+            if (read_journal_source(entry, source_path, size, mtime_ns))
+            {
+                std::error_code source_ec;
+                std::uintmax_t source_size = std::filesystem::file_size(source_path, source_ec);
+                std::filesystem::file_time_type source_time = std::filesystem::last_write_time(source_path, source_ec);
+                std::int64_t source_mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::file_clock::to_sys(source_time).time_since_epoch()).count();
+
+                current = !source_ec && source_size == size && source_mtime_ns == mtime_ns;
+            }
+
+            if (!current)
+            {
+                std::filesystem::path temp_path = entry;
+                temp_path.replace_extension();
+                stale.push_back(temp_path);
+                stale.push_back(entry);
+            }
+            continue;
+        }
+
+        // A journaled copy is judged by its journal above
+        std::filesystem::path journal_path = entry;
+        journal_path += ".journal";
+        if (std::filesystem::exists(journal_path, ec))
+        {
+            continue;
+        }
+
+        std::filesystem::file_time_type written = std::filesystem::last_write_time(entry, ec);
+        if (!ec && now - written > STALE_TEMPORARY_AGE)
+        {
+            stale.push_back(entry);
+        }
+    }
+
+    for (const std::filesystem::path& path : stale)
+    {
+        std::filesystem::remove(path, ec);
+    }
+    std::filesystem::remove(partial_folder, ec);     // Only succeeds once it is empty
+}
@@ -0,0 +1,603 @@
+#include "rule_simulator.hpp"
+#include "filesystem_utils.hpp"
+#include "move_hook.hpp"
+#include "scan_batch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <unordered_set>
+
+static const char* MANIFEST_HEADER = "file_organizer_manifest 1";
+
+/*
+    =========================================================
+        capture_tree_manifest
+    =========================================================
+
+    Same walk as organize_directory (explicit stack, hidden folders
+    skipped), recording instead of moving.
+*/
+simulation_status capture_tree_manifest(const std::string& root_path, const std::string& manifest_path)
+{
+    if (validate_path(root_path) != path_status::ok)
+    {
+        return simulation_status::capture_failed;
+    }
+
+    std::ofstream out(manifest_path, std::ios::trunc);
+    if (!out.is_open())
+    {
+        return simulation_status::capture_failed;
+    }
+
+    std::error_code ec;
+    out << MANIFEST_HEADER << '\n';
+    out << "root\t" << std::filesystem::absolute(root_path, ec).string() << '\n';
+
+    // Relative folder paths still to read ("" = root)
+    std::vector<std::string> folders;
+    folders.push_back("");
+    scan_batch batch;
+
+    while (!folders.empty())
+    {
+        std::string relative_folder = folders.back();
+        folders.pop_back();
+
+        directory_scanner scanner;
+        std::filesystem::path folder_path = relative_folder.empty()
+            ? std::filesystem::path(root_path)
+            : std::filesystem::path(root_path) / relative_folder;
+
+        if (scanner.open(folder_path.string()) != scan_status::ok)
+        {
+            continue;   // Unreadable folders are simply not part of the manifest
+        }
+
+        while (scanner.next_batch(batch) == scan_status::ok)
+        {
+            for (std::size_t i = 0; i < batch.size(); i++)
+            {
+                std::string name(batch.name(i));
+
+                // Cannot be represented in a line-based file
+                if (name.find('\n') != std::string::npos)
+                {
+                    continue;
+                }
+
+                std::string relative_path = relative_folder.empty() ? name : relative_folder + "/" + name;
+
+                if (batch.types[i] == scan_entry_type::regular_file)
+                {
+                    out << "F\t" << batch.sizes[i] << '\t' << relative_path << '\n';
+                }
+                else if (batch.types[i] == scan_entry_type::directory && name[0] != '.')
+                {
+                    out << "D\t" << relative_path << '\n';
+                    folders.push_back(relative_path);
+                }
+            }
+        }
+    }
+
+    out.flush();
+    return out ? simulation_status::ok : simulation_status::capture_failed;
+}
+
+/*
+    =========================================================
+        load_rule_file / save_rule_file
+    =========================================================
+*/
+simulation_status load_rule_file(const std::string& rules_path, std::map<std::string, std::string>& extension_lookup)
+{
+    extension_lookup.clear();
+
+    std::ifstream in(rules_path);
+    if (!in.is_open())
+    {
+        return simulation_status::rules_not_found;
+    }
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::size_t tab = line.find('\t');
+        if (tab == std::string::npos || tab == 0 || tab + 1 >= line.size())
+        {
+            extension_lookup.clear();
+            return simulation_status::rules_corrupt;
+        }
+
+        std::string extension = line.substr(0, tab);
+        if (extension[0] == '.')
+        {
+            extension.erase(0, 1);
+        }
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+        extension_lookup[extension] = line.substr(tab + 1);
+    }
+
+    return simulation_status::ok;
+}
+
+simulation_status save_rule_file(const std::string& rules_path, const std::map<std::string, std::string>& extension_lookup)
+{
+    std::ofstream out(rules_path, std::ios::trunc);
+    if (!out.is_open())
+    {
+        return simulation_status::write_failed;
+    }
+
+    out << "# extension<TAB>category\n";
+    for (const std::pair<const std::string, std::string>& rule : extension_lookup)
+    {
+        out << rule.first << '\t' << rule.second << '\n';
+    }
+
+    out.flush();
+    return out ? simulation_status::ok : simulation_status::write_failed;
+}
+
+/*
+    =========================================================
+        In-memory tree
+    =========================================================
+*/
+namespace
+{
+struct recorded_tree
+{
+    std::string root;
+    std::vector<std::string> folder_paths;
+    std::vector<std::string> file_paths;        // Index = file id
+    std::vector<std::uint64_t> file_sizes;
+};
+
+struct sim_file
+{
+    std::string name;
+    std::uint32_t id;
+};
+
+struct sim_folder
+{
+    std::map<std::string, std::unique_ptr<sim_folder>> subfolders;
+    std::vector<sim_file> files;                // Files recorded here (moves in are not added)
+    std::unordered_set<std::string> taken;      // Every name currently in the folder
+    bool created = false;                       // Created by the replay
+    std::size_t sequence = 0;                   // Listing order (= manifest order)
+};
+
+/*
+    What one replay did to every recorded file.
+*/
+struct replay_outcome
+{
+    std::vector<std::string> final_paths;       // By file id, relative to the root
+    std::vector<char> numbered;                 // Got a "name(n).ext" name
+    std::set<std::string> created_folders;
+    std::size_t moves = 0;
+};
+}
+
+static simulation_status load_manifest(const std::string& manifest_path, recorded_tree& tree)
+{
+    std::ifstream in(manifest_path);
+    if (!in.is_open())
+    {
+        return simulation_status::manifest_not_found;
+    }
+
+    std::string line;
+    if (!std::getline(in, line) || line != MANIFEST_HEADER
+        || !std::getline(in, line) || line.compare(0, 5, "root\t") != 0)
+    {
+        return simulation_status::manifest_corrupt;
+    }
+    tree.root = line.substr(5);
+
+    while (std::getline(in, line))
+    {
+        if (line.size() > 2 && line[0] == 'D' && line[1] == '\t')
+        {
+            tree.folder_paths.push_back(line.substr(2));
+        }
+        else if (line.size() > 2 && line[0] == 'F' && line[1] == '\t')
+        {
+            std::size_t tab = line.find('\t', 2);
+            if (tab == std::string::npos)
+            {
+                return simulation_status::manifest_corrupt;
+            }
+            tree.file_sizes.push_back(std::strtoull(line.c_str() + 2, nullptr, 10));
+            tree.file_paths.push_back(line.substr(tab + 1));
+        }
+        else if (!line.empty())
+        {
+            return simulation_status::manifest_corrupt;
+        }
+    }
+    return simulation_status::ok;
+}
+
+/*
+    Walks (and optionally creates) the folders of a '/'-separated
+    relative path. Returns nullptr if a folder is missing and
+    create_missing is false.
+*/
+static sim_folder* find_folder(
+    sim_folder& root,
+    const std::string& relative_path,
+    bool create_missing,
+    std::set<std::string>* created_folders
+    )
+{
+    sim_folder* folder = &root;
+    std::size_t start = 0;
+
+    while (start < relative_path.size())
+    {
+        std::size_t end = relative_path.find('/', start);
+        if (end == std::string::npos)
+        {
+            end = relative_path.size();
+        }
+
+        std::string name = relative_path.substr(start, end - start);
+        std::map<std::string, std::unique_ptr<sim_folder>>::iterator it = folder->subfolders.find(name);
+
+        if (it == folder->subfolders.end())
+        {
+            if (!create_missing)
+            {
+                return nullptr;
+            }
+
+            std::unique_ptr<sim_folder> child = std::make_unique<sim_folder>();
+            child->created = (created_folders != nullptr);
+            child->sequence = folder->subfolders.size();
+            if (created_folders != nullptr)
+            {
+                created_folders->insert(relative_path.substr(0, end));
+            }
+
+            folder->taken.insert(name);
+            it = folder->subfolders.emplace(name, std::move(child)).first;
+        }
+
+        folder = it->second.get();
+        start = end + 1;
+    }
+    return folder;
+}
+
+static std::unique_ptr<sim_folder> build_tree(const recorded_tree& tree)
+{
+    std::unique_ptr<sim_folder> root = std::make_unique<sim_folder>();
+
+    for (const std::string& folder_path : tree.folder_paths)
+    {
+        find_folder(*root, folder_path, true, nullptr);
+    }
+
+    for (std::uint32_t id = 0; id < tree.file_paths.size(); id++)
+    {
+        const std::string& file_path = tree.file_paths[id];
+        std::size_t slash = file_path.rfind('/');
+
+        sim_folder* folder = slash == std::string::npos
+            ? root.get()
+            : find_folder(*root, file_path.substr(0, slash), true, nullptr);
+
+        std::string name = slash == std::string::npos ? file_path : file_path.substr(slash + 1);
+        folder->taken.insert(name);
+        folder->files.push_back({ name, id });
+    }
+    return root;
+}
+
+/*
+    Subfolders in listing order: the disk walk and the alias
+    normalization both see folders in readdir order, not sorted.
+*/
+static std::vector<std::pair<std::string, sim_folder*>> listed_subfolders(sim_folder& folder)
+{
+    std::vector<std::pair<std::string, sim_folder*>> listed;
+    listed.reserve(folder.subfolders.size());
+
+    for (std::pair<const std::string, std::unique_ptr<sim_folder>>& subfolder : folder.subfolders)
+    {
+        listed.emplace_back(subfolder.first, subfolder.second.get());
+    }
+
+    std::sort(listed.begin(), listed.end(),
+        [](const std::pair<std::string, sim_folder*>& a, const std::pair<std::string, sim_folder*>& b)
+        {
+            return a.second->sequence < b.second->sequence;
+        });
+    return listed;
+}
+
+/*
+    In-memory normalize_category_folder: first alias folder of each
+    category is renamed, unless the category folder already exists
+    (rename() onto a non-empty folder fails on disk, too).
+*/
+static void normalize_aliases(sim_folder& folder, const rule_table& rules)
+{
+    std::map<std::string, std::string> first_alias;     // canonical → alias folder name
+
+    for (const std::pair<std::string, sim_folder*>& subfolder : listed_subfolders(folder))
+    {
+        if (rules.category_names.find(subfolder.first) != rules.category_names.end())
+        {
+            continue;
+        }
+
+        std::string lowercase_name = subfolder.first;
+        std::transform(lowercase_name.begin(), lowercase_name.end(), lowercase_name.begin(), ::tolower);
+
+        std::map<std::string, std::string>::const_iterator alias = ALIAS_LOOKUP.find(lowercase_name);
+        if (alias != ALIAS_LOOKUP.end() && first_alias.find(alias->second) == first_alias.end())
+        {
+            first_alias[alias->second] = subfolder.first;
+        }
+    }
+
+    for (const std::pair<const std::string, std::string>& rename : first_alias)
+    {
+        if (folder.subfolders.find(rename.first) != folder.subfolders.end())
+        {
+            continue;
+        }
+
+        folder.subfolders[rename.first] = std::move(folder.subfolders[rename.second]);
+        folder.subfolders.erase(rename.second);
+        folder.taken.erase(rename.second);
+        folder.taken.insert(rename.first);
+    }
+}
+
+/*
+    get_unique_path against the in-memory folder.
+*/
+static std::string claim_name(sim_folder& folder, const std::string& filename, bool& numbered)
+{
+    numbered = false;
+    if (folder.taken.insert(filename).second)
+    {
+        return filename;
+    }
+
+    std::filesystem::path temp_path(filename);
+    std::string stem = temp_path.stem().string();
+    std::string extension = temp_path.extension().string();
+
+    for (int counter = 1; ; counter++)
+    {
+        std::string candidate = stem + "(" + std::to_string(counter) + ")" + extension;
+        if (folder.taken.insert(candidate).second)
+        {
+            numbered = true;
+            return candidate;
+        }
+    }
+}
+
+/*
+    Relative form of an absolute path produced by plan_placement.
+*/
+static std::string relative_to_root(const std::string& root, const std::string& path)
+{
+    std::string relative = std::filesystem::path(path).lexically_relative(root).generic_string();
+    return relative == "." ? std::string() : relative;
+}
+
+/*
+    =========================================================
+        replay
+    =========================================================
+
+    One organize run over the in-memory tree, in the same order
+    as organize_directory walks the disk.
+*/
+static replay_outcome replay(const recorded_tree& tree, const rule_table& rules, const organize_options& options)
+{
+    replay_outcome outcome;
+    outcome.final_paths.resize(tree.file_paths.size());
+    outcome.numbered.assign(tree.file_paths.size(), 0);
+
+    std::unique_ptr<sim_folder> root = build_tree(tree);
+
+    organize_options replay_options = options;
+    replay_options.shards = nullptr;
+    replay_options.metrics = nullptr;
+    replay_options.hooks = nullptr;
+
+    struct pending_folder
+    {
+        sim_folder* folder;
+        std::string path;           // As the walk builds it
+        std::string relative_path;
+    };
+
+    std::vector<pending_folder> folders;
+    folders.push_back({ root.get(), tree.root, std::string() });
+
+    planned_move move;
+
+    while (!folders.empty())
+    {
+        pending_folder current = std::move(folders.back());
+        folders.pop_back();
+
+        normalize_aliases(*current.folder, rules);
+
+        for (const sim_file& file : current.folder->files)
+        {
+            organize_status s = plan_placement(current.path, file.name, replay_options, rules, move);
+
+            if (s != organize_status::success)
+            {
+                outcome.final_paths[file.id] = current.relative_path.empty()
+                    ? file.name
+                    : current.relative_path + "/" + file.name;
+                continue;
+            }
+
+            std::string destination_relative = relative_to_root(tree.root, move.destination_directory);
+            sim_folder* destination = find_folder(*root, destination_relative, true, &outcome.created_folders);
+
+            bool numbered = false;
+            std::string final_name = claim_name(*destination, move.target_filename, numbered);
+            current.folder->taken.erase(file.name);
+
+            outcome.final_paths[file.id] = destination_relative.empty()
+                ? final_name
+                : destination_relative + "/" + final_name;
+            outcome.numbered[file.id] = numbered ? 1 : 0;
+            outcome.moves++;
+        }
+
+        // Folders created by this replay only hold moved files: nothing to visit
+        for (const std::pair<std::string, sim_folder*>& subfolder : listed_subfolders(*current.folder))
+        {
+            if (subfolder.second->created || subfolder.first.empty() || subfolder.first[0] == '.')
+            {
+                continue;
+            }
+
+            folders.push_back({
+                subfolder.second,
+                (std::filesystem::path(current.path) / subfolder.first).string(),
+                current.relative_path.empty() ? subfolder.first : current.relative_path + "/" + subfolder.first
+            });
+        }
+    }
+
+    return outcome;
+}
+
+/*
+    =========================================================
+        simulate_rules
+    =========================================================
+*/
+simulation_status simulate_rules(
+    const std::string& manifest_path,
+    const rule_table& candidate_rules,
+    const organize_options& options,
+    simulation_report& report
+    )
+{
+    report = simulation_report();
+
+    recorded_tree tree;
+    simulation_status loaded = load_manifest(manifest_path, tree);
+    if (loaded != simulation_status::ok)
+    {
+        return loaded;
+    }
+
+    report.files = tree.file_paths.size();
+    report.folders = tree.folder_paths.size();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    replay_outcome current = replay(tree, builtin_rule_table(), options);
+    replay_outcome candidate = replay(tree, candidate_rules, options);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (seconds > 0)
+    {
+        report.entries_per_second = 2.0 * static_cast<double>(report.files + report.folders) / seconds;
+    }
+
+    report.moves_current = current.moves;
+    report.moves_candidate = candidate.moves;
+
+    for (std::size_t id = 0; id < tree.file_paths.size(); id++)
+    {
+        if (current.final_paths[id] != candidate.final_paths[id])
+        {
+            report.destination_changes++;
+            report.bytes_changing_place += tree.file_sizes[id];
+            report.changes.push_back({ change_kind::destination_changed, tree.file_paths[id],
+                                       current.final_paths[id], candidate.final_paths[id] });
+        }
+
+        if (candidate.numbered[id] && !current.numbered[id])
+        {
+            report.new_collisions++;
+            report.changes.push_back({ change_kind::new_collision, tree.file_paths[id],
+                                       current.final_paths[id], candidate.final_paths[id] });
+        }
+    }
+
+    for (const std::string& folder : candidate.created_folders)
+    {
+        if (current.created_folders.find(folder) == current.created_folders.end())
+        {
+            report.new_folders++;
+            report.changes.push_back({ change_kind::new_folder, folder, std::string(), folder });
+        }
+    }
+
+    return simulation_status::ok;
+}
+
+/*
+    =========================================================
+        write_simulation_report
+    =========================================================
+*/
+simulation_status write_simulation_report(const simulation_report& report, const std::string& report_path)
+{
+    std::ofstream out(report_path, std::ios::trunc);
+    if (!out.is_open())
+    {
+        return simulation_status::write_failed;
+    }
+
+    std::string line;
+    for (const outcome_change& change : report.changes)
+    {
+        line.clear();
+        line += "{\"change\":";
+        switch (change.kind)
+        {
+        case change_kind::destination_changed: line += "\"destination_changed\""; break;
+        case change_kind::new_collision:       line += "\"new_collision\"";       break;
+        case change_kind::new_folder:          line += "\"new_folder\"";          break;
+        }
+
+        line += ",\"file\":";
+        append_json_string(line, change.file);
+        line += ",\"current\":";
+        append_json_string(line, change.current_destination);
+        line += ",\"candidate\":";
+        append_json_string(line, change.candidate_destination);
+        line += "}\n";
+
+        out << line;
+    }
+
+    out.flush();
+    return out ? simulation_status::ok : simulation_status::write_failed;
+}
@@ -0,0 +1,400 @@
+#include "run_estimator.hpp"
+#include "extensions.hpp"
+#include "filesystem_utils.hpp"
+#include "scan_batch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RUN_ESTIMATOR_POSIX 1
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+/*
+    Quantities summed per folder and per probe.
+*/
+enum quantity
+{
+    entries_quantity,
+    files_quantity,
+    moves_quantity,
+    move_bytes_quantity,
+    cross_device_files_quantity,
+    cross_device_bytes_quantity,
+    quantity_count
+};
+
+using quantities = std::array<double, quantity_count>;
+
+/*
+    Everything a probe needs from one folder, read once.
+*/
+struct folder_sample
+{
+    quantities counts{};
+    bool subsampled = false;                // Only part of the files were classified
+    std::vector<std::string> subfolders;    // Full paths, hidden folders excluded
+};
+
+/*
+    Device of the nearest existing ancestor of a path (destination
+    folders usually do not exist yet). Cached per path.
+*/
+class device_lookup
+{
+public:
+    bool same_device(const std::string& source_folder, const std::string& destination_folder)
+    {
+        std::uint64_t source_device = 0;
+        std::uint64_t destination_device = 0;
+
+        if (!device_of(source_folder, source_device) || !device_of(destination_folder, destination_device))
+        {
+            return true;    // Unknown: assume a plain rename
+        }
+        return source_device == destination_device;
+    }
+
+private:
+    bool device_of(const std::string& path, std::uint64_t& device)
+    {
+        std::unordered_map<std::string, std::uint64_t>::const_iterator known = devices.find(path);
+        if (known != devices.end())
+        {
+            device = known->second;
+            return true;
+        }
+
+#if defined(RUN_ESTIMATOR_POSIX)
+        std::filesystem::path probe = path;
+        struct stat st;
+
+        while (stat(probe.c_str(), &st) != 0)
+        {
+            if (!probe.has_relative_path())
+            {
+                return false;
+            }
+            probe = probe.parent_path();
+        }
+
+        device = static_cast<std::uint64_t>(st.st_dev);
+        devices.emplace(path, device);
+        return true;
+#else
+        // std::filesystem has no device id
+        (void)path;
+        (void)device;
+        return false;
+#endif
+    }
+
+    std::unordered_map<std::string, std::uint64_t> devices;
+};
+}
+
+/*
+    =========================================================
+        read_folder
+    =========================================================
+
+    Reads one folder and runs the placement decision on its files
+    (at most policy.max_files_classified of them, picked at random,
+    with the counts scaled back up).
+*/
+static scan_status read_folder(
+    const std::string& folder_path,
+    const organize_options& options,
+    const estimate_policy& policy,
+    std::mt19937_64& random,
+    device_lookup& devices,
+    folder_sample& sample
+    )
+{
+    directory_scanner scanner;
+    scan_status status = scanner.open(folder_path);
+
+    if (status != scan_status::ok)
+    {
+        return status;
+    }
+
+    std::vector<std::string> file_names;
+    std::vector<std::uint64_t> file_sizes;
+    scan_batch batch;
+
+    while (scanner.next_batch(batch) == scan_status::ok)
+    {
+        sample.counts[entries_quantity] += static_cast<double>(batch.size());
+
+        for (std::size_t i = 0; i < batch.size(); i++)
+        {
+            std::string_view name = batch.name(i);
+
+            if (batch.types[i] == scan_entry_type::regular_file)
+            {
+                file_names.emplace_back(name);
+                file_sizes.push_back(batch.sizes[i]);
+            }
+            else if (batch.types[i] == scan_entry_type::directory && name[0] != '.')
+            {
+                sample.subfolders.push_back((std::filesystem::path(folder_path) / name).string());
+            }
+        }
+    }
+
+    std::size_t file_count = file_names.size();
+    sample.counts[files_quantity] = static_cast<double>(file_count);
+
+    // Partial Fisher-Yates: the first `classified` indices are a uniform random subset
+    std::vector<std::size_t> order(file_count);
+    for (std::size_t i = 0; i < file_count; i++)
+    {
+        order[i] = i;
+    }
+
+    std::size_t classified = std::min(file_count, std::max<std::size_t>(1, policy.max_files_classified));
+    if (classified < file_count)
+    {
+        sample.subsampled = true;
+        for (std::size_t i = 0; i < classified; i++)
+        {
+            std::uniform_int_distribution<std::size_t> pick(i, file_count - 1);
+            std::swap(order[i], order[pick(random)]);
+        }
+    }
+
+    const rule_table& rules = builtin_rule_table();
+    double scale = classified == 0 ? 0.0 : static_cast<double>(file_count) / static_cast<double>(classified);
+
+    for (std::size_t i = 0; i < classified; i++)
+    {
+        std::size_t file = order[i];
+        planned_move move;
+
+        if (plan_placement(folder_path, file_names[file], options, rules, move) != organize_status::success)
+        {
+            continue;
+        }
+
+        double bytes = static_cast<double>(file_sizes[file]);
+        sample.counts[moves_quantity] += scale;
+        sample.counts[move_bytes_quantity] += bytes * scale;
+
+        if (!devices.same_device(folder_path, move.destination_directory))
+        {
+            sample.counts[cross_device_files_quantity] += scale;
+            sample.counts[cross_device_bytes_quantity] += bytes * scale;
+        }
+    }
+
+    return scan_status::ok;
+}
+
+/*
+    Seconds the counted work takes under the cost model.
+*/
+static double predicted_seconds(const quantities& counts, double seconds_per_entry, const estimate_policy& policy)
+{
+    double renames = counts[moves_quantity] - counts[cross_device_files_quantity];
+    double copy_rate = policy.copy_bytes_per_second > 0 ? policy.copy_bytes_per_second : 1.0;
+
+    return counts[entries_quantity] * seconds_per_entry
+        + renames * policy.seconds_per_rename
+        + counts[cross_device_files_quantity] * policy.seconds_per_rename
+        + counts[cross_device_bytes_quantity] / copy_rate;
+}
+
+/*
+    =========================================================
+        estimate_run
+    =========================================================
+*/
+run_estimate estimate_run(
+    const std::string& root_path,
+    const organize_options& options,
+    const estimate_policy& policy
+    )
+{
+    run_estimate estimate;
+
+    if (validate_path(root_path) != path_status::ok)
+    {
+        estimate.status = estimate_status::path_not_found;
+        return estimate;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Placement decision only: no shard registry, metrics or hooks
+    organize_options planning_options = options;
+    planning_options.metrics = nullptr;
+    planning_options.shards = nullptr;
+    planning_options.hooks = nullptr;
+
+    std::mt19937_64 random(policy.seed != 0 ? policy.seed : std::random_device()());
+    device_lookup devices;
+
+    // Folders read so far; unreadable folders are cached as empty
+    std::unordered_map<std::string, folder_sample> folders;
+
+    std::vector<quantities> probe_totals;
+    unsigned probe_limit = std::max(2u, policy.probes);
+
+    /*
+        PHASE 1: random descents
+
+        The root is always read; a probe never stops halfway, so the
+        folder budget may be exceeded by the depth of one probe.
+    */
+    for (unsigned probe = 0; probe < probe_limit; probe++)
+    {
+        if (probe >= 2 && folders.size() >= policy.max_directories)
+        {
+            break;
+        }
+
+        quantities totals{};
+        double weight = 1.0;
+        std::string current = root_path;
+
+        while (true)
+        {
+            std::unordered_map<std::string, folder_sample>::iterator known = folders.find(current);
+
+            if (known == folders.end())
+            {
+                folder_sample sample;
+                scan_status status = read_folder(current, planning_options, policy, random, devices, sample);
+
+                if (status != scan_status::ok && current == root_path)
+                {
+                    estimate.status = estimate_status::permission_denied;
+                    return estimate;
+                }
+
+                known = folders.emplace(current, std::move(sample)).first;
+            }
+
+            const folder_sample& sample = known->second;
+
+            for (std::size_t q = 0; q < quantity_count; q++)
+            {
+                totals[q] += sample.counts[q] * weight;
+            }
+
+            if (sample.subfolders.empty())
+            {
+                break;
+            }
+
+            std::uniform_int_distribution<std::size_t> pick(0, sample.subfolders.size() - 1);
+            weight *= static_cast<double>(sample.subfolders.size());
+            current = sample.subfolders[pick(random)];
+        }
+
+        probe_totals.push_back(totals);
+    }
+
+    estimate.probes = static_cast<unsigned>(probe_totals.size());
+    estimate.directories_read = folders.size();
+
+    /*
+        PHASE 2: what the sample saw for certain, and whether
+        it saw everything (every reachable folder was read)
+    */
+    quantities observed{};
+    bool complete = true;
+    bool subsampled = false;
+
+    for (const std::pair<const std::string, folder_sample>& folder : folders)
+    {
+        for (std::size_t q = 0; q < quantity_count; q++)
+        {
+            observed[q] += folder.second.counts[q];
+        }
+
+        subsampled = subsampled || folder.second.subsampled;
+
+        for (const std::string& subfolder : folder.second.subfolders)
+        {
+            if (folders.find(subfolder) == folders.end())
+            {
+                complete = false;
+            }
+        }
+    }
+
+    estimate.entries_read = static_cast<std::size_t>(observed[entries_quantity]);
+    estimate.exact = complete && !subsampled;
+
+    estimate.sampling_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // A real run reads and classifies every entry at least as fast as the sample did
+    double seconds_per_entry = observed[entries_quantity] > 0
+        ? estimate.sampling_seconds / observed[entries_quantity]
+        : 0.0;
+
+    /*
+        PHASE 3: mean and confidence interval per quantity
+        (the duration is computed per probe, so it gets its own spread)
+    */
+    double probe_count = static_cast<double>(probe_totals.size());
+
+    auto summarize = [&](auto value_of, double seen) -> estimate_interval
+    {
+        estimate_interval interval;
+
+        if (complete)
+        {
+            interval.value = interval.low = interval.high = seen;
+            return interval;
+        }
+
+        double sum = 0;
+        for (const quantities& totals : probe_totals)
+        {
+            sum += value_of(totals);
+        }
+        double mean = sum / probe_count;
+
+        double squares = 0;
+        for (const quantities& totals : probe_totals)
+        {
+            double delta = value_of(totals) - mean;
+            squares += delta * delta;
+        }
+        double standard_error = std::sqrt(squares / (probe_count - 1) / probe_count);
+
+        interval.value = std::max(mean, seen);
+        interval.low = std::max(mean - policy.confidence_z * standard_error, seen);
+        interval.high = std::max(mean + policy.confidence_z * standard_error, interval.value);
+        return interval;
+    };
+
+    auto quantity_of = [](quantity q)
+    {
+        return [q](const quantities& totals) { return totals[q]; };
+    };
+
+    estimate.entries = summarize(quantity_of(entries_quantity), observed[entries_quantity]);
+    estimate.files = summarize(quantity_of(files_quantity), observed[files_quantity]);
+    estimate.files_to_move = summarize(quantity_of(moves_quantity), observed[moves_quantity]);
+    estimate.bytes_to_move = summarize(quantity_of(move_bytes_quantity), observed[move_bytes_quantity]);
+    estimate.cross_device_bytes = summarize(quantity_of(cross_device_bytes_quantity), observed[cross_device_bytes_quantity]);
+    estimate.seconds = summarize(
+        [&](const quantities& totals) { return predicted_seconds(totals, seconds_per_entry, policy); },
+        complete ? predicted_seconds(observed, seconds_per_entry, policy) : 0.0
+        );
+
+    return estimate;
+}
@@ -0,0 +1,432 @@
+#include "run_metrics.hpp"
+#include "directory_index.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+    =========================================================
+        Names used in the JSON report
+    =========================================================
+*/
+static const char* PHASE_NAMES[] = {
+    "none", "scan", "normalize", "classify", "transfer", "index"
+};
+
+static const char* COUNTER_NAMES[] = {
+    "cycles", "instructions", "cache_misses", "branch_misses"
+};
+
+static constexpr std::size_t COUNTER_COUNT = static_cast<std::size_t>(hardware_counter::counter_count);
+
+
+#ifdef __linux__
+/*
+    =========================================================
+        open_counter
+    =========================================================
+
+    Opens one user-space-only hardware counter for the calling thread.
+    The group leader starts disabled; members follow the leader.
+*/
+static int open_counter(std::uint64_t config, int group_fd)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (group_fd == -1) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP
+                     | PERF_FORMAT_TOTAL_TIME_ENABLED
+                     | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // pid = 0, cpu = -1: this thread, on whatever CPU it runs
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+/*
+    Human readable explanation for a failed perf_event_open.
+*/
+static std::string describe_open_failure(int error)
+{
+    if (error == EACCES || error == EPERM)
+    {
+        std::string paranoid_level = "unknown";
+        std::ifstream paranoid("/proc/sys/kernel/perf_event_paranoid");
+        if (paranoid.is_open())
+        {
+            paranoid >> paranoid_level;
+        }
+        return "access denied (kernel.perf_event_paranoid = " + paranoid_level + ")";
+    }
+    if (error == ENOENT || error == ENODEV || error == EOPNOTSUPP)
+    {
+        return "no hardware PMU available";
+    }
+    if (error == ENOSYS)
+    {
+        return "perf_event_open not supported by this kernel";
+    }
+    return std::string("perf_event_open failed: ") + std::strerror(error);
+}
+#endif
+
+
+/*
+    =========================================================
+        run_metrics::run_metrics
+    =========================================================
+*/
+run_metrics::run_metrics(bool use_hardware_counters)
+{
+    counter_fds.fill(-1);
+    counter_slots.fill(-1);
+
+    if (!use_hardware_counters)
+    {
+        unavailable_reason = "disabled";
+    }
+    else
+    {
+#ifdef __linux__
+        static const std::uint64_t CONFIGS[] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        for (std::size_t i = 0; i < COUNTER_COUNT; i++)
+        {
+            int fd = open_counter(CONFIGS[i], group_leader);
+
+            if (fd == -1)
+            {
+                // Without a leader nothing else can be grouped
+                if (group_leader == -1)
+                {
+                    unavailable_reason = describe_open_failure(errno);
+                    break;
+                }
+                // A single unsupported member is simply left out
+                continue;
+            }
+
+            if (group_leader == -1)
+            {
+                group_leader = fd;
+            }
+            counter_fds[i] = fd;
+            counter_slots[i] = opened_counters;
+            opened_counters++;
+        }
+
+        if (group_leader != -1)
+        {
+            ioctl(group_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(group_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#else
+        unavailable_reason = "not supported on this platform";
+#endif
+    }
+
+    run_start = std::chrono::steady_clock::now();
+    last_time = run_start;
+    read_counters(last_sample);
+}
+
+/*
+    =========================================================
+        run_metrics::~run_metrics
+    =========================================================
+*/
+run_metrics::~run_metrics()
+{
+#ifdef __linux__
+    // Members first, the leader last
+    for (std::size_t i = COUNTER_COUNT; i-- > 0;)
+    {
+        if (counter_fds[i] != -1)
+        {
+            close(counter_fds[i]);
+        }
+    }
+#endif
+}
+
+bool run_metrics::hardware_counters_available() const
+{
+    return group_leader != -1;
+}
+
+/*
+    =========================================================
+        run_metrics::read_counters
+    =========================================================
+
+    One read() returns the whole group, so all counters of a
+    sample are taken at the same instant.
+*/
+bool run_metrics::read_counters(counter_sample& sample) const
+{
+#ifdef __linux__
+    if (group_leader == -1)
+    {
+        return false;
+    }
+
+    // Layout of a PERF_FORMAT_GROUP read with both time fields
+    std::uint64_t buffer[3 + COUNTER_COUNT] = {};
+    ssize_t bytes = read(group_leader, buffer, sizeof(buffer));
+    if (bytes < static_cast<ssize_t>(3 * sizeof(std::uint64_t)))
+    {
+        return false;
+    }
+
+    sample.time_enabled = buffer[1];
+    sample.time_running = buffer[2];
+    for (std::size_t i = 0; i < COUNTER_COUNT; i++)
+    {
+        if (counter_slots[i] != -1)
+        {
+            sample.values[i] = buffer[3 + counter_slots[i]];
+        }
+    }
+    return true;
+#else
+    (void)sample;
+    return false;
+#endif
+}
+
+/*
+    =========================================================
+        run_metrics::enter_phase
+    =========================================================
+*/
+void run_metrics::enter_phase(run_phase next_phase)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    std::uint64_t elapsed = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_time).count());
+    totals[static_cast<std::size_t>(current_phase)].wall_ns += elapsed;
+    unsampled_wall_ns[static_cast<std::size_t>(current_phase)] += elapsed;
+
+    last_time = now;
+    current_phase = next_phase;
+    totals[static_cast<std::size_t>(next_phase)].entries++;
+
+    // End of the run: nothing may stay unattributed
+    if (next_phase == run_phase::none)
+    {
+        sample_counters();
+    }
+}
+
+/*
+    =========================================================
+        run_metrics::sample_counters
+    =========================================================
+*/
+void run_metrics::sample_counters()
+{
+    // Close the running interval without leaving the phase
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::uint64_t elapsed = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_time).count());
+    totals[static_cast<std::size_t>(current_phase)].wall_ns += elapsed;
+    unsampled_wall_ns[static_cast<std::size_t>(current_phase)] += elapsed;
+    last_time = now;
+
+    counter_sample sample;
+    if (!read_counters(sample))
+    {
+        unsampled_wall_ns.fill(0);
+        return;
+    }
+
+    std::uint64_t interval_ns = 0;
+    for (std::uint64_t wall_ns : unsampled_wall_ns)
+    {
+        interval_ns += wall_ns;
+    }
+
+    std::uint64_t enabled = sample.time_enabled - last_sample.time_enabled;
+    std::uint64_t running = sample.time_running - last_sample.time_running;
+
+    for (std::size_t i = 0; i < COUNTER_COUNT; i++)
+    {
+        double delta = static_cast<double>(sample.values[i] - last_sample.values[i]);
+
+        // Scale up if the kernel multiplexed the group
+        if (running != 0 && running < enabled)
+        {
+            delta = delta * static_cast<double>(enabled) / static_cast<double>(running);
+        }
+
+        for (std::size_t p = 0; p < totals.size() && interval_ns > 0; p++)
+        {
+            double share = static_cast<double>(unsampled_wall_ns[p]) / static_cast<double>(interval_ns);
+            totals[p].counters[i] += static_cast<std::uint64_t>(delta * share);
+        }
+    }
+
+    last_sample = sample;
+    unsampled_wall_ns.fill(0);
+}
+
+void run_metrics::set_unmeasured_worker_threads(unsigned threads)
+{
+    unmeasured_worker_threads = threads;
+}
+
+/*
+    =========================================================
+        run_metrics::record_hook_call
+    =========================================================
+*/
+void run_metrics::record_hook_call(std::chrono::nanoseconds latency, std::size_t files, bool succeeded)
+{
+    std::uint64_t latency_ns = static_cast<std::uint64_t>(latency.count());
+
+    std::lock_guard<std::mutex> lock(hook_mutex);
+    hooks.calls++;
+    hooks.files += files;
+    hooks.total_ns += latency_ns;
+    if (latency_ns > hooks.max_ns)
+    {
+        hooks.max_ns = latency_ns;
+    }
+    if (!succeeded)
+    {
+        hooks.failures++;
+    }
+}
+
+void run_metrics::add_scanned_entries(std::size_t count)
+{
+    scanned_entries += count;
+}
+
+/*
+    =========================================================
+        run_metrics::to_json
+    =========================================================
+*/
+std::string run_metrics::to_json() const
+{
+    std::ostringstream out;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double total_ms = std::chrono::duration<double, std::milli>(now - run_start).count();
+
+    out << "{\n";
+    out << "  \"total_wall_ms\": " << total_ms << ",\n";
+    out << "  \"scanned_entries\": " << scanned_entries << ",\n";
+
+    out << "  \"hardware_counters\": { \"available\": "
+        << (hardware_counters_available() ? "true" : "false");
+    if (!hardware_counters_available())
+    {
+        // Reasons are built from fixed strings and numbers, no escaping needed
+        out << ", \"reason\": \"" << unavailable_reason << "\"";
+    }
+    out << " },\n";
+
+    if (unmeasured_worker_threads > 0)
+    {
+        out << "  \"workers\": { \"threads\": " << unmeasured_worker_threads
+            << ", \"hardware_counters\": false },\n";
+    }
+
+    out << "  \"phases\": {";
+
+    bool first_phase = true;
+    for (std::size_t p = 1; p < totals.size(); p++)
+    {
+        const phase_totals& phase = totals[p];
+
+        out << (first_phase ? "\n" : ",\n");
+        first_phase = false;
+
+        out << "    \"" << PHASE_NAMES[p] << "\": { "
+            << "\"wall_ms\": " << static_cast<double>(phase.wall_ns) / 1e6
+            << ", \"entries\": " << phase.entries;
+
+        for (std::size_t i = 0; i < COUNTER_COUNT; i++)
+        {
+            if (counter_slots[i] != -1)
+            {
+                out << ", \"" << COUNTER_NAMES[i] << "\": " << phase.counters[i];
+            }
+        }
+
+        std::size_t cache_misses = static_cast<std::size_t>(hardware_counter::cache_misses);
+        if (counter_slots[cache_misses] != -1 && scanned_entries > 0)
+        {
+            out << ", \"cache_misses_per_entry\": "
+                << static_cast<double>(phase.counters[cache_misses]) / static_cast<double>(scanned_entries);
+        }
+        out << " }";
+    }
+
+    out << "\n  }";
+
+    std::lock_guard<std::mutex> lock(hook_mutex);
+    if (hooks.calls > 0)
+    {
+        out << ",\n  \"hooks\": { "
+            << "\"calls\": " << hooks.calls
+            << ", \"files\": " << hooks.files
+            << ", \"failures\": " << hooks.failures
+            << ", \"mean_ms\": " << static_cast<double>(hooks.total_ns) / 1e6 / static_cast<double>(hooks.calls)
+            << ", \"max_ms\": " << static_cast<double>(hooks.max_ns) / 1e6
+            << " }";
+    }
+
+    out << "\n}\n";
+
+    return out.str();
+}
+
+/*
+    =========================================================
+        write_metrics_file
+    =========================================================
+*/
+bool write_metrics_file(const std::string& root_path, const run_metrics& metrics)
+{
+    std::filesystem::path state_directory = get_state_directory(root_path);
+
+    std::error_code ec;
+    std::filesystem::create_directories(state_directory, ec);
+    if (ec)
+    {
+        return false;
+    }
+
+    std::ofstream out(state_directory / "metrics.json", std::ios::trunc);
+    if (!out.is_open())
+    {
+        return false;
+    }
+
+    out << metrics.to_json();
+    return static_cast<bool>(out);
+}
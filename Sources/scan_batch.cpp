@@ -0,0 +1,247 @@
+#include "scan_batch.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SCAN_BATCH_POSIX 1
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+/*
+    =========================================================
+        scan_batch::clear
+    =========================================================
+*/
+void scan_batch::clear()
+{
+    name_blob.clear();
+    name_offsets.clear();
+    types.clear();
+    sizes.clear();
+    mtimes_ns.clear();
+    inodes.clear();
+}
+
+#if defined(SCAN_BATCH_POSIX)
+
+/*
+    =========================================================
+        directory_scanner (POSIX)
+    =========================================================
+*/
+directory_scanner::~directory_scanner()
+{
+    if (directory_stream != nullptr)
+    {
+        closedir(static_cast<DIR*>(directory_stream));
+    }
+}
+
+scan_status directory_scanner::open(const std::string& directory_path)
+{
+    if (directory_stream != nullptr)
+    {
+        closedir(static_cast<DIR*>(directory_stream));
+    }
+
+    directory_stream = opendir(directory_path.c_str());
+    range_end = UINT64_MAX;
+
+    if (directory_stream == nullptr)
+    {
+        return (errno == EACCES || errno == EPERM) ? scan_status::permission_denied
+                                                   : scan_status::failed;
+    }
+    return scan_status::ok;
+}
+
+scan_status directory_scanner::open_range(const std::string& directory_path, std::uint64_t start, std::uint64_t end)
+{
+    scan_status status = open(directory_path);
+    if (status != scan_status::ok)
+    {
+        return status;
+    }
+
+    seekdir(static_cast<DIR*>(directory_stream), static_cast<long>(start));
+    range_end = end;
+    return scan_status::ok;
+}
+
+/*
+    Modification time in nanoseconds since the epoch.
+*/
+static std::int64_t mtime_ns_of(const struct stat& st)
+{
+#if defined(__APPLE__)
+    return static_cast<std::int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    return static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+}
+
+/*
+    =========================================================
+        directory_scanner::next_batch
+    =========================================================
+*/
+scan_status directory_scanner::next_batch(scan_batch& batch, std::size_t max_entries)
+{
+    batch.clear();
+
+    if (directory_stream == nullptr)
+    {
+        return scan_status::failed;
+    }
+
+    DIR* stream = static_cast<DIR*>(directory_stream);
+    int directory_fd = dirfd(stream);
+
+    batch.name_offsets.push_back(0);
+
+    while (batch.size() < max_entries)
+    {
+        // Position of the entry about to be read (only consulted for ranges)
+        if (range_end != UINT64_MAX && static_cast<std::uint64_t>(telldir(stream)) >= range_end)
+        {
+            break;
+        }
+
+        errno = 0;
+        dirent* entry = readdir(stream);
+
+        if (entry == nullptr)
+        {
+            if (errno != 0)
+            {
+                return scan_status::failed;
+            }
+            break;
+        }
+
+        const char* name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+        {
+            continue;
+        }
+
+        /*
+            One stat per entry, relative to the open directory.
+            Follows symlinks, like the old is_regular_file() check.
+        */
+        struct stat st;
+        scan_entry_type type = scan_entry_type::other;
+        std::uint64_t size = 0;
+        std::int64_t mtime_ns = 0;
+
+        if (fstatat(directory_fd, name, &st, 0) == 0)
+        {
+            if (S_ISREG(st.st_mode))
+            {
+                type = scan_entry_type::regular_file;
+            }
+            else if (S_ISDIR(st.st_mode))
+            {
+                type = scan_entry_type::directory;
+            }
+            size = static_cast<std::uint64_t>(st.st_size);
+            mtime_ns = mtime_ns_of(st);
+        }
+
+        batch.name_blob.append(name);
+        batch.name_offsets.push_back(static_cast<std::uint32_t>(batch.name_blob.size()));
+        batch.types.push_back(type);
+        batch.sizes.push_back(size);
+        batch.mtimes_ns.push_back(mtime_ns);
+        batch.inodes.push_back(static_cast<std::uint64_t>(entry->d_ino));
+    }
+
+    return batch.size() == 0 ? scan_status::end_of_directory : scan_status::ok;
+}
+
+#else
+
+/*
+    =========================================================
+        directory_scanner (std::filesystem)
+    =========================================================
+
+    Same batches, filled from directory_iterator.
+    Inode numbers are not available and stay 0.
+*/
+directory_scanner::~directory_scanner()
+{
+}
+
+scan_status directory_scanner::open(const std::string& directory_path)
+{
+    std::error_code ec;
+    fallback_iterator = std::filesystem::directory_iterator(directory_path, ec);
+
+    if (ec)
+    {
+        return ec == std::errc::permission_denied ? scan_status::permission_denied
+                                                  : scan_status::failed;
+    }
+    return scan_status::ok;
+}
+
+scan_status directory_scanner::open_range(const std::string& directory_path, std::uint64_t start, std::uint64_t end)
+{
+    // Directory positions are not exposed by std::filesystem
+    (void)directory_path;
+    (void)start;
+    (void)end;
+    return scan_status::failed;
+}
+
+scan_status directory_scanner::next_batch(scan_batch& batch, std::size_t max_entries)
+{
+    batch.clear();
+    batch.name_offsets.push_back(0);
+
+    std::error_code ec;
+    for (std::filesystem::directory_iterator end;
+         fallback_iterator != end && batch.size() < max_entries;
+         fallback_iterator.increment(ec))
+    {
+        if (ec)
+        {
+            return scan_status::failed;
+        }
+
+        const std::filesystem::directory_entry& entry = *fallback_iterator;
+
+        scan_entry_type type = scan_entry_type::other;
+        std::uint64_t size = 0;
+        std::int64_t mtime_ns = 0;
+
+        if (entry.is_regular_file(ec))
+        {
+            type = scan_entry_type::regular_file;
+            size = entry.file_size(ec);
+        }
+        else if (entry.is_directory(ec))
+        {
+            type = scan_entry_type::directory;
+        }
+
+        std::filesystem::file_time_type mtime = entry.last_write_time(ec);
+        if (!ec)
+        {
+            mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+        }
+
+        batch.name_blob.append(entry.path().filename().string());
+        batch.name_offsets.push_back(static_cast<std::uint32_t>(batch.name_blob.size()));
+        batch.types.push_back(type);
+        batch.sizes.push_back(size);
+        batch.mtimes_ns.push_back(mtime_ns);
+        batch.inodes.push_back(0);
+    }
+
+    return batch.size() == 0 ? scan_status::end_of_directory : scan_status::ok;
+}
+
+#endif
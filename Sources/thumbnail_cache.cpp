@@ -0,0 +1,296 @@
+#include "thumbnail_cache.hpp"
+#include "extensions.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QUrl>
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+/*
+    =========================================================
+        thumbnail_cache_directory
+    =========================================================
+*/
+std::filesystem::path thumbnail_cache_directory(thumbnail_flavor flavor)
+{
+    std::filesystem::path cache_home;
+
+    const char* xdg_cache_home = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+
+    if (xdg_cache_home != nullptr && xdg_cache_home[0] == '/')
+    {
+        cache_home = xdg_cache_home;
+    }
+    else if (home != nullptr)
+    {
+        cache_home = std::filesystem::path(home) / ".cache";
+    }
+    else
+    {
+        cache_home = QDir::homePath().toStdString() + "/.cache";
+    }
+
+    return cache_home / "thumbnails" / (flavor == thumbnail_flavor::large ? "large" : "normal");
+}
+
+/*
+    Canonical URI of the image, as file managers compute it:
+    percent-encoded "file:///absolute/path".
+*/
+static QByteArray image_uri(const std::filesystem::path& image_path)
+{
+    QString absolute = QFileInfo(QString::fromStdString(image_path.string())).absoluteFilePath();
+    return QUrl::fromLocalFile(absolute).toEncoded();
+}
+
+static int edge_length(thumbnail_flavor flavor)
+{
+    return flavor == thumbnail_flavor::large ? 256 : 128;
+}
+
+/*
+    The whole thumbnail is read, not only its text chunks:
+    QImageReader::text() splits keys at the first ':', so it never
+    finds "Thumb::URI". Decoding at most 256 x 256 pixels is cheap
+    next to decoding the source image again.
+*/
+static bool is_valid_thumbnail(const QString& thumbnail_file, const QByteArray& uri, qint64 mtime)
+{
+    QImage existing(thumbnail_file, "PNG");
+    if (existing.isNull())
+    {
+        return false;
+    }
+
+    return existing.text("Thumb::URI").toUtf8() == uri
+        && existing.text("Thumb::MTime") == QString::number(mtime);
+}
+
+/*
+    =========================================================
+        generate_thumbnail
+    =========================================================
+*/
+thumbnail_status generate_thumbnail(const std::filesystem::path& image_path, thumbnail_flavor flavor)
+{
+    QString source = QString::fromStdString(image_path.string());
+    QFileInfo source_info(source);
+
+    QByteArray uri = image_uri(image_path);
+    qint64 mtime = source_info.lastModified().toSecsSinceEpoch();
+
+    QByteArray hash = QCryptographicHash::hash(uri, QCryptographicHash::Md5).toHex();
+    std::filesystem::path directory = thumbnail_cache_directory(flavor);
+    QString thumbnail_file = QString::fromStdString((directory / (hash.toStdString() + ".png")).string());
+
+    if (is_valid_thumbnail(thumbnail_file, uri, mtime))
+    {
+        return thumbnail_status::already_valid;
+    }
+
+    QImageReader reader(source);
+    reader.setAutoTransform(true);
+
+    /*
+        Scaled decode: the reader is told the target size up front, so
+        formats that support it (JPEG) decode at reduced resolution
+        instead of decoding the full image and shrinking it afterwards.
+    */
+    int edge = edge_length(flavor);
+    QSize original_size = reader.size();
+    if (original_size.isValid() && (original_size.width() > edge || original_size.height() > edge))
+    {
+        reader.setScaledSize(original_size.scaled(edge, edge, Qt::KeepAspectRatio));
+    }
+
+    QImage thumbnail = reader.read();
+    if (thumbnail.isNull())
+    {
+        return thumbnail_status::unreadable;
+    }
+
+    // Formats without scaled decode (or without a known size)
+    if (thumbnail.width() > edge || thumbnail.height() > edge)
+    {
+        thumbnail = thumbnail.scaled(edge, edge, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    thumbnail.setText("Thumb::URI", QString::fromUtf8(uri));
+    thumbnail.setText("Thumb::MTime", QString::number(mtime));
+    thumbnail.setText("Thumb::Size", QString::number(source_info.size()));
+    if (original_size.isValid())
+    {
+        thumbnail.setText("Thumb::Image::Width", QString::number(original_size.width()));
+        thumbnail.setText("Thumb::Image::Height", QString::number(original_size.height()));
+    }
+    thumbnail.setText("Software", "File Organizer");
+
+    // Spec: the thumbnail directories are private to the user
+    std::error_code ec;
+    if (!std::filesystem::exists(directory, ec))
+    {
+        std::filesystem::create_directories(directory, ec);
+        std::filesystem::permissions(directory.parent_path(), std::filesystem::perms::owner_all, ec);
+        std::filesystem::permissions(directory, std::filesystem::perms::owner_all, ec);
+    }
+
+    // Written to a temporary file and renamed: readers never see half a PNG
+    QSaveFile output(thumbnail_file);
+    if (!output.open(QIODevice::WriteOnly))
+    {
+        return thumbnail_status::write_failed;
+    }
+    output.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+
+    if (!thumbnail.save(&output, "PNG") || !output.commit())
+    {
+        return thumbnail_status::write_failed;
+    }
+
+    return thumbnail_status::created;
+}
+
+/*
+    =========================================================
+        rate_limiter
+    =========================================================
+
+    Hands out evenly spaced start slots shared by all threads,
+    so a large import never saturates the disk or the CPUs.
+*/
+namespace
+{
+class rate_limiter
+{
+public:
+    explicit rate_limiter(unsigned per_second)
+        : interval(per_second == 0 ? std::chrono::steady_clock::duration::zero()
+                                   : std::chrono::steady_clock::duration(std::chrono::seconds(1)) / per_second)
+        , next_slot(std::chrono::steady_clock::now())
+    {
+    }
+
+    void wait_for_slot()
+    {
+        if (interval == std::chrono::steady_clock::duration::zero())
+        {
+            return;
+        }
+
+        std::chrono::steady_clock::time_point slot;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            slot = next_slot > now ? next_slot : now;
+            next_slot = slot + interval;
+        }
+        std::this_thread::sleep_until(slot);
+    }
+
+private:
+    std::chrono::steady_clock::duration interval;
+    std::chrono::steady_clock::time_point next_slot;
+    std::mutex mutex;
+};
+}
+
+/*
+    =========================================================
+        pregenerate_thumbnails
+    =========================================================
+*/
+thumbnail_summary pregenerate_thumbnails(
+    const std::vector<std::filesystem::path>& image_paths,
+    const thumbnail_policy& policy,
+    const std::atomic<bool>* stop_requested
+    )
+{
+    std::atomic<std::size_t> next_image{0};
+    std::atomic<std::size_t> created{0};
+    std::atomic<std::size_t> already_valid{0};
+    std::atomic<std::size_t> failed{0};
+
+    rate_limiter limiter(policy.max_per_second);
+
+    auto worker = [&]()
+    {
+        while (stop_requested == nullptr || !stop_requested->load())
+        {
+            std::size_t i = next_image.fetch_add(1);
+            if (i >= image_paths.size())
+            {
+                return;
+            }
+
+            limiter.wait_for_slot();
+
+            switch (generate_thumbnail(image_paths[i], policy.flavor))
+            {
+            case thumbnail_status::created:
+                created++;
+                break;
+            case thumbnail_status::already_valid:
+                already_valid++;
+                break;
+            default:
+                failed++;
+                break;
+            }
+        }
+    };
+
+    unsigned thread_count = policy.max_threads == 0 ? 1 : policy.max_threads;
+    if (thread_count > image_paths.size())
+    {
+        thread_count = static_cast<unsigned>(image_paths.size());
+    }
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    thumbnail_summary summary;
+    summary.created = created.load();
+    summary.already_valid = already_valid.load();
+    summary.failed = failed.load();
+    return summary;
+}
+
+/*
+    =========================================================
+        placed_image_collector
+    =========================================================
+*/
+void placed_image_collector::add(const std::filesystem::path& destination)
+{
+    if (classify_file_by_extension(destination.filename().string()) != "Image Files")
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    images.push_back(destination);
+}
+
+std::vector<std::filesystem::path> placed_image_collector::take()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::filesystem::path> taken;
+    taken.swap(images);
+    return taken;
+}
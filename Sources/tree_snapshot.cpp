@@ -0,0 +1,738 @@
+#include "tree_snapshot.hpp"
+#include "directory_index.hpp"
+#include "filesystem_utils.hpp"
+#include "move_hook.hpp"
+#include "scan_batch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+static const char SNAPSHOT_MAGIC[8] = {'F', 'O', 'S', 'N', 'A', 'P', '1', '\n'};
+static const char* SNAPSHOT_FILE_NAME = "snapshot.bin";
+static const char* PREVIOUS_SNAPSHOT_FILE_NAME = "snapshot.previous.bin";
+
+// Read and write buffers
+static const std::size_t IO_BUFFER_BYTES = 1024 * 1024;
+
+/*
+    One file of a snapshot or of the live tree.
+    path is relative to the root, '/' separated.
+*/
+struct snapshot_entry
+{
+    std::string path;
+    std::uint64_t inode = 0;
+    std::uint64_t size = 0;
+    std::int64_t mtime_ns = 0;
+};
+
+/*
+    Component by component: '/' sorts before every other byte.
+*/
+static int compare_paths(const std::string& a, const std::string& b)
+{
+    std::size_t common = std::min(a.size(), b.size());
+    for (std::size_t i = 0; i < common; i++)
+    {
+        unsigned char x = a[i] == '/' ? 0 : static_cast<unsigned char>(a[i]);
+        unsigned char y = b[i] == '/' ? 0 : static_cast<unsigned char>(b[i]);
+        if (x != y)
+        {
+            return x < y ? -1 : 1;
+        }
+    }
+    if (a.size() == b.size())
+    {
+        return 0;
+    }
+    return a.size() < b.size() ? -1 : 1;
+}
+
+/*
+    Absolute, without a trailing separator ("/" stays "/").
+*/
+static std::string normalized_root(const std::string& root_path)
+{
+    std::error_code ec;
+    std::string root = std::filesystem::absolute(root_path, ec).lexically_normal().string();
+    while (root.size() > 1 && root.back() == '/')
+    {
+        root.pop_back();
+    }
+    return root;
+}
+
+/*
+    root + "/" + relative_path, without doubling the separator of "/".
+*/
+static std::string join_root(const std::string& root, const std::string& relative_path)
+{
+    return root.back() == '/' ? root + relative_path : root + "/" + relative_path;
+}
+
+/*
+    =========================================================
+        varints
+    =========================================================
+*/
+static void append_varint(std::string& out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+static std::uint64_t zigzag(std::int64_t value)
+{
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+static std::int64_t unzigzag(std::uint64_t value)
+{
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+
+/*
+    =========================================================
+        entry_source
+    =========================================================
+
+    A sorted sequence of files: a snapshot or the live tree.
+*/
+class entry_source
+{
+public:
+    virtual ~entry_source() = default;
+
+    // False at the end (or on a read error, see corrupt())
+    virtual bool next(snapshot_entry& entry) = 0;
+
+    virtual bool corrupt() const
+    {
+        return false;
+    }
+};
+
+
+/*
+    =========================================================
+        snapshot_reader
+    =========================================================
+*/
+class snapshot_reader : public entry_source
+{
+public:
+    snapshot_status open(const std::filesystem::path& snapshot_path)
+    {
+        in.open(snapshot_path, std::ios::binary);
+        if (!in.is_open())
+        {
+            return snapshot_status::snapshot_not_found;
+        }
+        buffer.resize(IO_BUFFER_BYTES);
+
+        char magic[sizeof(SNAPSHOT_MAGIC)];
+        for (char& c : magic)
+        {
+            int byte = next_byte();
+            c = static_cast<char>(byte);
+            if (byte < 0)
+            {
+                return snapshot_status::snapshot_corrupt;
+            }
+        }
+
+        std::uint64_t root_length = 0;
+        if (std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0
+            || !read_varint(root_length) || !read_bytes(root, root_length))
+        {
+            return snapshot_status::snapshot_corrupt;
+        }
+
+        for (int i = 0; i < 8; i++)
+        {
+            int byte = next_byte();
+            if (byte < 0)
+            {
+                return snapshot_status::snapshot_corrupt;
+            }
+            entry_count |= static_cast<std::uint64_t>(byte) << (8 * i);
+        }
+        return snapshot_status::ok;
+    }
+
+    bool next(snapshot_entry& entry) override
+    {
+        if (entries_read == entry_count || broken)
+        {
+            return false;
+        }
+
+        std::uint64_t shared = 0;
+        std::uint64_t suffix_length = 0;
+        std::uint64_t mtime = 0;
+
+        if (!read_varint(shared) || shared > previous_path.size() || !read_varint(suffix_length))
+        {
+            broken = true;
+            return false;
+        }
+
+        previous_path.resize(shared);
+        std::string suffix;
+        if (!read_bytes(suffix, suffix_length)
+            || !read_varint(entry.inode) || !read_varint(entry.size) || !read_varint(mtime))
+        {
+            broken = true;
+            return false;
+        }
+
+        previous_path += suffix;
+        entry.path = previous_path;
+        entry.mtime_ns = unzigzag(mtime);
+        entries_read++;
+        return true;
+    }
+
+    bool corrupt() const override
+    {
+        return broken;
+    }
+
+    const std::string& root_path() const
+    {
+        return root;
+    }
+
+    std::uint64_t entries() const
+    {
+        return entry_count;
+    }
+
+private:
+    int next_byte()
+    {
+        if (position == filled)
+        {
+            in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            filled = static_cast<std::size_t>(in.gcount());
+            position = 0;
+            if (filled == 0)
+            {
+                return -1;
+            }
+        }
+        return static_cast<unsigned char>(buffer[position++]);
+    }
+
+    bool read_varint(std::uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            int byte = next_byte();
+            if (byte < 0)
+            {
+                return false;
+            }
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool read_bytes(std::string& out, std::uint64_t length)
+    {
+        // A path is never longer than this; anything else is damage
+        if (length > 64 * 1024)
+        {
+            return false;
+        }
+        out.clear();
+        for (std::uint64_t i = 0; i < length; i++)
+        {
+            int byte = next_byte();
+            if (byte < 0)
+            {
+                return false;
+            }
+            out += static_cast<char>(byte);
+        }
+        return true;
+    }
+
+    std::ifstream in;
+    std::vector<char> buffer;
+    std::size_t position = 0;
+    std::size_t filled = 0;
+
+    std::string root;
+    std::uint64_t entry_count = 0;
+    std::uint64_t entries_read = 0;
+    std::string previous_path;
+    bool broken = false;
+};
+
+
+/*
+    =========================================================
+        sorted_tree_walker
+    =========================================================
+
+    Depth-first walk that reads every folder completely and sorts it
+    by name before handing out its files, so files come out in
+    compare_paths order. Only the folders on the current chain are
+    held in memory.
+*/
+class sorted_tree_walker : public entry_source
+{
+public:
+    explicit sorted_tree_walker(const std::string& root_path)
+        : root(root_path)
+    {
+        push_folder("");
+    }
+
+    bool next(snapshot_entry& entry) override
+    {
+        while (!folders.empty())
+        {
+            folder_frame& frame = folders.back();
+            if (frame.next == frame.children.size())
+            {
+                folders.pop_back();
+                continue;
+            }
+
+            const folder_child& child = frame.children[frame.next++];
+            std::string relative_path = frame.relative_path.empty() ? child.name
+                                                                    : frame.relative_path + "/" + child.name;
+
+            if (child.type == scan_entry_type::directory)
+            {
+                if (child.name[0] != '.')
+                {
+                    push_folder(relative_path);     // frame is invalid from here on
+                }
+                continue;
+            }
+
+            if (child.type == scan_entry_type::regular_file)
+            {
+                entry.path = std::move(relative_path);
+                entry.inode = child.inode;
+                entry.size = child.size;
+                entry.mtime_ns = child.mtime_ns;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct folder_child
+    {
+        std::string name;
+        scan_entry_type type = scan_entry_type::other;
+        std::uint64_t inode = 0;
+        std::uint64_t size = 0;
+        std::int64_t mtime_ns = 0;
+    };
+
+    struct folder_frame
+    {
+        std::string relative_path;
+        std::vector<folder_child> children;
+        std::size_t next = 0;
+    };
+
+    void push_folder(const std::string& relative_path)
+    {
+        folder_frame frame;
+        frame.relative_path = relative_path;
+
+        std::filesystem::path folder_path = relative_path.empty()
+            ? std::filesystem::path(root)
+            : std::filesystem::path(root) / relative_path;
+
+        // Unreadable folders are simply not part of the walk
+        directory_scanner scanner;
+        if (scanner.open(folder_path.string()) == scan_status::ok)
+        {
+            while (scanner.next_batch(batch) == scan_status::ok)
+            {
+                for (std::size_t i = 0; i < batch.size(); i++)
+                {
+                    folder_child child;
+                    child.name = std::string(batch.name(i));
+                    child.type = batch.types[i];
+                    child.inode = batch.inodes[i];
+                    child.size = batch.sizes[i];
+                    child.mtime_ns = batch.mtimes_ns[i];
+                    frame.children.push_back(std::move(child));
+                }
+            }
+        }
+
+        std::sort(frame.children.begin(), frame.children.end(),
+                  [](const folder_child& a, const folder_child& b) { return a.name < b.name; });
+        folders.push_back(std::move(frame));
+    }
+
+    std::string root;
+    std::vector<folder_frame> folders;
+    scan_batch batch;
+};
+
+
+/*
+    =========================================================
+        get_snapshot_path / get_previous_snapshot_path
+    =========================================================
+*/
+std::filesystem::path get_snapshot_path(const std::string& root_path)
+{
+    return get_state_directory(root_path) / SNAPSHOT_FILE_NAME;
+}
+
+std::filesystem::path get_previous_snapshot_path(const std::string& root_path)
+{
+    return get_state_directory(root_path) / PREVIOUS_SNAPSHOT_FILE_NAME;
+}
+
+/*
+    =========================================================
+        write_tree_snapshot
+    =========================================================
+*/
+snapshot_status write_tree_snapshot(const std::string& root_path, const std::filesystem::path& snapshot_path)
+{
+    if (validate_path(root_path) != path_status::ok)
+    {
+        return snapshot_status::root_not_found;
+    }
+
+    std::error_code ec;
+    std::filesystem::path temp_path = snapshot_path;
+    temp_path += ".tmp";
+    std::filesystem::create_directories(snapshot_path.parent_path(), ec);
+
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            return snapshot_status::write_failed;
+        }
+
+        std::string root = normalized_root(root_path);
+
+        std::string header(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        append_varint(header, root.size());
+        header += root;
+        out << header;
+
+        // Patched once the walk is done
+        std::streampos count_position = out.tellp();
+        out.write("\0\0\0\0\0\0\0\0", 8);
+
+        sorted_tree_walker walker(root);
+        snapshot_entry entry;
+        std::string previous_path;
+        std::string pending;
+        std::uint64_t count = 0;
+
+        while (walker.next(entry))
+        {
+            std::size_t shared = 0;
+            std::size_t limit = std::min(previous_path.size(), entry.path.size());
+            while (shared < limit && previous_path[shared] == entry.path[shared])
+            {
+                shared++;
+            }
+
+            append_varint(pending, shared);
+            append_varint(pending, entry.path.size() - shared);
+            pending.append(entry.path, shared, std::string::npos);
+            append_varint(pending, entry.inode);
+            append_varint(pending, entry.size);
+            append_varint(pending, zigzag(entry.mtime_ns));
+
+            previous_path.swap(entry.path);
+            count++;
+
+            if (pending.size() >= IO_BUFFER_BYTES)
+            {
+                out.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+                pending.clear();
+            }
+        }
+        out.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+
+        char count_bytes[8];
+        for (int i = 0; i < 8; i++)
+        {
+            count_bytes[i] = static_cast<char>((count >> (8 * i)) & 0xFF);
+        }
+        out.seekp(count_position);
+        out.write(count_bytes, 8);
+
+        out.flush();
+        if (!out)
+        {
+            out.close();
+            std::filesystem::remove(temp_path, ec);
+            return snapshot_status::write_failed;
+        }
+    }
+
+    std::filesystem::rename(temp_path, snapshot_path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(temp_path, ec);
+        return snapshot_status::write_failed;
+    }
+    return snapshot_status::ok;
+}
+
+/*
+    =========================================================
+        record_tree_snapshot
+    =========================================================
+*/
+snapshot_status record_tree_snapshot(const std::string& root_path)
+{
+    std::error_code ec;
+    std::filesystem::path latest = get_snapshot_path(root_path);
+
+    if (std::filesystem::exists(latest, ec))
+    {
+        std::filesystem::rename(latest, get_previous_snapshot_path(root_path), ec);
+        if (ec)
+        {
+            return snapshot_status::write_failed;
+        }
+    }
+    return write_tree_snapshot(root_path, latest);
+}
+
+
+/*
+    =========================================================
+        merge_diff
+    =========================================================
+
+    One pass over both sorted sequences:
+
+    - path only on the old side  → removed (for now)
+    - path only on the new side  → added (for now)
+    - same path, other inode     → removed + added (replaced)
+    - same path, size or mtime   → modified, reported right away
+
+    Afterwards, added files that match a removed file by inode, size
+    and modification time are reported as moved. Only the changes are
+    kept in memory.
+*/
+static snapshot_status merge_diff(
+    entry_source& old_side,
+    const std::string& old_root,
+    entry_source& new_side,
+    const std::string& new_root,
+    const std::string& report_path,
+    snapshot_diff_summary& summary)
+{
+    std::ofstream out(report_path, std::ios::trunc);
+    if (!out.is_open())
+    {
+        return snapshot_status::write_failed;
+    }
+
+    std::string line;
+    auto write_line = [&](const char* change, const std::string* source, const std::string* destination)
+    {
+        line.clear();
+        line += "{\"change\":\"";
+        line += change;
+        line += '"';
+        if (source != nullptr)
+        {
+            line += ",\"source\":";
+            append_json_string(line, join_root(old_root, *source));
+        }
+        if (destination != nullptr)
+        {
+            line += ",\"destination\":";
+            append_json_string(line, join_root(new_root, *destination));
+        }
+        line += "}\n";
+        out << line;
+    };
+
+    std::vector<snapshot_entry> removed;
+    std::vector<snapshot_entry> added;
+
+    snapshot_entry old_entry;
+    snapshot_entry new_entry;
+    bool has_old = old_side.next(old_entry);
+    bool has_new = new_side.next(new_entry);
+
+    while (has_old || has_new)
+    {
+        int order = !has_old ? 1 : !has_new ? -1 : compare_paths(old_entry.path, new_entry.path);
+
+        if (order < 0)
+        {
+            summary.old_entries++;
+            removed.push_back(std::move(old_entry));
+            has_old = old_side.next(old_entry);
+        }
+        else if (order > 0)
+        {
+            summary.new_entries++;
+            added.push_back(std::move(new_entry));
+            has_new = new_side.next(new_entry);
+        }
+        else
+        {
+            summary.old_entries++;
+            summary.new_entries++;
+
+            if (old_entry.inode != new_entry.inode)
+            {
+                removed.push_back(std::move(old_entry));
+                added.push_back(std::move(new_entry));
+            }
+            else if (old_entry.size != new_entry.size || old_entry.mtime_ns != new_entry.mtime_ns)
+            {
+                write_line("modified", &old_entry.path, &new_entry.path);
+                summary.modified++;
+            }
+
+            has_old = old_side.next(old_entry);
+            has_new = new_side.next(new_entry);
+        }
+    }
+
+    if (old_side.corrupt() || new_side.corrupt())
+    {
+        return snapshot_status::snapshot_corrupt;
+    }
+
+    // Hard links share an inode, hence a multimap
+    std::unordered_multimap<std::uint64_t, std::size_t> removed_by_inode;
+    removed_by_inode.reserve(removed.size());
+    for (std::size_t i = 0; i < removed.size(); i++)
+    {
+        removed_by_inode.emplace(removed[i].inode, i);
+    }
+    std::vector<bool> paired(removed.size(), false);
+
+    for (const snapshot_entry& file : added)
+    {
+        bool was_moved = false;
+        auto candidates = removed_by_inode.equal_range(file.inode);
+
+        for (auto it = candidates.first; it != candidates.second; ++it)
+        {
+            const snapshot_entry& origin = removed[it->second];
+            if (!paired[it->second] && origin.size == file.size && origin.mtime_ns == file.mtime_ns)
+            {
+                paired[it->second] = true;
+                write_line("moved", &origin.path, &file.path);
+                summary.moved++;
+                was_moved = true;
+                break;
+            }
+        }
+
+        if (!was_moved)
+        {
+            write_line("added", nullptr, &file.path);
+            summary.added++;
+        }
+    }
+
+    for (std::size_t i = 0; i < removed.size(); i++)
+    {
+        if (!paired[i])
+        {
+            write_line("removed", &removed[i].path, nullptr);
+            summary.removed++;
+        }
+    }
+
+    out.flush();
+    return out ? snapshot_status::ok : snapshot_status::write_failed;
+}
+
+/*
+    =========================================================
+        diff_snapshots / diff_snapshot_against_tree
+    =========================================================
+*/
+snapshot_status diff_snapshots(
+    const std::filesystem::path& old_snapshot_path,
+    const std::filesystem::path& new_snapshot_path,
+    const std::string& report_path,
+    snapshot_diff_summary& summary)
+{
+    summary = snapshot_diff_summary();
+    auto started = std::chrono::steady_clock::now();
+
+    snapshot_reader old_side;
+    snapshot_reader new_side;
+
+    snapshot_status status = old_side.open(old_snapshot_path);
+    if (status != snapshot_status::ok)
+    {
+        return status;
+    }
+    status = new_side.open(new_snapshot_path);
+    if (status != snapshot_status::ok)
+    {
+        return status;
+    }
+
+    status = merge_diff(old_side, old_side.root_path(), new_side, new_side.root_path(), report_path, summary);
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return status;
+}
+
+snapshot_status diff_snapshot_against_tree(
+    const std::filesystem::path& snapshot_path,
+    const std::string& root_path,
+    const std::string& report_path,
+    snapshot_diff_summary& summary)
+{
+    summary = snapshot_diff_summary();
+    auto started = std::chrono::steady_clock::now();
+
+    if (validate_path(root_path) != path_status::ok)
+    {
+        return snapshot_status::root_not_found;
+    }
+
+    snapshot_reader old_side;
+    snapshot_status status = old_side.open(snapshot_path);
+    if (status != snapshot_status::ok)
+    {
+        return status;
+    }
+
+    std::string root = normalized_root(root_path);
+    sorted_tree_walker new_side(root);
+
+    status = merge_diff(old_side, old_side.root_path(), new_side, root, report_path, summary);
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return status;
+}
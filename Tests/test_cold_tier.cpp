@@ -0,0 +1,131 @@
+#include "test_support.hpp"
+#include "cold_tier.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <cstdio>
+
+/*
+    =========================================================
+        Cold tier: tier → recall round trips
+    =========================================================
+*/
+
+// Last access two years ago, so the default 365-day threshold applies
+static void make_cold(const std::filesystem::path& file_path)
+{
+    struct timespec times[2];
+    times[0].tv_sec = time(nullptr) - 2 * 365 * 86400;
+    times[0].tv_nsec = 0;
+    times[1].tv_sec = 0;
+    times[1].tv_nsec = UTIME_OMIT;
+    utimensat(AT_FDCWD, file_path.c_str(), times, 0);
+}
+
+static void make_cold_tree(const std::filesystem::path& root)
+{
+    write_file(root / "Text Files/notes.txt", "old notes");
+    write_file(root / "Image Files/2019/trip.jpg", "old photo");
+    write_file(root / "Text Files/fresh.txt", "fresh notes");
+
+    make_cold(root / "Text Files/notes.txt");
+    make_cold(root / "Image Files/2019/trip.jpg");
+}
+
+static void check_round_trip(const std::filesystem::path& cold_parent, bool leave_symlink)
+{
+    scratch_directory root;
+    std::filesystem::path cold_root = cold_parent / ("cold-" + root.path().filename().string());
+    make_cold_tree(root.path());
+
+    tiering_policy policy;
+    policy.enabled = true;
+    policy.cold_root = cold_root.string();
+    policy.leave_symlink = leave_symlink;
+
+    tiering_summary tiered = tier_cold_files(root.path().string(), policy, nullptr);
+    CHECK(tiered.status == tiering_status::success);
+    CHECK(tiered.files_moved == 2);
+    CHECK(read_file(cold_root / "Text Files/notes.txt") == "old notes");
+    CHECK(read_file(cold_root / "Image Files/2019/trip.jpg") == "old photo");
+    CHECK(std::filesystem::is_symlink(root.path() / "Text Files/notes.txt") == leave_symlink);
+
+    tiering_summary recalled = recall_cold_files(root.path().string(), policy, "");
+    CHECK(recalled.status == tiering_status::success);
+    CHECK(recalled.files_moved == 2);
+    CHECK(recalled.files_failed == 0);
+
+    // Back under their own names, as real files; the links are gone
+    CHECK(!std::filesystem::is_symlink(root.path() / "Text Files/notes.txt"));
+    CHECK(read_file(root.path() / "Text Files/notes.txt") == "old notes");
+    CHECK(read_file(root.path() / "Image Files/2019/trip.jpg") == "old photo");
+    CHECK(read_file(root.path() / "Text Files/fresh.txt") == "fresh notes");
+    CHECK(layout_by_contents(root.path()).size() == 3);
+    CHECK(layout_by_contents(cold_root).empty());
+
+    std::error_code ec;
+    std::filesystem::remove_all(cold_root, ec);
+}
+
+TEST_CASE(cold_tier_round_trip_with_symlinks)
+{
+    check_round_trip(std::filesystem::temp_directory_path(), true);
+}
+
+TEST_CASE(cold_tier_round_trip_without_symlinks)
+{
+    check_round_trip(std::filesystem::temp_directory_path(), false);
+}
+
+/*
+    Cold root on another file system (/dev/shm is a tmpfs on most
+    Linux systems): both directions go through the copy engine.
+    Skipped where /dev/shm shares the temp directory's device.
+*/
+TEST_CASE(cold_tier_round_trip_across_devices)
+{
+    struct stat temp_status, shm_status;
+    if (stat(std::filesystem::temp_directory_path().c_str(), &temp_status) != 0
+        || stat("/dev/shm", &shm_status) != 0
+        || temp_status.st_dev == shm_status.st_dev)
+    {
+        std::printf("    (skipped: no second file system at /dev/shm)\n");
+        return;
+    }
+
+    check_round_trip("/dev/shm", true);
+    check_round_trip("/dev/shm", false);
+}
+
+/*
+    A file the user put where the link was is kept;
+    the recalled file comes back under a numbered name.
+*/
+TEST_CASE(cold_tier_recall_keeps_replaced_link)
+{
+    scratch_directory root;
+    std::filesystem::path cold_root = std::filesystem::temp_directory_path() / ("cold-" + root.path().filename().string());
+    make_cold_tree(root.path());
+
+    tiering_policy policy;
+    policy.enabled = true;
+    policy.cold_root = cold_root.string();
+    policy.leave_symlink = true;
+
+    CHECK(tier_cold_files(root.path().string(), policy, nullptr).files_moved == 2);
+
+    std::filesystem::remove(root.path() / "Text Files/notes.txt");
+    write_file(root.path() / "Text Files/notes.txt", "new notes");
+
+    tiering_summary recalled = recall_cold_files(root.path().string(), policy, "Text Files");
+    CHECK(recalled.files_moved == 1);
+    CHECK(read_file(root.path() / "Text Files/notes.txt") == "new notes");
+    CHECK(read_file(root.path() / "Text Files/notes(1).txt") == "old notes");
+
+    std::error_code ec;
+    std::filesystem::remove_all(cold_root, ec);
+}
+
+#endif
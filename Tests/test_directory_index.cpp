@@ -0,0 +1,102 @@
+#include "test_support.hpp"
+#include "directory_index.hpp"
+#include "memory_governor.hpp"
+
+/*
+    =========================================================
+        Directory index: spilled runs and paged loads
+    =========================================================
+*/
+
+static std::string numbered_path(int i)
+{
+    return "Text Files/some/deeper/folder/for/longer/paths/notes-" + std::to_string(i) + ".txt";
+}
+
+/*
+    Under heap pressure the index spills while recording; the saved
+    index is the same as if everything had stayed in memory.
+*/
+TEST_CASE(index_spills_under_pressure_and_merges_on_save)
+{
+    scratch_directory root;
+    std::string root_path = root.path().string();
+
+    directory_index index;
+    index.rules["txt"] = "Text Files";
+    std::set<std::string> expected;
+
+    {
+        heap_target_hold tiny_target(1);    // Always over target
+
+        for (int i = 0; i < 20000; i++)
+        {
+            record_file_location(index, root_path, root.path() / numbered_path(i));
+            expected.insert(numbered_path(i));
+        }
+        CHECK(!index.spill.run_files.empty());
+
+        // Spilled ones and in-memory ones alike
+        for (int i = 0; i < 20000; i += 7)
+        {
+            forget_file_location(index, root_path, root.path() / numbered_path(i));
+            expected.erase(numbered_path(i));
+        }
+        record_file_location(index, root_path, root.path() / numbered_path(7));
+        expected.insert(numbered_path(7));
+    }
+
+    std::vector<std::filesystem::path> runs = index.spill.run_files;
+    CHECK(save_directory_index(root_path, index) == index_status::ok);
+    for (const std::filesystem::path& run : runs)
+    {
+        CHECK(!std::filesystem::exists(run));
+    }
+
+    directory_index loaded;
+    CHECK(load_directory_index(root_path, loaded) == index_status::ok);
+    CHECK(loaded.rules == index.rules);
+    CHECK(loaded.locations.size() == 1);
+    CHECK(loaded.locations["txt"] == expected);
+}
+
+/*
+    A paged load reads only the groups asked for; saving carries the
+    others over from the index file untouched.
+*/
+TEST_CASE(index_paged_load_keeps_other_groups)
+{
+    scratch_directory root;
+    std::string root_path = root.path().string();
+
+    directory_index index;
+    index.rules["txt"] = "Text Files";
+    index.rules["jpg"] = "Image Files";
+    record_file_location(index, root_path, root.path() / "Text Files/a.txt");
+    record_file_location(index, root_path, root.path() / "Text Files/b.txt");
+    record_file_location(index, root_path, root.path() / "Image Files/c.jpg");
+    record_file_location(index, root_path, root.path() / "d");
+    CHECK(save_directory_index(root_path, index) == index_status::ok);
+
+    directory_index rules_only;
+    CHECK(load_directory_index(root_path, rules_only, std::set<std::string>()) == index_status::ok);
+    CHECK(rules_only.rules.size() == 2);
+    CHECK(rules_only.locations.empty());
+
+    directory_index paged;
+    CHECK(load_directory_index(root_path, paged, std::set<std::string>{"txt"}) == index_status::ok);
+    CHECK(paged.locations.size() == 1);
+    CHECK(paged.locations["txt"].size() == 2);
+
+    forget_file_location(paged, root_path, root.path() / "Text Files/a.txt");
+    record_file_location(paged, root_path, root.path() / "Text Files/notes/a.txt");
+    forget_file_location(paged, root_path, root.path() / "Image Files/c.jpg");
+    record_file_location(paged, root_path, root.path() / "Image Files/2024/c.jpg");
+    CHECK(save_directory_index(root_path, paged) == index_status::ok);
+
+    directory_index loaded;
+    CHECK(load_directory_index(root_path, loaded) == index_status::ok);
+    CHECK(loaded.locations["txt"] == (std::set<std::string>{"Text Files/b.txt", "Text Files/notes/a.txt"}));
+    CHECK(loaded.locations["jpg"] == (std::set<std::string>{"Image Files/2024/c.jpg"}));
+    CHECK(loaded.locations[""] == (std::set<std::string>{"d"}));
+}
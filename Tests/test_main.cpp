@@ -0,0 +1,138 @@
+#include "test_support.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+static int failed_checks = 0;
+
+/*
+    =========================================================
+        Registration and checks
+    =========================================================
+*/
+std::vector<test_case>& registered_tests()
+{
+    static std::vector<test_case> tests;
+    return tests;
+}
+
+test_registration::test_registration(const char* name, void (*run)())
+{
+    registered_tests().push_back(test_case{name, run});
+}
+
+void check_condition(bool passed, const char* expression, const char* file, int line)
+{
+    if (!passed)
+    {
+        failed_checks++;
+        std::printf("    %s:%d: CHECK(%s) failed\n", file, line, expression);
+    }
+}
+
+/*
+    =========================================================
+        scratch_directory
+    =========================================================
+*/
+scratch_directory::scratch_directory()
+{
+    static std::atomic<unsigned> counter{0};
+
+    std::uint64_t stamp = static_cast<std::uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+
+    directory = std::filesystem::temp_directory_path()
+              / ("file_organizer_test-" + std::to_string(stamp) + "-" + std::to_string(counter++));
+    std::filesystem::create_directories(directory);
+}
+
+scratch_directory::~scratch_directory()
+{
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+}
+
+const std::filesystem::path& scratch_directory::path() const
+{
+    return directory;
+}
+
+/*
+    =========================================================
+        File helpers
+    =========================================================
+*/
+void write_file(const std::filesystem::path& file_path, const std::string& contents)
+{
+    std::filesystem::create_directories(file_path.parent_path());
+    std::ofstream out(file_path, std::ios::binary);
+    out << contents;
+}
+
+std::string read_file(const std::filesystem::path& file_path)
+{
+    std::ifstream in(file_path, std::ios::binary);
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+std::map<std::string, std::string> layout_by_contents(const std::filesystem::path& root)
+{
+    std::map<std::string, std::string> layout;
+
+    std::filesystem::recursive_directory_iterator it(root), end;
+    for (; it != end; ++it)
+    {
+        std::string name = it->path().filename().string();
+        if (it->is_directory() && !name.empty() && name[0] == '.')
+        {
+            it.disable_recursion_pending();
+            continue;
+        }
+        if (it->is_regular_file())
+        {
+            layout[read_file(it->path())] = it->path().lexically_relative(root).generic_string();
+        }
+    }
+    return layout;
+}
+
+/*
+    =========================================================
+        main
+    =========================================================
+
+    Runs every test, or only those whose name contains argv[1].
+    Exit code 0 only if every check passed.
+*/
+int main(int argc, char* argv[])
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int failed_tests = 0;
+    int run_tests = 0;
+
+    for (const test_case& test : registered_tests())
+    {
+        if (filter != nullptr && std::strstr(test.name, filter) == nullptr)
+        {
+            continue;
+        }
+
+        int failures_before = failed_checks;
+        test.run();
+        run_tests++;
+
+        bool passed = (failed_checks == failures_before);
+        failed_tests += passed ? 0 : 1;
+        std::printf("[%s] %s\n", passed ? " OK " : "FAIL", test.name);
+    }
+
+    std::printf("%d of %d tests passed\n", run_tests - failed_tests, run_tests);
+    return failed_tests == 0 ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+#include "test_support.hpp"
+#include "memory_governor.hpp"
+
+#include <memory>
+
+/*
+    =========================================================
+        Heap target: held per run, largest one applies
+    =========================================================
+*/
+
+TEST_CASE(heap_target_is_largest_held)
+{
+    memory_governor& governor = memory_governor::shared();
+    CHECK(governor.target() == 0);
+
+    std::unique_ptr<heap_target_hold> watch_run = std::make_unique<heap_target_hold>(256 << 20);
+    CHECK(governor.target() == (256 << 20));
+
+    {
+        heap_target_hold gui_run(512 << 20);
+        heap_target_hold untargeted_run(0);
+        CHECK(governor.target() == (512 << 20));
+    }
+
+    // The GUI run ended: back to the watch's own target, not none
+    CHECK(governor.target() == (256 << 20));
+
+    {
+        heap_target_hold same_target(256 << 20);
+    }
+    CHECK(governor.target() == (256 << 20));
+
+    watch_run.reset();
+    CHECK(governor.target() == 0);
+}
@@ -0,0 +1,105 @@
+#include "test_support.hpp"
+#include "move_hook.hpp"
+
+#if defined(__linux__)
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+/*
+    =========================================================
+        Post-move hook: timeouts and batching
+    =========================================================
+*/
+
+static hook_policy command_hook(const std::string& command, unsigned timeout_ms)
+{
+    hook_policy policy;
+    policy.enabled = true;
+    policy.command = command;
+    policy.timeout_ms = timeout_ms;
+    return policy;
+}
+
+// Seconds invoke_hook took, with its status
+static double timed_invoke(const hook_policy& policy, const std::string& payload, hook_status& status)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    status = invoke_hook(policy, payload);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+    A hook that never exits is killed, together with what it started
+    (here a background sleep that would keep the group alive).
+*/
+TEST_CASE(hook_command_times_out)
+{
+    hook_status status;
+    double seconds = timed_invoke(command_hook("cat > /dev/null; sleep 30 & sleep 30", 200), "{}\n", status);
+
+    CHECK(status == hook_status::timed_out);
+    CHECK(seconds < 5.0);
+}
+
+// A hook that never reads its stdin cannot block the write either
+TEST_CASE(hook_command_ignoring_stdin_times_out)
+{
+    hook_status status;
+    std::string payload(4 * 1024 * 1024, 'x');
+    double seconds = timed_invoke(command_hook("sleep 30", 200), payload, status);
+
+    CHECK(status == hook_status::timed_out);
+    CHECK(seconds < 5.0);
+}
+
+TEST_CASE(hook_command_status_is_reported)
+{
+    hook_status status;
+    timed_invoke(command_hook("cat > /dev/null", 5000), "{}\n", status);
+    CHECK(status == hook_status::ok);
+
+    timed_invoke(command_hook("cat > /dev/null; exit 3", 5000), "{}\n", status);
+    CHECK(status == hook_status::command_failed);
+}
+
+/*
+    Moves recorded from several threads while the single sender is
+    slow: every move arrives exactly once.
+*/
+TEST_CASE(hook_batches_deliver_every_move)
+{
+    scratch_directory root;
+    std::filesystem::path log = root.path() / "moves.ndjson";
+
+    hook_policy policy = command_hook("sleep 0.05; cat >> '" + log.string() + "'", 5000);
+    policy.batch_files = 7;
+    policy.batch_interval_ms = 20;
+    policy.max_concurrent = 1;
+
+    {
+        move_hook hook(policy, nullptr);
+        std::vector<std::thread> workers;
+        for (int worker = 0; worker < 4; worker++)
+        {
+            workers.emplace_back([&hook, worker] {
+                for (int move = 0; move < 25; move++)
+                {
+                    std::string name = std::to_string(worker) + "-" + std::to_string(move);
+                    hook.record("/in/" + name, "/out/" + name);
+                }
+            });
+        }
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+        hook.finish();
+    }
+
+    std::string lines = read_file(log);
+    CHECK(std::count(lines.begin(), lines.end(), '\n') == 100);
+    CHECK(lines.find("\"source\":\"/in/3-24\"") != std::string::npos);
+}
+
+#endif
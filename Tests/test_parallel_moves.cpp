@@ -0,0 +1,127 @@
+#include "test_support.hpp"
+#include "category_shards.hpp"
+#include "organizer.hpp"
+
+/*
+    =========================================================
+        Parallel moves (execution_threads > 1)
+    =========================================================
+*/
+
+static const char* EXTENSIONS[] = {"txt", "jpg", "mp3"};
+
+/*
+    folders × files_per_folder loose files with unique contents,
+    spread over three categories.
+*/
+static void make_flat_tree(const std::filesystem::path& root, int folders, int files_per_folder)
+{
+    for (int folder = 0; folder < folders; folder++)
+    {
+        for (int file = 0; file < files_per_folder; file++)
+        {
+            std::string name = "f" + std::to_string(file) + "." + EXTENSIONS[file % 3];
+            std::string folder_name = "d" + std::to_string(folder);
+            write_file(root / folder_name / name, folder_name + "/" + name);
+        }
+    }
+}
+
+/*
+    True if every file sits in a category folder ("d3/Image Files/x.jpg")
+    or one of its shards ("d3/Image Files/shard-2a/x.jpg").
+*/
+static bool all_in_category_folders(const std::map<std::string, std::string>& layout)
+{
+    for (const std::pair<const std::string, std::string>& entry : layout)
+    {
+        std::filesystem::path relative(entry.second);
+        std::filesystem::path folder = relative.parent_path();
+
+        if (is_shard_folder_name(folder.filename().string()))
+        {
+            folder = folder.parent_path();
+        }
+
+        std::string category = folder.filename().string();
+        if (category != "Text Files" && category != "Image Files" && category != "Audio Files")
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void check_sharded_parallel_run(bool deterministic)
+{
+    scratch_directory root;
+    make_flat_tree(root.path(), 10, 50);
+
+    organize_options options;
+    options.shard.enabled = true;
+    options.shard.max_entries = 10;
+    options.execution_threads = 4;
+    options.deterministic_collisions = deterministic;
+
+    organize_status status = organize_directory(root.path().string(), transfer_mode::atomic_transfer_mode, options);
+    CHECK(status == organize_status::success);
+
+    std::map<std::string, std::string> layout = layout_by_contents(root.path());
+    CHECK(layout.size() == 500);
+    CHECK(all_in_category_folders(layout));
+
+    // A second run finds nothing to do
+    CHECK(organize_directory(root.path().string(), transfer_mode::atomic_transfer_mode, options) == organize_status::success);
+    CHECK(layout_by_contents(root.path()) == layout);
+}
+
+/*
+    Shard folders and their category folder are owned by different
+    workers; a shard's worker may run before its category folder exists.
+*/
+TEST_CASE(sharded_parallel_run_deterministic)
+{
+    check_sharded_parallel_run(true);
+}
+
+TEST_CASE(sharded_parallel_run_shared_registry)
+{
+    check_sharded_parallel_run(false);
+}
+
+/*
+    Deterministic numbering: colliding files are numbered by source
+    path, identically whatever the thread count.
+*/
+TEST_CASE(deterministic_numbering_ignores_thread_count)
+{
+    std::map<std::string, std::string> layouts[2];
+    unsigned thread_counts[2] = {1, 4};
+
+    for (int i = 0; i < 2; i++)
+    {
+        scratch_directory root;
+
+        // "photo.jpg" in eight places that all end up in the same Image Files
+        for (int copy = 0; copy < 8; copy++)
+        {
+            write_file(root.path() / ("Text Files/n" + std::to_string(copy)) / "photo.jpg", "photo " + std::to_string(copy));
+        }
+        for (int copy = 0; copy < 8; copy++)
+        {
+            write_file(root.path() / ("Text Files/n" + std::to_string(copy)) / "note.txt", "note " + std::to_string(copy));
+        }
+        write_file(root.path() / "photo.jpg", "loose photo");
+
+        organize_options options;
+        options.execution_threads = thread_counts[i];
+        options.order = execution_order::destination_order;
+        options.deterministic_collisions = true;
+
+        CHECK(organize_directory(root.path().string(), transfer_mode::atomic_transfer_mode, options) == organize_status::success);
+        layouts[i] = layout_by_contents(root.path());
+    }
+
+    CHECK(layouts[0].size() == 17);
+    CHECK(layouts[0] == layouts[1]);
+}
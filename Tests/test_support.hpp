@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+    ===============================
+        test_support.hpp
+    ===============================
+
+    Minimal test harness for the organizer core.
+
+    The core (everything but the GUI) does not use Qt, so the tests do
+    not either: they build wherever the core builds, with nothing but
+    the C++ standard library. Tests.pro builds them with qmake.
+
+    Writing a test:
+
+        TEST_CASE(shards_survive_parallel_moves)
+        {
+            scratch_directory root;
+            ...
+            CHECK(status == organize_status::success);
+        }
+
+    A failed CHECK is reported with its file and line; the test goes
+    on, so one run shows every broken expectation.
+*/
+
+
+struct test_case
+{
+    const char* name;
+    void (*run)();
+};
+
+// Every TEST_CASE of the binary, in registration order
+std::vector<test_case>& registered_tests();
+
+struct test_registration
+{
+    test_registration(const char* name, void (*run)());
+};
+
+#define TEST_CASE(name)                                                 \
+    static void name();                                                 \
+    static test_registration name##_registration(#name, name);          \
+    static void name()
+
+#define CHECK(condition) check_condition((condition), #condition, __FILE__, __LINE__)
+
+void check_condition(bool passed, const char* expression, const char* file, int line);
+
+
+/*
+    scratch_directory
+    -----------------
+    Fresh empty directory under the system temp directory,
+    removed with everything in it when the object goes away.
+*/
+class scratch_directory
+{
+public:
+    scratch_directory();
+    ~scratch_directory();
+
+    scratch_directory(const scratch_directory&) = delete;
+    scratch_directory& operator=(const scratch_directory&) = delete;
+
+    const std::filesystem::path& path() const;
+
+private:
+    std::filesystem::path directory;
+};
+
+
+// Creates the parent folders as needed
+void write_file(const std::filesystem::path& file_path, const std::string& contents);
+
+std::string read_file(const std::filesystem::path& file_path);
+
+/*
+    Contents → path relative to root, for every regular file outside
+    hidden folders. With unique contents this is the tree's layout,
+    whatever names the files ended up with.
+*/
+std::map<std::string, std::string> layout_by_contents(const std::filesystem::path& root);
@@ -0,0 +1,48 @@
+# Tests of the organizer core (no Qt modules: the core does not use them)
+#
+#   cd Tests && qmake && make && ./organizer_tests
+
+TEMPLATE = app
+TARGET = organizer_tests
+
+CONFIG += console c++23
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += ../Headers
+
+SOURCES += \
+    ../Sources/archive_explode.cpp \
+    ../Sources/category_shards.cpp \
+    ../Sources/cold_tier.cpp \
+    ../Sources/content_hash_cache.cpp \
+    ../Sources/decision_queue.cpp \
+    ../Sources/directory_index.cpp \
+    ../Sources/extensions.cpp \
+    ../Sources/fanotify_watcher.cpp \
+    ../Sources/filename_sanitizer.cpp \
+    ../Sources/filesystem_utils.cpp \
+    ../Sources/job_priority.cpp \
+    ../Sources/layout_learner.cpp \
+    ../Sources/memory_governor.cpp \
+    ../Sources/move_hook.cpp \
+    ../Sources/move_plan.cpp \
+    ../Sources/organizer.cpp \
+    ../Sources/partitioned_scan.cpp \
+    ../Sources/resumable_copy.cpp \
+    ../Sources/rule_simulator.cpp \
+    ../Sources/run_estimator.cpp \
+    ../Sources/run_metrics.cpp \
+    ../Sources/scan_batch.cpp \
+    ../Sources/tree_snapshot.cpp \
+    test_cold_tier.cpp \
+    test_directory_index.cpp \
+    test_main.cpp \
+    test_memory_governor.cpp \
+    test_move_hook.cpp \
+    test_parallel_moves.cpp
+
+HEADERS += \
+    test_support.hpp
+
+# zlib: gzip and zip inflation (archive_explode.cpp)
+unix: LIBS += -lz -lpthread